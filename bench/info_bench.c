@@ -0,0 +1,849 @@
+/**
+ * @file    info_bench.c
+ * @brief   micro-benchmark of info module kernels
+ *
+ * Standalone executable, built when cmake option INFO_BUILD_BENCHMARK is ON.
+ *
+ * Each kernel is run on synthetic images (flat background, noise and a
+ * gaussian spot at the center) of every integer and floating point
+ * datatype, over a sweep of image sizes and thread counts.
+ * Reported per run :
+ * - ns/pix  : median time per call divided by number of pixels
+ * - GB/s    : input image bytes read per second
+ * - speedup : relative to the first thread count of the sweep
+ *
+ * Usage :
+ *   milkinfo-bench [-k kernel,...] [-d type,...] [-s size,...]
+ *                  [-t nbthread,...] [-T mintime] [-l]
+ *
+ * Compare output before and after vectorization or threading changes, on
+ * the same host, with the same options.
+ */
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "CommandLineInterface/CLIcore.h"
+
+#include "info/brightpix.h"
+#include "info/histogram.h"
+#include "info/imbackground.h"
+#include "info/imcenter.h"
+#include "info/impolar.h"
+#include "info/improfile_binmap.h"
+#include "info/imstats.h"
+#include "info/info_pool.h"
+#include "info/printpix.h"
+#include "info/structfunc.h"
+
+#define BENCH_MAXSIZES   16
+#define BENCH_MAXTHREADS 16
+#define BENCH_MAXREP     1000
+
+#define BENCH_HIST_NBBIN 1024
+#define BENCH_TOPK       100
+#define BENCH_TILESIZE   64
+#define BENCH_PROF_STEP  1.0
+#define BENCH_CUBE_NBSLICE 16 // cube kernels : frame viewed as 16 slices
+
+// work buffers shared by kernels, sized for largest image of the sweep
+typedef struct
+{
+    IMHISTOGRAM      histo;
+    IMPIXVAL        *pixarray;  // [BENCH_TOPK]
+    float           *outarray;  // kernel output
+    float           *outarray1; // second kernel output
+    PROFILE_BINSTAT *binstat;   // [nb_step max]
+    double          *dist;      // [nb_step max]
+    int              fdnull;
+} BENCH_WORK;
+
+typedef struct
+{
+    const char *name;
+    const char *descr;
+    uint32_t    maxsize;  // largest image size run, 0 if no limit
+    uint8_t     datatype; // only run for this datatype, 0 for all
+    errno_t (*run)(IMAGE *image, BENCH_WORK *work);
+} BENCH_KERNEL;
+
+static long bench_nbstep(IMAGE *image)
+{
+    uint32_t xsize = image->md[0].size[0];
+    uint32_t ysize = image->md[0].size[1];
+
+    return (long)(0.5 * sqrt((double) xsize * xsize + (double) ysize * ysize) /
+                  BENCH_PROF_STEP) +
+           1;
+}
+
+// ==========================================
+// Kernels
+// ==========================================
+
+static errno_t bench_minmax(IMAGE *image, BENCH_WORK *work)
+{
+    (void) work;
+    double min, max;
+
+    return image_minmax(image, &min, &max);
+}
+
+static errno_t bench_imstats(IMAGE *image, BENCH_WORK *work)
+{
+    (void) work;
+    IMSTATS imstats;
+
+    return imstats_compute(image, &imstats);
+}
+
+static errno_t bench_percentile(IMAGE *image, BENCH_WORK *work)
+{
+    // same percentiles as imstats command
+    double percarray[12] = {0.01,
+                            0.05,
+                            0.10,
+                            0.20,
+                            0.50,
+                            0.80,
+                            0.90,
+                            0.95,
+                            0.99,
+                            0.995,
+                            0.998,
+                            0.999
+                           };
+    double valarray[12];
+    (void) work;
+
+    return image_percentiles(image, 12, percarray, valarray);
+}
+
+// 3D view of frame : BENCH_CUBE_NBSLICE slices of size/4 x size/4
+static IMAGE bench_cubeview(IMAGE *image, IMAGE_METADATA *md)
+{
+    IMAGE cube = *image;
+
+    *md         = image->md[0];
+    md->naxis   = 3;
+    md->size[0] = image->md[0].size[0] / 4;
+    md->size[1] = image->md[0].size[1] / 4;
+    md->size[2] = BENCH_CUBE_NBSLICE;
+    cube.md     = md;
+
+    return cube;
+}
+
+static errno_t bench_cubestats(IMAGE *image, BENCH_WORK *work)
+{
+    (void) work;
+    IMAGE_METADATA md;
+    IMAGE          cube = bench_cubeview(image, &md);
+    IMSTATS        slicestats[BENCH_CUBE_NBSLICE];
+
+    return cube_slice_stats(&cube, NULL, slicestats);
+}
+
+static errno_t bench_cubecorr(IMAGE *image, BENCH_WORK *work)
+{
+    (void) work;
+    IMAGE_METADATA md;
+    IMAGE          cube = bench_cubeview(image, &md);
+    double         corrarray[BENCH_CUBE_NBSLICE];
+
+    return cube_slice_corr(&cube, NULL, BENCH_CUBE_NBSLICE, corrarray);
+}
+
+static errno_t bench_cubematch(IMAGE *image, BENCH_WORK *work)
+{
+    IMAGE_METADATA md;
+    IMAGE          cube = bench_cubeview(image, &md);
+
+    return cube_slice_matchmatrix(&cube, work->outarray);
+}
+
+// streamtiming statistics, frame values used as time intervals
+static errno_t bench_streamtiming(IMAGE *image, BENCH_WORK *work)
+{
+    double percarray[17] = {0.001, 0.01, 0.02, 0.05, 0.10, 0.20,
+                            0.30,  0.40, 0.50, 0.60, 0.70, 0.80,
+                            0.90,  0.95, 0.98, 0.99, 0.999
+                           };
+    double  valarray[17];
+    IMSTATS tdiffstats;
+    (void) work;
+
+    percentile_array(image->array.D,
+                     _DATATYPE_DOUBLE,
+                     image->md[0].nelement,
+                     17,
+                     percarray,
+                     valarray);
+    return imstats_array(image->array.D,
+                         _DATATYPE_DOUBLE,
+                         image->md[0].nelement,
+                         1,
+                         NULL,
+                         &tdiffstats);
+}
+
+static errno_t bench_histogram(IMAGE *image, BENCH_WORK *work)
+{
+    return image_histogram(image, &work->histo, 0);
+}
+
+static errno_t bench_countabove(IMAGE *image, BENCH_WORK *work)
+{
+    (void) work;
+    uint64_t count;
+    double   flux;
+
+    return image_count_above(image, 100.0, &count, &flux);
+}
+
+static errno_t bench_topk(IMAGE *image, BENCH_WORK *work)
+{
+    if(image_topk(image, BENCH_TOPK, work->pixarray) < 0)
+    {
+        return RETURN_FAILURE;
+    }
+    return RETURN_SUCCESS;
+}
+
+static errno_t bench_background(IMAGE *image, BENCH_WORK *work)
+{
+    (void) work;
+    IMBACKGROUND bkg;
+
+    return image_background(image, 3.0, 10, &bkg);
+}
+
+static errno_t bench_bkgmap(IMAGE *image, BENCH_WORK *work)
+{
+    return image_background_map(image,
+                                BENCH_TILESIZE,
+                                BENCH_TILESIZE,
+                                3.0,
+                                10,
+                                work->outarray,
+                                work->outarray1);
+}
+
+static errno_t bench_center(IMAGE *image, BENCH_WORK *work)
+{
+    (void) work;
+    double xcenter, ycenter;
+
+    return image_center_find(image,
+                             IMCENTER_MODE_CENTROID,
+                             5,
+                             0.0,
+                             0.0,
+                             0,
+                             &xcenter,
+                             &ycenter);
+}
+
+static errno_t bench_profile(IMAGE *image, BENCH_WORK *work)
+{
+    uint32_t xsize  = image->md[0].size[0];
+    uint32_t ysize  = image->md[0].size[1];
+    long     nbstep = bench_nbstep(image);
+
+    PROFILE_BINMAP *binmap = profile_binmap_get(xsize,
+                                                ysize,
+                                                0.5 * xsize,
+                                                0.5 * ysize,
+                                                BENCH_PROF_STEP,
+                                                nbstep,
+                                                NULL);
+    if(binmap == NULL)
+    {
+        return RETURN_FAILURE;
+    }
+    return profile_binmap_accumulate(binmap, image, work->binstat);
+}
+
+static errno_t bench_profiledirect(IMAGE *image, BENCH_WORK *work)
+{
+    uint32_t xsize = image->md[0].size[0];
+    uint32_t ysize = image->md[0].size[1];
+
+    return profile_accumulate_direct(image,
+                                     0.5 * xsize,
+                                     0.5 * ysize,
+                                     BENCH_PROF_STEP,
+                                     bench_nbstep(image),
+                                     NULL,
+                                     work->dist,
+                                     work->binstat);
+}
+
+static errno_t bench_polar(IMAGE *image, BENCH_WORK *work)
+{
+    uint32_t xsize = image->md[0].size[0];
+    uint32_t ysize = image->md[0].size[1];
+    uint32_t nr    = xsize / 2;
+
+    POLAR_MAP *polarmap = polar_map_get(xsize,
+                                        ysize,
+                                        0.5 * xsize,
+                                        0.5 * ysize,
+                                        1.0,
+                                        nr,
+                                        360,
+                                        2,
+                                        NULL);
+    if(polarmap == NULL)
+    {
+        return RETURN_FAILURE;
+    }
+    return polar_map_apply(polarmap, image, work->outarray);
+}
+
+static errno_t bench_structfunc(IMAGE *image, BENCH_WORK *work)
+{
+    STRUCTFUNC_PLAN *sfplan =
+        structfunc_plan_get(image->md[0].size[0], image->md[0].size[1], NULL);
+    if(sfplan == NULL)
+    {
+        return RETURN_FAILURE;
+    }
+    return structfunc_compute(sfplan, image, work->outarray, work->outarray1);
+}
+
+static errno_t bench_exportbin(IMAGE *image, BENCH_WORK *work)
+{
+    return image_export_fd(image,
+                           work->fdnull,
+                           PRINTPIX_MODE_BINARY,
+                           0,
+                           0,
+                           0,
+                           0,
+                           1,
+                           1,
+                           0);
+}
+
+static errno_t bench_exporttxt(IMAGE *image, BENCH_WORK *work)
+{
+    return image_export_fd(image,
+                           work->fdnull,
+                           PRINTPIX_MODE_TEXT,
+                           0,
+                           0,
+                           0,
+                           0,
+                           1,
+                           1,
+                           0);
+}
+
+static BENCH_KERNEL benchkernel[] =
+{
+    {"minmax", "image_minmax()", 0, 0, bench_minmax},
+    {"imstats", "imstats_compute()", 0, 0, bench_imstats},
+    {"percentile", "image_percentiles(), 12 values", 0, 0, bench_percentile},
+    {"cubestats", "cube_slice_stats()", 0, 0, bench_cubestats},
+    {"cubecorr", "cube_slice_corr()", 0, 0, bench_cubecorr},
+    {"cubematch", "cube_slice_matchmatrix()", 0, 0, bench_cubematch},
+    {
+        "streamtiming",
+        "timing percentiles and moments",
+        0,
+        _DATATYPE_DOUBLE,
+        bench_streamtiming
+    },
+    {"histogram", "image_histogram()", 0, 0, bench_histogram},
+    {"countabove", "image_count_above()", 0, 0, bench_countabove},
+    {"topk", "image_topk()", 0, 0, bench_topk},
+    {"background", "image_background()", 0, 0, bench_background},
+    {"bkgmap", "image_background_map()", 0, 0, bench_bkgmap},
+    {"center", "image_center_find()", 0, 0, bench_center},
+    {"profile", "profile_binmap_accumulate()", 0, 0, bench_profile},
+    {
+        "profiledirect",
+        "profile_accumulate_direct()",
+        0,
+        0,
+        bench_profiledirect
+    },
+    {"polar", "polar_map_apply()", 0, 0, bench_polar},
+    {"structfunc", "structfunc_compute()", 1024, 0, bench_structfunc},
+    {"exportbin", "image_export_fd() binary", 0, 0, bench_exportbin},
+    {"exporttxt", "image_export_fd() text", 0, 0, bench_exporttxt}
+};
+
+#define BENCH_NBKERNEL ((int) (sizeof(benchkernel) / sizeof(benchkernel[0])))
+
+static const uint8_t benchdatatype[] = {_DATATYPE_UINT8,
+                                        _DATATYPE_INT8,
+                                        _DATATYPE_UINT16,
+                                        _DATATYPE_INT16,
+                                        _DATATYPE_UINT32,
+                                        _DATATYPE_INT32,
+                                        _DATATYPE_UINT64,
+                                        _DATATYPE_INT64,
+                                        _DATATYPE_FLOAT,
+                                        _DATATYPE_DOUBLE};
+
+static const char *benchdatatypename[] =
+    {"UI8", "SI8", "UI16", "SI16", "UI32", "SI32", "UI64", "SI64", "F", "D"};
+
+#define BENCH_NBDATATYPE                                                       \
+    ((int) (sizeof(benchdatatype) / sizeof(benchdatatype[0])))
+
+// ==========================================
+// Synthetic images
+// ==========================================
+
+/**
+ * @brief Reference pattern in double precision
+ *
+ * Background 100, gaussian noise of sigma 10 (Box-Muller on a fixed seed),
+ * gaussian spot of amplitude 1000 at the center. Integer datatypes hold
+ * these values directly, except 8-bit types which use one tenth of them.
+ */
+static double *bench_pattern(uint32_t size)
+{
+    uint64_t nelement = (uint64_t) size * size;
+    double  *pattern  = (double *) malloc(sizeof(double) * nelement);
+    if(pattern == NULL)
+    {
+        PRINT_ERROR("malloc returns NULL pointer");
+        abort();
+    }
+
+    unsigned int seed   = 12345;
+    double       sig2   = 2.0 * (0.05 * size) * (0.05 * size);
+    double       center = 0.5 * size;
+
+    for(uint32_t jj = 0; jj < size; jj++)
+    {
+        for(uint32_t ii = 0; ii < size; ii++)
+        {
+            double u1 = (rand_r(&seed) + 1.0) / ((double) RAND_MAX + 2.0);
+            double u2 = rand_r(&seed) / ((double) RAND_MAX + 1.0);
+            double dx = ii - center;
+            double dy = jj - center;
+
+            pattern[(uint64_t) jj * size + ii] =
+                100.0 + 10.0 * sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2) +
+                1000.0 * exp(-(dx * dx + dy * dy) / sig2);
+        }
+    }
+
+    return pattern;
+}
+
+#define BENCH_FILL(arrayptr, ctype, scale)                                     \
+    do                                                                         \
+    {                                                                          \
+        for(uint64_t ii = 0; ii < nelement; ii++)                              \
+        {                                                                      \
+            (arrayptr)[ii] = (ctype) ((scale) * pattern[ii]);                  \
+        }                                                                      \
+    } while(0)
+
+static IMAGE *bench_image_create(uint32_t      size,
+                                 uint8_t       datatype,
+                                 const double *pattern)
+{
+    uint64_t nelement = (uint64_t) size * size;
+    IMAGE   *image    = (IMAGE *) calloc(1, sizeof(IMAGE));
+    if(image == NULL)
+    {
+        PRINT_ERROR("calloc returns NULL pointer");
+        abort();
+    }
+    image->md = (IMAGE_METADATA *) calloc(1, sizeof(IMAGE_METADATA));
+    if(image->md == NULL)
+    {
+        PRINT_ERROR("calloc returns NULL pointer");
+        abort();
+    }
+
+    snprintf(image->name, sizeof(image->name), "bench%u", size);
+    strcpy(image->md[0].name, image->name);
+    image->used              = 1;
+    image->md[0].naxis       = 2;
+    image->md[0].size[0]     = size;
+    image->md[0].size[1]     = size;
+    image->md[0].nelement    = nelement;
+    image->md[0].datatype    = datatype;
+    image->md[0].cnt0        = 1;
+
+    size_t bytesize =
+        (size_t) nelement * ImageStreamIO_typesize(datatype);
+    if(posix_memalign(&image->array.raw, 64, bytesize) != 0)
+    {
+        PRINT_ERROR("posix_memalign error");
+        abort();
+    }
+
+    switch(datatype)
+    {
+        case _DATATYPE_UINT8:
+            BENCH_FILL(image->array.UI8, uint8_t, 0.1);
+            break;
+        case _DATATYPE_INT8:
+            BENCH_FILL(image->array.SI8, int8_t, 0.1);
+            break;
+        case _DATATYPE_UINT16:
+            BENCH_FILL(image->array.UI16, uint16_t, 1.0);
+            break;
+        case _DATATYPE_INT16:
+            BENCH_FILL(image->array.SI16, int16_t, 1.0);
+            break;
+        case _DATATYPE_UINT32:
+            BENCH_FILL(image->array.UI32, uint32_t, 1.0);
+            break;
+        case _DATATYPE_INT32:
+            BENCH_FILL(image->array.SI32, int32_t, 1.0);
+            break;
+        case _DATATYPE_UINT64:
+            BENCH_FILL(image->array.UI64, uint64_t, 1.0);
+            break;
+        case _DATATYPE_INT64:
+            BENCH_FILL(image->array.SI64, int64_t, 1.0);
+            break;
+        case _DATATYPE_FLOAT:
+            BENCH_FILL(image->array.F, float, 1.0);
+            break;
+        case _DATATYPE_DOUBLE:
+            BENCH_FILL(image->array.D, double, 1.0);
+            break;
+    }
+
+    return image;
+}
+
+static void bench_image_free(IMAGE *image)
+{
+    free(image->array.raw);
+    free(image->md);
+    free(image);
+}
+
+// ==========================================
+// Timing
+// ==========================================
+
+static double bench_time()
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1.0e-9 * t.tv_nsec;
+}
+
+static int bench_cmpdouble(const void *a, const void *b)
+{
+    double da = *(const double *) a;
+    double db = *(const double *) b;
+
+    return (da > db) - (da < db);
+}
+
+/**
+ * @brief Median time per call
+ *
+ * One warm-up call (builds cached maps and plans), then calls repeated until
+ * mintime is reached, with at least 3 calls.
+ * Returns a negative value if the kernel fails.
+ */
+static double bench_run(BENCH_KERNEL *kernel,
+                        IMAGE        *image,
+                        BENCH_WORK   *work,
+                        double        mintime)
+{
+    static double tarray[BENCH_MAXREP];
+
+    if(kernel->run(image, work) != RETURN_SUCCESS)
+    {
+        return -1.0;
+    }
+
+    long   nbrep  = 0;
+    double tstart = bench_time();
+    while(nbrep < BENCH_MAXREP)
+    {
+        double t0 = bench_time();
+        kernel->run(image, work);
+        double t1       = bench_time();
+        tarray[nbrep++] = t1 - t0;
+
+        if((nbrep >= 3) && (t1 - tstart >= mintime))
+        {
+            break;
+        }
+    }
+
+    qsort(tarray, nbrep, sizeof(double), bench_cmpdouble);
+
+    return tarray[nbrep / 2];
+}
+
+// ==========================================
+// Command line options
+// ==========================================
+
+static int bench_selected(const char *list, const char *name)
+{
+    if(list == NULL)
+    {
+        return 1;
+    }
+
+    size_t len = strlen(name);
+    for(const char *p = list; p != NULL; p = strchr(p, ','))
+    {
+        if(*p == ',')
+        {
+            p++;
+        }
+        if((strncmp(p, name, len) == 0) &&
+           ((p[len] == ',') || (p[len] == '\0')))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int bench_parselist(const char *str, long *values, int nbmax)
+{
+    int   nb = 0;
+    char *endptr;
+
+    while((nb < nbmax) && (*str != '\0'))
+    {
+        long v = strtol(str, &endptr, 10);
+        if((endptr == str) || (v <= 0))
+        {
+            return -1;
+        }
+        values[nb++] = v;
+        str          = (*endptr == ',') ? endptr + 1 : endptr;
+    }
+    return nb;
+}
+
+static void bench_usage(const char *progname)
+{
+    printf("Usage: %s [options]\n", progname);
+    printf("  -k kernel,...    kernels (default: all)\n");
+    printf("  -d type,...      datatypes (default: all)\n");
+    printf("  -s size,...      image sizes, square (default: 64,256,1024,2048)\n");
+    printf("  -t nbthread,...  pool thread counts (default: 1,2,4,... up to max)\n");
+    printf("  -T mintime       minimum time per run [s] (default: 0.2)\n");
+    printf("  -l               list kernels\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const char *kernellist   = NULL;
+    const char *datatypelist = NULL;
+    long        sizearray[BENCH_MAXSIZES] = {64, 256, 1024, 2048};
+    int         nbsize                    = 4;
+    long        threadarray[BENCH_MAXTHREADS];
+    int         nbthread = 0;
+    double      mintime  = 0.2;
+    int         opt;
+
+    while((opt = getopt(argc, argv, "k:d:s:t:T:lh")) != -1)
+    {
+        switch(opt)
+        {
+            case 'k':
+                kernellist = optarg;
+                break;
+            case 'd':
+                datatypelist = optarg;
+                break;
+            case 's':
+                nbsize = bench_parselist(optarg, sizearray, BENCH_MAXSIZES);
+                break;
+            case 't':
+                nbthread =
+                    bench_parselist(optarg, threadarray, BENCH_MAXTHREADS);
+                break;
+            case 'T':
+                mintime = atof(optarg);
+                break;
+            case 'l':
+                for(int k = 0; k < BENCH_NBKERNEL; k++)
+                {
+                    printf("%-14s %s\n",
+                           benchkernel[k].name,
+                           benchkernel[k].descr);
+                }
+                return EXIT_SUCCESS;
+            default:
+                bench_usage(argv[0]);
+                return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if((nbsize < 1) || (nbthread < 0))
+    {
+        bench_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // default pool size : INFO_NBTHREAD, or number of CPUs available
+    int maxthread = info_pool_nbthread();
+    if(nbthread == 0)
+    {
+        for(long nt = 1; (nt < maxthread) && (nbthread < BENCH_MAXTHREADS - 1);
+            nt *= 2)
+        {
+            threadarray[nbthread++] = nt;
+        }
+        threadarray[nbthread++] = maxthread;
+    }
+
+    uint32_t sizemax = 0;
+    for(int s = 0; s < nbsize; s++)
+    {
+        if(sizearray[s] > sizemax)
+        {
+            sizemax = sizearray[s];
+        }
+    }
+
+    // work buffers
+    BENCH_WORK work;
+    uint64_t   nelementmax = (uint64_t) sizemax * sizemax;
+    uint64_t   nboutmax    = 4 * nelementmax; // structfunc output
+    long       nbstepmax   = (long)(sizemax / BENCH_PROF_STEP) + 2;
+
+    if(nboutmax < 180 * (uint64_t) sizemax) // polar output
+    {
+        nboutmax = 180 * (uint64_t) sizemax;
+    }
+
+    histogram_init(&work.histo,
+                   BENCH_HIST_NBBIN,
+                   HISTOGRAM_RANGE_AUTO,
+                   HISTOGRAM_BINS_LINEAR,
+                   0.0,
+                   0.0);
+    work.pixarray  = (IMPIXVAL *) malloc(sizeof(IMPIXVAL) * BENCH_TOPK);
+    work.outarray  = (float *) malloc(sizeof(float) * nboutmax);
+    work.outarray1 = (float *) malloc(sizeof(float) * nboutmax);
+    work.binstat =
+        (PROFILE_BINSTAT *) malloc(sizeof(PROFILE_BINSTAT) * nbstepmax);
+    work.dist = (double *) malloc(sizeof(double) * nbstepmax);
+    if((work.pixarray == NULL) || (work.outarray == NULL) ||
+       (work.outarray1 == NULL) || (work.binstat == NULL) ||
+       (work.dist == NULL))
+    {
+        PRINT_ERROR("malloc returns NULL pointer");
+        abort();
+    }
+    work.fdnull = open("/dev/null", O_WRONLY);
+    if(work.fdnull == -1)
+    {
+        PRINT_ERROR("cannot open /dev/null");
+        return EXIT_FAILURE;
+    }
+
+    printf("# %d thread(s) max, mintime %.3f s\n", maxthread, mintime);
+    printf("# %-13s %-5s %6s %4s %10s %9s %8s\n",
+           "kernel",
+           "type",
+           "size",
+           "thr",
+           "ns/pix",
+           "GB/s",
+           "speedup");
+
+    for(int s = 0; s < nbsize; s++)
+    {
+        uint32_t size     = (uint32_t) sizearray[s];
+        uint64_t nelement = (uint64_t) size * size;
+        double  *pattern  = bench_pattern(size);
+
+        for(int d = 0; d < BENCH_NBDATATYPE; d++)
+        {
+            if(!bench_selected(datatypelist, benchdatatypename[d]))
+            {
+                continue;
+            }
+
+            IMAGE *image =
+                bench_image_create(size, benchdatatype[d], pattern);
+            double bytesize =
+                (double) nelement * ImageStreamIO_typesize(benchdatatype[d]);
+
+            for(int k = 0; k < BENCH_NBKERNEL; k++)
+            {
+                BENCH_KERNEL *kernel = &benchkernel[k];
+
+                if(!bench_selected(kernellist, kernel->name))
+                {
+                    continue;
+                }
+                if((kernel->maxsize > 0) && (size > kernel->maxsize))
+                {
+                    continue;
+                }
+                if((kernel->datatype != 0) &&
+                        (kernel->datatype != benchdatatype[d]))
+                {
+                    continue;
+                }
+
+                double tref = 0.0;
+                for(int t = 0; t < nbthread; t++)
+                {
+                    info_pool_init((int) threadarray[t], NULL);
+                    double trun = bench_run(kernel, image, &work, mintime);
+                    if(trun < 0.0)
+                    {
+                        printf("  %-13s %-5s %6u %4ld %10s\n",
+                               kernel->name,
+                               benchdatatypename[d],
+                               size,
+                               threadarray[t],
+                               "FAILED");
+                        break;
+                    }
+                    if(t == 0)
+                    {
+                        tref = trun;
+                    }
+
+                    printf("  %-13s %-5s %6u %4ld %10.3f %9.3f %8.2f\n",
+                           kernel->name,
+                           benchdatatypename[d],
+                           size,
+                           threadarray[t],
+                           1.0e9 * trun / nelement,
+                           1.0e-9 * bytesize / trun,
+                           tref / trun);
+                    fflush(stdout);
+                }
+            }
+
+            bench_image_free(image);
+        }
+        free(pattern);
+    }
+
+    close(work.fdnull);
+    histogram_free(&work.histo);
+    free(work.pixarray);
+    free(work.outarray);
+    free(work.outarray1);
+    free(work.binstat);
+    free(work.dist);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,763 @@
+/**
+ * @file    brightpix.c
+ * @brief   threshold counts and brightest pixels
+ *
+ * Both operate directly on the image array, for all real datatypes,
+ * without copying or sorting the frame.
+ *
+ * Threshold counts compare pixels in their native type, so the loop
+ * vectorizes. Brightest pixels are selected with a bounded min-heap per
+ * task : most pixels cost a single comparison with the heap root. When K is
+ * a large fraction of the frame, the heaps would outgrow the frame itself :
+ * non-NaN pixels are then gathered in one array, partitioned around the
+ * K-th brightest, and only the K brightest are sorted.
+ */
+
+#include <math.h>
+#include <stdatomic.h>
+
+#include "CommandLineInterface/CLIcore.h"
+
+#include "brightpix.h"
+#include "info_instr.h"
+#include "info_pool.h"
+#include "info_scratch.h"
+
+// minimum number of pixels per thread
+#define BRIGHTPIX_NBPIX_THREAD 65536
+
+// per-task heaps are used while K * nbtask <= nelement / BRIGHTPIX_HEAPFRAC,
+// above that all pixels are gathered and selected
+#define BRIGHTPIX_HEAPFRAC 8
+
+// ==========================================
+// Command line interface wrapper function(s)
+// ==========================================
+
+static errno_t brighter_cli()
+{
+    if(CLI_checkarg(1, CLIARG_IMG) + CLI_checkarg(2, CLIARG_FLOAT64) == 0)
+    {
+        brighter(data.cmdargtoken[1].val.string, data.cmdargtoken[2].val.numf);
+        return CLICMD_SUCCESS;
+    }
+    else
+    {
+        return CLICMD_INVALID_ARG;
+    }
+}
+
+static errno_t img_nbpix_flux_cli()
+{
+    if(CLI_checkarg(1, CLIARG_IMG) + CLI_checkarg(2, CLIARG_INT64) == 0)
+    {
+        img_nbpix_flux(data.cmdargtoken[1].val.string,
+                       data.cmdargtoken[2].val.numl);
+        return CLICMD_SUCCESS;
+    }
+    else
+    {
+        return CLICMD_INVALID_ARG;
+    }
+}
+
+// ==========================================
+// Register CLI command(s)
+// ==========================================
+
+errno_t brightpix_addCLIcmd()
+{
+    RegisterCLIcommand("brighter",
+                       __FILE__,
+                       brighter_cli,
+                       "count pixels brighter than value",
+                       "<image> <value>",
+                       "brighter im1 1000.0",
+                       "long brighter(const char *ID_name, double value)");
+
+    RegisterCLIcommand("nbpixflux",
+                       __FILE__,
+                       img_nbpix_flux_cli,
+                       "brightest pixels and cumulative flux",
+                       "<image> <nbpix>",
+                       "nbpixflux im1 20",
+                       "errno_t img_nbpix_flux(const char *ID_name, long nbpix)");
+
+    return RETURN_SUCCESS;
+}
+
+// float types : strict comparison with threshold rounded down to vtype
+#define BRIGHTPIX_COUNT_FLT(arrayptr, vtype, nextafterfunc)                    \
+    do                                                                         \
+    {                                                                          \
+        vtype vthr = (vtype) threshold;                                        \
+        if((double) vthr > threshold)                                          \
+        {                                                                      \
+            vthr = nextafterfunc(vthr, -INFINITY);                             \
+        }                                                                      \
+        _Pragma("omp simd reduction(+:cnt) reduction(+:fluxsum)")              \
+        for(uint64_t ii = iistart; ii < iiend; ii++)                           \
+        {                                                                      \
+            vtype v     = (arrayptr)[ii];                                      \
+            int   above = (v > vthr);                                          \
+            cnt += above;                                                      \
+            fluxsum += above ? (double) v : 0.0;                               \
+        }                                                                      \
+    } while(0)
+
+// integer types : v > threshold is v >= floor(threshold) + 1
+#define BRIGHTPIX_COUNT_INT(arrayptr, vtype, vtypemin, vtypemax)               \
+    do                                                                         \
+    {                                                                          \
+        double vlowf = floor(threshold) + 1.0;                                 \
+        if(vlowf > (double) (vtypemax))                                        \
+        {                                                                      \
+            break;                                                             \
+        }                                                                      \
+        vtype vlow = (vtype) (vtypemin);                                       \
+        if(vlowf >= (double) (vtypemax))                                       \
+        {                                                                      \
+            vlow = (vtype) (vtypemax);                                         \
+        }                                                                      \
+        else if(vlowf > (double) (vtypemin))                                   \
+        {                                                                      \
+            vlow = (vtype) vlowf;                                              \
+        }                                                                      \
+        _Pragma("omp simd reduction(+:cnt) reduction(+:fluxsum)")              \
+        for(uint64_t ii = iistart; ii < iiend; ii++)                           \
+        {                                                                      \
+            vtype v     = (arrayptr)[ii];                                      \
+            int   above = (v >= vlow);                                         \
+            cnt += above;                                                      \
+            fluxsum += above ? (double) v : 0.0;                               \
+        }                                                                      \
+    } while(0)
+
+typedef struct
+{
+    IMAGE     *image;
+    double     threshold;
+    uint64_t   cnt[INFO_POOL_MAXTHREAD];
+    double     fluxsum[INFO_POOL_MAXTHREAD];
+    atomic_int ret;
+} BRIGHTPIX_COUNT_JOB;
+
+static void brightpix_count_task(void *arg, int task, int nbtask)
+{
+    BRIGHTPIX_COUNT_JOB *job       = (BRIGHTPIX_COUNT_JOB *) arg;
+    IMAGE               *image     = job->image;
+    double               threshold = job->threshold;
+    uint64_t             cnt       = 0;
+    double               fluxsum   = 0.0;
+    uint64_t             iistart;
+    uint64_t             iiend;
+
+    info_pool_range(image->md[0].nelement, task, nbtask, &iistart, &iiend);
+
+    switch(image->md[0].datatype)
+    {
+        case _DATATYPE_FLOAT:
+            BRIGHTPIX_COUNT_FLT(image->array.F, float, nextafterf);
+            break;
+        case _DATATYPE_DOUBLE:
+            BRIGHTPIX_COUNT_FLT(image->array.D, double, nextafter);
+            break;
+        case _DATATYPE_UINT8:
+            BRIGHTPIX_COUNT_INT(image->array.UI8, uint8_t, 0, UINT8_MAX);
+            break;
+        case _DATATYPE_INT8:
+            BRIGHTPIX_COUNT_INT(image->array.SI8, int8_t, INT8_MIN, INT8_MAX);
+            break;
+        case _DATATYPE_UINT16:
+            BRIGHTPIX_COUNT_INT(image->array.UI16, uint16_t, 0, UINT16_MAX);
+            break;
+        case _DATATYPE_INT16:
+            BRIGHTPIX_COUNT_INT(image->array.SI16,
+                                int16_t,
+                                INT16_MIN,
+                                INT16_MAX);
+            break;
+        case _DATATYPE_UINT32:
+            BRIGHTPIX_COUNT_INT(image->array.UI32, uint32_t, 0, UINT32_MAX);
+            break;
+        case _DATATYPE_INT32:
+            BRIGHTPIX_COUNT_INT(image->array.SI32,
+                                int32_t,
+                                INT32_MIN,
+                                INT32_MAX);
+            break;
+        case _DATATYPE_UINT64:
+            BRIGHTPIX_COUNT_INT(image->array.UI64, uint64_t, 0, UINT64_MAX);
+            break;
+        case _DATATYPE_INT64:
+            BRIGHTPIX_COUNT_INT(image->array.SI64,
+                                int64_t,
+                                INT64_MIN,
+                                INT64_MAX);
+            break;
+        default:
+            atomic_store(&job->ret, RETURN_FAILURE);
+            break;
+    }
+
+    job->cnt[task]     = cnt;
+    job->fluxsum[task] = fluxsum;
+}
+
+/**
+ * @brief Count pixels with value > threshold, and sum their values
+ *
+ * flux may be NULL. NaN pixels are never counted.
+ */
+errno_t image_count_above(IMAGE    *image,
+                          double    threshold,
+                          uint64_t *count,
+                          double   *flux)
+{
+    INFO_INSTR_SCOPE("image_count_above");
+
+    BRIGHTPIX_COUNT_JOB job;
+    int                 nbtask =
+        info_pool_nbtask(image->md[0].nelement, BRIGHTPIX_NBPIX_THREAD);
+
+    *count = 0;
+    if(flux != NULL)
+    {
+        *flux = 0.0;
+    }
+    if(isnan(threshold))
+    {
+        return RETURN_SUCCESS;
+    }
+
+    job.image     = image;
+    job.threshold = threshold;
+    atomic_init(&job.ret, RETURN_SUCCESS);
+
+    info_pool_run(nbtask, brightpix_count_task, &job);
+
+    if(atomic_load(&job.ret) != RETURN_SUCCESS)
+    {
+        PRINT_ERROR("datatype not supported");
+        return RETURN_FAILURE;
+    }
+
+    for(int task = 0; task < nbtask; task++)
+    {
+        *count += job.cnt[task];
+        if(flux != NULL)
+        {
+            *flux += job.fluxsum[task];
+        }
+    }
+
+    return RETURN_SUCCESS;
+}
+
+// heap order : among equal values, the larger index is the smaller element,
+// so that the selection does not depend on thread scheduling
+static inline int impixval_less(const IMPIXVAL *a, const IMPIXVAL *b)
+{
+    return (a->value < b->value) ||
+           ((a->value == b->value) && (a->index > b->index));
+}
+
+static inline void impixval_siftdown(IMPIXVAL *heap, long nheap, long k)
+{
+    IMPIXVAL tmp = heap[k];
+
+    for(;;)
+    {
+        long c = 2 * k + 1;
+        if(c >= nheap)
+        {
+            break;
+        }
+        if((c + 1 < nheap) && impixval_less(&heap[c + 1], &heap[c]))
+        {
+            c++;
+        }
+        if(!impixval_less(&heap[c], &tmp))
+        {
+            break;
+        }
+        heap[k] = heap[c];
+        k       = c;
+    }
+    heap[k] = tmp;
+}
+
+static inline void impixval_siftup(IMPIXVAL *heap, long k)
+{
+    IMPIXVAL tmp = heap[k];
+
+    while(k > 0)
+    {
+        long p = (k - 1) / 2;
+        if(!impixval_less(&tmp, &heap[p]))
+        {
+            break;
+        }
+        heap[k] = heap[p];
+        k       = p;
+    }
+    heap[k] = tmp;
+}
+
+// insert into min-heap of capacity K, keeping the K largest
+static inline void
+impixval_heap_offer(IMPIXVAL *heap, long *nheap, long K, IMPIXVAL *pv)
+{
+    if(*nheap < K)
+    {
+        heap[*nheap] = *pv;
+        impixval_siftup(heap, *nheap);
+        (*nheap)++;
+    }
+    else if(impixval_less(&heap[0], pv))
+    {
+        heap[0] = *pv;
+        impixval_siftdown(heap, K, 0);
+    }
+}
+
+// NaN fails v > heap root, and is skipped while filling
+#define BRIGHTPIX_TOPK(arrayptr)                                               \
+    do                                                                         \
+    {                                                                          \
+        for(uint64_t ii = iistart; ii < iiend; ii++)                           \
+        {                                                                      \
+            double v = (double) (arrayptr)[ii];                                \
+            if(nheap == K)                                                     \
+            {                                                                  \
+                if(!(v >= heap[0].value))                                      \
+                {                                                              \
+                    continue;                                                  \
+                }                                                              \
+            }                                                                  \
+            else if(isnan(v))                                                  \
+            {                                                                  \
+                continue;                                                      \
+            }                                                                  \
+            IMPIXVAL pv;                                                       \
+            pv.value = v;                                                      \
+            pv.index = ii;                                                     \
+            impixval_heap_offer(heap, &nheap, K, &pv);                         \
+        }                                                                      \
+    } while(0)
+
+typedef struct
+{
+    IMAGE     *image;
+    long       K;
+    IMPIXVAL  *heaparray; // K elements per task
+    long       nheap[INFO_POOL_MAXTHREAD];
+    atomic_int ret;
+} BRIGHTPIX_TOPK_JOB;
+
+static void brightpix_topk_task(void *arg, int task, int nbtask)
+{
+    BRIGHTPIX_TOPK_JOB *job   = (BRIGHTPIX_TOPK_JOB *) arg;
+    IMAGE              *image = job->image;
+    long                K     = job->K;
+    IMPIXVAL           *heap  = job->heaparray + task * K;
+    long                nheap = 0;
+    uint64_t            iistart;
+    uint64_t            iiend;
+
+    info_pool_range(image->md[0].nelement, task, nbtask, &iistart, &iiend);
+
+    switch(image->md[0].datatype)
+    {
+        case _DATATYPE_FLOAT:
+            BRIGHTPIX_TOPK(image->array.F);
+            break;
+        case _DATATYPE_DOUBLE:
+            BRIGHTPIX_TOPK(image->array.D);
+            break;
+        case _DATATYPE_UINT8:
+            BRIGHTPIX_TOPK(image->array.UI8);
+            break;
+        case _DATATYPE_INT8:
+            BRIGHTPIX_TOPK(image->array.SI8);
+            break;
+        case _DATATYPE_UINT16:
+            BRIGHTPIX_TOPK(image->array.UI16);
+            break;
+        case _DATATYPE_INT16:
+            BRIGHTPIX_TOPK(image->array.SI16);
+            break;
+        case _DATATYPE_UINT32:
+            BRIGHTPIX_TOPK(image->array.UI32);
+            break;
+        case _DATATYPE_INT32:
+            BRIGHTPIX_TOPK(image->array.SI32);
+            break;
+        case _DATATYPE_UINT64:
+            BRIGHTPIX_TOPK(image->array.UI64);
+            break;
+        case _DATATYPE_INT64:
+            BRIGHTPIX_TOPK(image->array.SI64);
+            break;
+        default:
+            atomic_store(&job->ret, RETURN_FAILURE);
+            break;
+    }
+
+    job->nheap[task] = nheap;
+}
+
+// non-NaN pixels of task range, packed at the start of the range
+#define BRIGHTPIX_GATHER(arrayptr)                                             \
+    do                                                                         \
+    {                                                                          \
+        for(uint64_t ii = iistart; ii < iiend; ii++)                           \
+        {                                                                      \
+            double v = (double) (arrayptr)[ii];                                \
+            if(!isnan(v))                                                      \
+            {                                                                  \
+                pixall[iistart + nkeep].value = v;                             \
+                pixall[iistart + nkeep].index = ii;                            \
+                nkeep++;                                                       \
+            }                                                                  \
+        }                                                                      \
+    } while(0)
+
+typedef struct
+{
+    IMAGE     *image;
+    IMPIXVAL  *pixall; // nelement elements
+    uint64_t   nkeep[INFO_POOL_MAXTHREAD];
+    atomic_int ret;
+} BRIGHTPIX_GATHER_JOB;
+
+static void brightpix_gather_task(void *arg, int task, int nbtask)
+{
+    BRIGHTPIX_GATHER_JOB *job    = (BRIGHTPIX_GATHER_JOB *) arg;
+    IMAGE                *image  = job->image;
+    IMPIXVAL             *pixall = job->pixall;
+    uint64_t              nkeep  = 0;
+    uint64_t              iistart;
+    uint64_t              iiend;
+
+    info_pool_range(image->md[0].nelement, task, nbtask, &iistart, &iiend);
+
+    switch(image->md[0].datatype)
+    {
+        case _DATATYPE_FLOAT:
+            BRIGHTPIX_GATHER(image->array.F);
+            break;
+        case _DATATYPE_DOUBLE:
+            BRIGHTPIX_GATHER(image->array.D);
+            break;
+        case _DATATYPE_UINT8:
+            BRIGHTPIX_GATHER(image->array.UI8);
+            break;
+        case _DATATYPE_INT8:
+            BRIGHTPIX_GATHER(image->array.SI8);
+            break;
+        case _DATATYPE_UINT16:
+            BRIGHTPIX_GATHER(image->array.UI16);
+            break;
+        case _DATATYPE_INT16:
+            BRIGHTPIX_GATHER(image->array.SI16);
+            break;
+        case _DATATYPE_UINT32:
+            BRIGHTPIX_GATHER(image->array.UI32);
+            break;
+        case _DATATYPE_INT32:
+            BRIGHTPIX_GATHER(image->array.SI32);
+            break;
+        case _DATATYPE_UINT64:
+            BRIGHTPIX_GATHER(image->array.UI64);
+            break;
+        case _DATATYPE_INT64:
+            BRIGHTPIX_GATHER(image->array.SI64);
+            break;
+        default:
+            atomic_store(&job->ret, RETURN_FAILURE);
+            break;
+    }
+
+    job->nkeep[task] = nkeep;
+}
+
+static inline void impixval_swap(IMPIXVAL *a, IMPIXVAL *b)
+{
+    IMPIXVAL tmp = *a;
+    *a           = *b;
+    *b           = tmp;
+}
+
+// partial selection : the K largest of pixarray[0..n-1] move to [0..K-1],
+// in no particular order
+static void impixval_select(IMPIXVAL *pixarray, uint64_t n, uint64_t K)
+{
+    uint64_t lo = 0;
+    uint64_t hi = n - 1;
+
+    while(hi > lo)
+    {
+        // median of three as pivot, moved to hi
+        uint64_t mid = lo + (hi - lo) / 2;
+        if(impixval_less(&pixarray[lo], &pixarray[mid]))
+        {
+            impixval_swap(&pixarray[lo], &pixarray[mid]);
+        }
+        if(impixval_less(&pixarray[lo], &pixarray[hi]))
+        {
+            impixval_swap(&pixarray[lo], &pixarray[hi]);
+        }
+        if(impixval_less(&pixarray[hi], &pixarray[mid]))
+        {
+            impixval_swap(&pixarray[hi], &pixarray[mid]);
+        }
+
+        // larger elements first
+        IMPIXVAL pivot = pixarray[hi];
+        uint64_t store = lo;
+        for(uint64_t i = lo; i < hi; i++)
+        {
+            if(impixval_less(&pivot, &pixarray[i]))
+            {
+                impixval_swap(&pixarray[i], &pixarray[store]);
+                store++;
+            }
+        }
+        impixval_swap(&pixarray[store], &pixarray[hi]);
+
+        if(store == K - 1)
+        {
+            return;
+        }
+        if(store > K - 1)
+        {
+            hi = store - 1;
+        }
+        else
+        {
+            lo = store + 1;
+        }
+    }
+}
+
+// decreasing value, ties in order of increasing index
+static int impixval_cmp_decreasing(const void *pa, const void *pb)
+{
+    const IMPIXVAL *a = (const IMPIXVAL *) pa;
+    const IMPIXVAL *b = (const IMPIXVAL *) pb;
+
+    if(impixval_less(b, a))
+    {
+        return -1;
+    }
+    return impixval_less(a, b) ? 1 : 0;
+}
+
+// image_topk() for large K : gather, select, sort
+static long image_topk_select(IMAGE *image, long K, IMPIXVAL *pixarray)
+{
+    uint64_t             nelement = image->md[0].nelement;
+    int                  nbtask =
+        info_pool_nbtask(nelement, BRIGHTPIX_NBPIX_THREAD);
+    uint64_t             nall = 0;
+    BRIGHTPIX_GATHER_JOB job;
+
+    size_t scratchmark = info_scratch_mark();
+    job.image          = image;
+    job.pixall = (IMPIXVAL *) info_scratch_alloc(sizeof(IMPIXVAL) * nelement);
+    atomic_init(&job.ret, RETURN_SUCCESS);
+
+    info_pool_run(nbtask, brightpix_gather_task, &job);
+
+    if(atomic_load(&job.ret) != RETURN_SUCCESS)
+    {
+        info_scratch_release(scratchmark);
+        PRINT_ERROR("datatype not supported");
+        return -1;
+    }
+
+    // pack task ranges
+    for(int task = 0; task < nbtask; task++)
+    {
+        uint64_t iistart;
+        uint64_t iiend;
+
+        info_pool_range(nelement, task, nbtask, &iistart, &iiend);
+        memmove(job.pixall + nall,
+                job.pixall + iistart,
+                sizeof(IMPIXVAL) * job.nkeep[task]);
+        nall += job.nkeep[task];
+    }
+
+    if((uint64_t) K > nall)
+    {
+        K = (long) nall;
+    }
+    if(K > 0)
+    {
+        impixval_select(job.pixall, nall, (uint64_t) K);
+        qsort(job.pixall, K, sizeof(IMPIXVAL), impixval_cmp_decreasing);
+        memcpy(pixarray, job.pixall, sizeof(IMPIXVAL) * K);
+    }
+
+    info_scratch_release(scratchmark);
+
+    return K;
+}
+
+/**
+ * @brief K brightest pixels
+ *
+ * pixarray must hold K elements. It is filled in order of decreasing value,
+ * ties in order of increasing pixel index. NaN pixels are ignored.
+ *
+ * @return number of pixels written, less than K if the image has fewer
+ * non-NaN pixels, -1 on error
+ */
+long image_topk(IMAGE *image, long K, IMPIXVAL *pixarray)
+{
+    INFO_INSTR_SCOPE("image_topk");
+
+    uint32_t           xsize    = image->md[0].size[0];
+    long               nheapall = 0;
+    BRIGHTPIX_TOPK_JOB job;
+    int                nbtask =
+        info_pool_nbtask(image->md[0].nelement, BRIGHTPIX_NBPIX_THREAD);
+
+    if(K < 1)
+    {
+        return 0;
+    }
+
+    if((uint64_t) K * nbtask > image->md[0].nelement / BRIGHTPIX_HEAPFRAC)
+    {
+        nheapall = image_topk_select(image, K, pixarray);
+        for(long n = 0; n < nheapall; n++)
+        {
+            pixarray[n].ii = pixarray[n].index % xsize;
+            pixarray[n].jj = pixarray[n].index / xsize;
+        }
+        return nheapall;
+    }
+
+    // private heaps
+    job.image     = image;
+    job.K         = K;
+    size_t scratchmark = info_scratch_mark();
+    job.heaparray =
+        (IMPIXVAL *) info_scratch_alloc(sizeof(IMPIXVAL) * K * nbtask);
+    atomic_init(&job.ret, RETURN_SUCCESS);
+
+    info_pool_run(nbtask, brightpix_topk_task, &job);
+
+    // merge into output array, used as heap
+    for(int task = 0; task < nbtask; task++)
+    {
+        for(long k = 0; k < job.nheap[task]; k++)
+        {
+            impixval_heap_offer(pixarray,
+                                &nheapall,
+                                K,
+                                &job.heaparray[task * K + k]);
+        }
+    }
+
+    info_scratch_release(scratchmark);
+
+    if(atomic_load(&job.ret) != RETURN_SUCCESS)
+    {
+        PRINT_ERROR("datatype not supported");
+        return -1;
+    }
+
+    // heap sort : smallest moves to end
+    for(long n = nheapall - 1; n > 0; n--)
+    {
+        IMPIXVAL tmp = pixarray[0];
+        pixarray[0]  = pixarray[n];
+        pixarray[n]  = tmp;
+        impixval_siftdown(pixarray, n, 0);
+    }
+
+    for(long n = 0; n < nheapall; n++)
+    {
+        pixarray[n].ii = pixarray[n].index % xsize;
+        pixarray[n].jj = pixarray[n].index / xsize;
+    }
+
+    return nheapall;
+}
+
+/**
+ * @brief Number of pixels brighter than value
+ */
+long brighter(const char *ID_name, double value)
+{
+    imageID  ID = image_ID(ID_name);
+    uint64_t cnt;
+
+    if(ID == -1)
+    {
+        PRINT_ERROR("image %s not found", ID_name);
+        return -1;
+    }
+
+    if(image_count_above(&data.image[ID], value, &cnt, NULL) != RETURN_SUCCESS)
+    {
+        return -1;
+    }
+
+    printf("brighter %lu   fainter %lu\n",
+           cnt,
+           data.image[ID].md[0].nelement - cnt);
+
+    return (long) cnt;
+}
+
+/**
+ * @brief Print brightest pixels, with cumulative flux
+ *
+ * Flux is accumulated from the brightest pixel down.
+ * All pixels are listed if nbpix < 1.
+ */
+errno_t img_nbpix_flux(const char *ID_name, long nbpix)
+{
+    imageID ID = image_ID(ID_name);
+
+    if(ID == -1)
+    {
+        PRINT_ERROR("image %s not found", ID_name);
+        return RETURN_FAILURE;
+    }
+
+    if((nbpix < 1) || ((uint64_t) nbpix > data.image[ID].md[0].nelement))
+    {
+        nbpix = data.image[ID].md[0].nelement;
+    }
+
+    IMPIXVAL *pixarray = (IMPIXVAL *) malloc(sizeof(IMPIXVAL) * nbpix);
+    if(pixarray == NULL)
+    {
+        PRINT_ERROR("malloc returns NULL pointer");
+        abort();
+    }
+
+    long NBpix = image_topk(&data.image[ID], nbpix, pixarray);
+
+    double flux = 0.0;
+    for(long n = 0; n < NBpix; n++)
+    {
+        flux += pixarray[n].value;
+        printf("%5ld  %5u %5u  %20.18e  %20.18e\n",
+               n,
+               pixarray[n].ii,
+               pixarray[n].jj,
+               pixarray[n].value,
+               flux);
+    }
+
+    free(pixarray);
+
+    return RETURN_SUCCESS;
+}
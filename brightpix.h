@@ -0,0 +1,30 @@
+/**
+ * @file    brightpix.h
+ */
+
+#ifndef _INFO_BRIGHTPIX_H
+#define _INFO_BRIGHTPIX_H
+
+// pixel value and position
+typedef struct
+{
+    double   value;
+    uint64_t index; // jj * xsize + ii
+    uint32_t ii;
+    uint32_t jj;
+} IMPIXVAL;
+
+errno_t image_count_above(IMAGE    *image,
+                          double    threshold,
+                          uint64_t *count,
+                          double   *flux);
+
+long image_topk(IMAGE *image, long K, IMPIXVAL *pixarray);
+
+long brighter(const char *ID_name, double value);
+
+errno_t img_nbpix_flux(const char *ID_name, long nbpix);
+
+errno_t brightpix_addCLIcmd();
+
+#endif
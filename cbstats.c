@@ -0,0 +1,287 @@
+/**
+ * @file    cbstats.c
+ * @brief   statistics over the last frames of a stream circular buffer
+ *
+ * Frames are read in place from the circular buffer (CBimdata), no copy.
+ * CBindex is the slot of the newest frame, and CBcycle the number of
+ * completed passes over the buffer : before the first wraparound only slots
+ * 0 to CBindex hold frames.
+ *
+ * The writer keeps filling the buffer during the computation. Frames are
+ * read oldest first, and the buffer position is read again at the end :
+ * frames the writer may have reached meanwhile are counted in nbtorn.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "info_core.h"
+
+#include "cbstats.h"
+#include "imstats.h"
+#include "info_instr.h"
+#include "info_pool.h"
+#include "info_scratch.h"
+#include "info_simd.h"
+
+// minimum number of pixel values (pixels x frames) per thread
+#define CBSTATS_NBPIX_THREAD 65536
+
+// buffer position, cycle and index of the same write
+static uint64_t cbstats_position(IMAGE *image, uint64_t *cycle, uint32_t *index)
+{
+    IMAGE_METADATA *md = image->md;
+
+    for(int i = 0; i < 4; i++)
+    {
+        *cycle = md[0].CBcycle;
+        *index = md[0].CBindex;
+        if(md[0].CBcycle == *cycle)
+        {
+            break;
+        }
+    }
+    return *cycle * md[0].CBsize + *index;
+}
+
+/**
+ * @brief Number of frames held in circular buffer of image, 0 if none
+ */
+long cbstats_nbslot(IMAGE *image)
+{
+    uint64_t cycle;
+    uint32_t index;
+
+    if((image->md[0].CBsize == 0) || (image->CBimdata == NULL))
+    {
+        return 0;
+    }
+    cbstats_position(image, &cycle, &index);
+
+    return (cycle > 0) ? (long) image->md[0].CBsize : (long) index + 1;
+}
+
+// per pixel sum and sum of squares over frames, into tmean and trms
+#define CBSTATS_TEMPORAL(type)                                                 \
+    do                                                                         \
+    {                                                                          \
+        for(long k = 0; k < job->nbslot; k++)                                  \
+        {                                                                      \
+            const type *frame = (const type *) job->slot[k];                   \
+            _Pragma("omp simd")                                                \
+            for(uint64_t ii = iistart; ii < iiend; ii++)                       \
+            {                                                                  \
+                double v = (double) frame[ii];                                 \
+                tmean[ii] += v;                                                \
+                trms[ii] += v * v;                                             \
+            }                                                                  \
+        }                                                                      \
+    } while(0)
+
+typedef struct
+{
+    uint8_t      datatype;
+    uint64_t     nelement;
+    long         nbslot;
+    const void **slot; // frame pointers, oldest first
+    double      *tmean;
+    double      *trms;
+} CBSTATS_JOB;
+
+INFO_SIMD_CLONES
+static void cbstats_temporal_task(void *arg, int task, int nbtask)
+{
+    CBSTATS_JOB *job = (CBSTATS_JOB *) arg;
+    double      *tmean = job->tmean;
+    double      *trms  = job->trms;
+    uint64_t     iistart;
+    uint64_t     iiend;
+
+    info_pool_range(job->nelement, task, nbtask, &iistart, &iiend);
+
+    memset(tmean + iistart, 0, sizeof(double) * (iiend - iistart));
+    memset(trms + iistart, 0, sizeof(double) * (iiend - iistart));
+
+    switch(job->datatype)
+    {
+        case _DATATYPE_FLOAT:
+            CBSTATS_TEMPORAL(float);
+            break;
+        case _DATATYPE_DOUBLE:
+            CBSTATS_TEMPORAL(double);
+            break;
+        case _DATATYPE_UINT8:
+            CBSTATS_TEMPORAL(uint8_t);
+            break;
+        case _DATATYPE_INT8:
+            CBSTATS_TEMPORAL(int8_t);
+            break;
+        case _DATATYPE_UINT16:
+            CBSTATS_TEMPORAL(uint16_t);
+            break;
+        case _DATATYPE_INT16:
+            CBSTATS_TEMPORAL(int16_t);
+            break;
+        case _DATATYPE_UINT32:
+            CBSTATS_TEMPORAL(uint32_t);
+            break;
+        case _DATATYPE_INT32:
+            CBSTATS_TEMPORAL(int32_t);
+            break;
+        case _DATATYPE_UINT64:
+            CBSTATS_TEMPORAL(uint64_t);
+            break;
+        case _DATATYPE_INT64:
+            CBSTATS_TEMPORAL(int64_t);
+            break;
+    }
+
+    double n = (double) job->nbslot;
+    for(uint64_t ii = iistart; ii < iiend; ii++)
+    {
+        double mean     = tmean[ii] / n;
+        double variance = trms[ii] / n - mean * mean;
+
+        tmean[ii] = mean;
+        trms[ii]  = (variance > 0.0) ? sqrt(variance) : 0.0;
+    }
+}
+
+/**
+ * @brief Statistics over the last nbslot frames of the circular buffer
+ *
+ * nbslot is reduced to the number of frames held, all of them if nbslot
+ * is 0. framestats receives the statistics of each frame, oldest first,
+ * and may be NULL. tmean and trms, nelement values each, receive the
+ * temporal mean and RMS of each pixel : both NULL to skip, as NaN values
+ * propagate to the pixel.
+ */
+errno_t cbstats_compute(IMAGE   *image,
+                        long     nbslot,
+                        IMSTATS *framestats,
+                        double  *tmean,
+                        double  *trms,
+                        CBSTATS *cbstats)
+{
+    INFO_INSTR_SCOPE("cbstats_compute");
+
+    IMAGE_METADATA *md       = image->md;
+    uint32_t        CBsize   = md[0].CBsize;
+    uint64_t        nelement = md[0].nelement;
+    size_t          framesize =
+        nelement * ImageStreamIO_typesize(md[0].datatype);
+    long            nbheld   = cbstats_nbslot(image);
+
+    memset(cbstats, 0, sizeof(CBSTATS));
+    if(nbheld == 0)
+    {
+        PRINT_ERROR("image %s has no circular buffer frame", md[0].name);
+        return RETURN_FAILURE;
+    }
+    if((nbslot <= 0) || (nbslot > nbheld))
+    {
+        nbslot = nbheld;
+    }
+
+    size_t       scratchmark = info_scratch_mark();
+    const void **slot =
+        (const void **) info_scratch_alloc(sizeof(void *) * nbslot);
+
+    uint64_t pos0 =
+        cbstats_position(image, &cbstats->CBcycle, &cbstats->CBindex);
+    cbstats->nbslot = nbslot;
+    for(long k = 0; k < nbslot; k++)
+    {
+        uint32_t back  = (uint32_t)(nbslot - 1 - k);
+        uint32_t index = (cbstats->CBindex + CBsize - back) % CBsize;
+
+        slot[k] = (const char *) image->CBimdata + (size_t) index * framesize;
+    }
+
+    // per-frame statistics, combined into total
+    IMSTATS *total = &cbstats->total;
+    total->min     = INFINITY;
+    total->max     = -INFINITY;
+    for(long k = 0; k < nbslot; k++)
+    {
+        IMSTATS fstats;
+
+        if(imstats_array(slot[k],
+                         md[0].datatype,
+                         md[0].size[0],
+                         (uint32_t)(nelement / md[0].size[0]),
+                         NULL,
+                         &fstats) != RETURN_SUCCESS)
+        {
+            info_scratch_release(scratchmark);
+            return RETURN_FAILURE;
+        }
+        if(framestats != NULL)
+        {
+            framestats[k] = fstats;
+        }
+        if(fstats.nelement == 0)
+        {
+            total->nbnan += fstats.nbnan;
+            continue;
+        }
+        if(fstats.min < total->min)
+        {
+            total->min   = fstats.min;
+            total->iimin = fstats.iimin;
+        }
+        if(fstats.max > total->max)
+        {
+            total->max   = fstats.max;
+            total->iimax = fstats.iimax;
+        }
+        total->nelement += fstats.nelement;
+        total->nbnan += fstats.nbnan;
+        total->total += fstats.total;
+        total->total2 += fstats.total2;
+    }
+    total->xbary = NAN;
+    total->ybary = NAN;
+    if(total->nelement > 0)
+    {
+        double n        = (double) total->nelement;
+        double variance = total->total2 / n -
+                          (total->total / n) * (total->total / n);
+
+        total->mean   = total->total / n;
+        total->rmsdev = (variance > 0.0) ? sqrt(variance) : 0.0;
+    }
+    else
+    {
+        total->min    = NAN;
+        total->max    = NAN;
+        total->mean   = NAN;
+        total->rmsdev = NAN;
+    }
+
+    if((tmean != NULL) && (trms != NULL))
+    {
+        CBSTATS_JOB job;
+
+        job.datatype = md[0].datatype;
+        job.nelement = nelement;
+        job.nbslot   = nbslot;
+        job.slot     = slot;
+        job.tmean    = tmean;
+        job.trms     = trms;
+        info_pool_run(info_pool_nbtask(nelement * nbslot, CBSTATS_NBPIX_THREAD),
+                      cbstats_temporal_task,
+                      &job);
+    }
+
+    // frames written meanwhile overwrite the oldest slots read
+    uint64_t cycle;
+    uint32_t index;
+    uint64_t pos1  = cbstats_position(image, &cycle, &index);
+    int64_t  nbtorn = (int64_t)(pos1 - pos0) + nbslot - CBsize;
+    cbstats->nbtorn = (nbtorn < 0) ? 0 : (nbtorn > nbslot) ? nbslot : nbtorn;
+
+    info_scratch_release(scratchmark);
+
+    return RETURN_SUCCESS;
+}
@@ -0,0 +1,29 @@
+/**
+ * @file    cbstats.h
+ * @brief   statistics over the last frames of a stream circular buffer
+ */
+
+#ifndef _INFO_CBSTATS_H
+#define _INFO_CBSTATS_H
+
+#include "imstats.h"
+
+typedef struct
+{
+    long     nbslot;  // frames used, oldest first in framestats
+    uint64_t CBcycle; // buffer position of newest frame
+    uint32_t CBindex;
+    long     nbtorn;  // oldest frames overwritten while being read
+    IMSTATS  total;   // all pixels of all frames, no barycenter
+} CBSTATS;
+
+long cbstats_nbslot(IMAGE *image);
+
+errno_t cbstats_compute(IMAGE   *image,
+                        long     nbslot,
+                        IMSTATS *framestats,
+                        double  *tmean,
+                        double  *trms,
+                        CBSTATS *cbstats);
+
+#endif
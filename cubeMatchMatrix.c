@@ -8,6 +8,8 @@
 #include "COREMOD_memory/COREMOD_memory.h"
 #include "COREMOD_tools/COREMOD_tools.h"
 
+#include "imstats.h"
+
 
 // ==========================================
 // Forward declaration(s)
@@ -91,47 +93,29 @@ imageID info_cubeMatchMatrix(const char *IDin_name, const char *IDout_name)
     {
         create_2Dimage_ID(IDout_name, zsize, zsize, &IDout);
 
-        fpout = fopen("outtest.txt", "w");
-        fclose(fpout);
-
         printf("Computing differences - cube size is %u %u   %lu\n",
                zsize,
                zsize,
                xysize);
-        printf("\n\n");
+        cube_slice_matchmatrix(&data.image[IDin], data.image[IDout].array.F);
+
+        fpout = fopen("outtest.txt", "w");
         for(kk1 = 0; kk1 < zsize; kk1++)
         {
-            printf("%4ld / %4u    \n", kk1, zsize);
-            fflush(stdout);
             for(kk2 = kk1 + 1; kk2 < zsize; kk2++)
             {
-                totv = 0.0;
-                for(unsigned long ii = 0; ii < xysize; ii++)
-                {
-                    v1 = (double) data.image[IDin].array.F[kk1 * xysize + ii];
-                    v2 = (double) data.image[IDin].array.F[kk2 * xysize + ii];
-                    v  = v1 - v2;
-                    totv += v * v;
-                    //						printf("   %5ld
-                    //%20f
-                    //-> %g\n", ii, (double) v, (double) totv);
-                }
-                printf("    %4ld %4ld   %g\n", kk1, kk2, (double) totv);
-
-                fpout = fopen("outtest.txt", "a");
+                totv = data.image[IDout].array.F[kk2 * zsize + kk1];
                 fprintf(fpout,
                         "%5ld  %20f  %5ld %5ld\n",
                         kk2 - kk1,
                         (double) totv,
                         kk1,
                         kk2);
-                fclose(fpout);
-
-                data.image[IDout].array.F[kk2 * zsize + kk1] = (float) totv;
             }
-
-            save_fits(IDout_name, "testout.fits");
         }
+        fclose(fpout);
+
+        save_fits(IDout_name, "testout.fits");
         printf("\n");
     }
     else
@@ -7,6 +7,8 @@
 
 #include "COREMOD_memory/COREMOD_memory.h"
 
+#include "imstats.h"
+
 
 // ==========================================
 // Forward declaration(s)
@@ -56,6 +58,7 @@ errno_t cubestats_addCLIcmd()
 }
 
 // mask pixel values are 0 or 1
+// mask is optional : all pixels are used if IDmask_name is not an image
 // prints:
 //		index
 //		min
@@ -64,111 +67,85 @@ errno_t cubestats_addCLIcmd()
 //		average
 //		tot power
 //		RMS
+// slice-to-slice correlation written to corr.txt
 imageID info_cubestats(const char *ID_name,
                        const char *IDmask_name,
                        const char *outfname)
 {
     imageID  ID, IDm;
-    float    min, max, tot, tot2;
-    uint64_t xysize;
+    IMAGE   *maskimage = NULL;
+    IMSTATS *slicestats;
     FILE    *fp;
-    int      init = 0;
-    float    mtot;
-    float    val;
+    double   mtot;
+    uint32_t zsize;
 
     int    COMPUTE_CORR = 1;
     long   kcmax        = 100;
-    double valn1, valn2, v1, v2, valxp, vcorr;
-    long   k1, k2, kc;
+    double corrarray[100];
 
     ID = image_ID(ID_name);
-    if(data.image[ID].md[0].naxis != 3)
+    if((ID == -1) || (data.image[ID].md[0].naxis != 3))
     {
-        printf("ERROR: info_cubestats requires 3D image\n");
-        exit(0);
+        PRINT_ERROR("info_cubestats requires 3D image");
+        return -1;
     }
+    zsize = data.image[ID].md[0].size[2];
 
     IDm = image_ID(IDmask_name);
+    if(IDm != -1)
+    {
+        IMSTATS maskstats;
 
-    xysize = data.image[ID].md[0].size[0] * data.image[ID].md[0].size[1];
+        maskimage = &data.image[IDm];
+        imstats_compute(maskimage, &maskstats);
+        mtot = maskstats.total;
+    }
+    else
+    {
+        mtot = 1.0 * data.image[ID].md[0].size[0] * data.image[ID].md[0].size[1];
+    }
 
-    mtot = 0.0;
-    for(unsigned long ii = 0; ii < xysize; ii++)
+    slicestats = (IMSTATS *) malloc(sizeof(IMSTATS) * zsize);
+    if(slicestats == NULL)
     {
-        mtot += data.image[IDm].array.F[ii];
+        PRINT_ERROR("malloc returns NULL pointer");
+        abort();
+    }
+
+    if(cube_slice_stats(&data.image[ID], maskimage, slicestats) !=
+            RETURN_SUCCESS)
+    {
+        free(slicestats);
+        return -1;
     }
 
     fp = fopen(outfname, "w");
-    for(unsigned long kk = 0; kk < data.image[ID].md[0].size[2]; kk++)
+    for(uint32_t kk = 0; kk < zsize; kk++)
     {
-        init = 0;
-        tot  = 0.0;
-        tot2 = 0.0;
-        for(unsigned long ii = 0; ii < xysize; ii++)
-        {
-            if(data.image[IDm].array.F[ii] > 0.5)
-            {
-                val = data.image[ID].array.F[kk * xysize + ii];
-                if(init == 0)
-                {
-                    init = 1;
-                    min  = val;
-                    max  = val;
-                }
-                if(val > max)
-                {
-                    max = val;
-                }
-                if(val < min)
-                {
-                    min = val;
-                }
-                tot += val;
-                tot2 += val * val;
-            }
-        }
+        double tot  = slicestats[kk].total;
+        double tot2 = slicestats[kk].total2;
+
         fprintf(fp,
                 "%5ld  %20f  %20f  %20f  %20f  %20f  %20f\n",
-                kk,
-                min,
-                max,
+                (long) kk,
+                slicestats[kk].min,
+                slicestats[kk].max,
                 tot,
                 tot / mtot,
                 tot2,
                 sqrt((tot2 - tot * tot / mtot) / mtot));
     }
     fclose(fp);
+    free(slicestats);
 
     if(COMPUTE_CORR == 1)
     {
+        cube_slice_corr(&data.image[ID], maskimage, kcmax, corrarray);
+
         fp = fopen("corr.txt", "w");
-        for(kc = 1; kc < kcmax; kc++)
+        for(long kc = 1; (kc < kcmax) && (kc < zsize); kc++)
         {
-            vcorr = 0.0;
-            for(unsigned long kk = 0;
-                    kk < (unsigned long)(data.image[ID].md[0].size[2] - kc);
-                    kk++)
-            {
-                k1    = kk;
-                k2    = kk + kc;
-                valn1 = 0.0;
-                valn2 = 0.0;
-                valxp = 0.0;
-                for(unsigned long ii = 0; ii < xysize; ii++)
-                {
-                    if(data.image[IDm].array.F[ii] > 0.5)
-                    {
-                        v1 = data.image[ID].array.F[k1 * xysize + ii];
-                        v2 = data.image[ID].array.F[k2 * xysize + ii];
-                        valn1 += v1 * v1;
-                        valn2 += v2 * v2;
-                        valxp += v1 * v2;
-                    }
-                }
-                vcorr += valxp / sqrt(valn1 * valn2);
-            }
-            vcorr /= data.image[ID].md[0].size[2] - kc;
-            fprintf(fp, "%3ld   %g\n", kc, vcorr);
+            fprintf(fp, "%3ld   %g\n", kc, corrarray[kc]);
         }
         fclose(fp);
     }
@@ -0,0 +1,551 @@
+/**
+ * @file    histogram.c
+ * @brief   image histogram engine
+ *
+ * Fixed or automatic range, linear or logarithmic bins, all real datatypes.
+ * Pixels are split between the threads of the worker pool, each task filling
+ * private bins that are merged at the end. Counts can be accumulated over successive frames.
+ */
+
+#include <math.h>
+#include <stdatomic.h>
+
+#include "CommandLineInterface/CLIcore.h"
+
+#include "COREMOD_memory/COREMOD_memory.h"
+
+#include "histogram.h"
+#include "info_instr.h"
+#include "info_pool.h"
+#include "info_scratch.h"
+#include "info_simd.h"
+
+// minimum number of pixels per thread
+#define HISTOGRAM_NBPIX_THREAD 65536
+
+// ==========================================
+// Forward declaration(s)
+// ==========================================
+
+errno_t make_histogram(const char *ID_name,
+                       const char *ID_out_name,
+                       double      min,
+                       double      max,
+                       long        nbsteps);
+
+// ==========================================
+// Command line interface wrapper function(s)
+// ==========================================
+
+static errno_t make_histogram_cli()
+{
+    if(CLI_checkarg(1, CLIARG_IMG) + CLI_checkarg(2, CLIARG_STR_NOT_IMG) +
+            CLI_checkarg(3, CLIARG_FLOAT64) + CLI_checkarg(4, CLIARG_FLOAT64) +
+            CLI_checkarg(5, CLIARG_INT64) ==
+            0)
+    {
+        make_histogram(data.cmdargtoken[1].val.string,
+                       data.cmdargtoken[2].val.string,
+                       data.cmdargtoken[3].val.numf,
+                       data.cmdargtoken[4].val.numf,
+                       data.cmdargtoken[5].val.numl);
+        return CLICMD_SUCCESS;
+    }
+    else
+    {
+        return CLICMD_INVALID_ARG;
+    }
+}
+
+// ==========================================
+// Register CLI command(s)
+// ==========================================
+
+errno_t histogram_addCLIcmd()
+{
+    RegisterCLIcommand("mkhisto",
+                       __FILE__,
+                       make_histogram_cli,
+                       "make histogram of image values",
+                       "<image> <output image> <min> <max> <nbsteps>",
+                       "mkhisto im1 im1h 0.0 1000.0 100",
+                       "errno_t make_histogram(const char *ID_name, const "
+                       "char *ID_out_name, double min, double max, long "
+                       "nbsteps)");
+
+    return RETURN_SUCCESS;
+}
+
+/**
+ * @brief Allocate histogram
+ *
+ * For HISTOGRAM_RANGE_AUTO, min and max are ignored and set by
+ * image_histogram().
+ */
+errno_t histogram_init(IMHISTOGRAM *histo,
+                       long         nbbin,
+                       int          rangemode,
+                       int          binmode,
+                       double       min,
+                       double       max)
+{
+    histo->nbbin     = nbbin;
+    histo->rangemode = rangemode;
+    histo->binmode   = binmode;
+    histo->min       = min;
+    histo->max       = max;
+
+    histo->count = (uint64_t *) calloc(nbbin, sizeof(uint64_t));
+    if(histo->count == NULL)
+    {
+        PRINT_ERROR("malloc returns NULL pointer");
+        abort();
+    }
+
+    histo->underflow = 0;
+    histo->overflow  = 0;
+    histo->nbsample  = 0;
+
+    return RETURN_SUCCESS;
+}
+
+void histogram_free(IMHISTOGRAM *histo)
+{
+    free(histo->count);
+    histo->count = NULL;
+}
+
+void histogram_reset(IMHISTOGRAM *histo)
+{
+    memset(histo->count, 0, sizeof(uint64_t) * histo->nbbin);
+    histo->underflow = 0;
+    histo->overflow  = 0;
+    histo->nbsample  = 0;
+}
+
+/**
+ * @brief Lower edge of bin, bin = nbbin gives upper edge of last bin
+ */
+double histogram_binedge(IMHISTOGRAM *histo, long bin)
+{
+    double x = 1.0 * bin / histo->nbbin;
+
+    if(histo->binmode == HISTOGRAM_BINS_LOG)
+    {
+        return histo->min * pow(histo->max / histo->min, x);
+    }
+    return histo->min + (histo->max - histo->min) * x;
+}
+
+#define IMAGE_MINMAX(arrayptr)                                                 \
+    do                                                                         \
+    {                                                                          \
+        _Pragma("omp simd reduction(min:vmin) reduction(max:vmax)")            \
+        for(uint64_t ii = iistart; ii < iiend; ii++)                           \
+        {                                                                      \
+            double v = (double) (arrayptr)[ii];                                \
+            vmin     = (v < vmin) ? v : vmin;                                  \
+            vmax     = (v > vmax) ? v : vmax;                                  \
+        }                                                                      \
+    } while(0)
+
+// min and max of elements [iistart, iiend)
+INFO_SIMD_CLONES
+static errno_t image_minmax_range(IMAGE   *image,
+                                  uint64_t iistart,
+                                  uint64_t iiend,
+                                  double  *min,
+                                  double  *max)
+{
+    double vmin = INFINITY;
+    double vmax = -INFINITY;
+
+    switch(image->md[0].datatype)
+    {
+        case _DATATYPE_FLOAT:
+            IMAGE_MINMAX(image->array.F);
+            break;
+        case _DATATYPE_DOUBLE:
+            IMAGE_MINMAX(image->array.D);
+            break;
+        case _DATATYPE_UINT8:
+            IMAGE_MINMAX(image->array.UI8);
+            break;
+        case _DATATYPE_INT8:
+            IMAGE_MINMAX(image->array.SI8);
+            break;
+        case _DATATYPE_UINT16:
+            IMAGE_MINMAX(image->array.UI16);
+            break;
+        case _DATATYPE_INT16:
+            IMAGE_MINMAX(image->array.SI16);
+            break;
+        case _DATATYPE_UINT32:
+            IMAGE_MINMAX(image->array.UI32);
+            break;
+        case _DATATYPE_INT32:
+            IMAGE_MINMAX(image->array.SI32);
+            break;
+        case _DATATYPE_UINT64:
+            IMAGE_MINMAX(image->array.UI64);
+            break;
+        case _DATATYPE_INT64:
+            IMAGE_MINMAX(image->array.SI64);
+            break;
+        default:
+            return RETURN_FAILURE;
+    }
+
+    *min = vmin;
+    *max = vmax;
+
+    return RETURN_SUCCESS;
+}
+
+typedef struct
+{
+    IMAGE     *image;
+    double     min[INFO_POOL_MAXTHREAD];
+    double     max[INFO_POOL_MAXTHREAD];
+    atomic_int ret;
+} IMAGE_MINMAX_JOB;
+
+static void image_minmax_task(void *arg, int task, int nbtask)
+{
+    IMAGE_MINMAX_JOB *job = (IMAGE_MINMAX_JOB *) arg;
+    uint64_t          iistart;
+    uint64_t          iiend;
+
+    info_pool_range(job->image->md[0].nelement, task, nbtask, &iistart, &iiend);
+    if(image_minmax_range(job->image,
+                          iistart,
+                          iiend,
+                          &job->min[task],
+                          &job->max[task]) != RETURN_SUCCESS)
+    {
+        atomic_store(&job->ret, RETURN_FAILURE);
+    }
+}
+
+/**
+ * @brief Min and max pixel values, NaN ignored
+ */
+errno_t image_minmax(IMAGE *image, double *min, double *max)
+{
+    INFO_INSTR_SCOPE("image_minmax");
+
+    IMAGE_MINMAX_JOB job;
+    int              nbtask =
+        info_pool_nbtask(image->md[0].nelement, HISTOGRAM_NBPIX_THREAD);
+
+    job.image = image;
+    atomic_init(&job.ret, RETURN_SUCCESS);
+
+    info_pool_run(nbtask, image_minmax_task, &job);
+
+    if(atomic_load(&job.ret) != RETURN_SUCCESS)
+    {
+        PRINT_ERROR("datatype not supported");
+        return RETURN_FAILURE;
+    }
+
+    *min = INFINITY;
+    *max = -INFINITY;
+    for(int task = 0; task < nbtask; task++)
+    {
+        *min = (job.min[task] < *min) ? job.min[task] : *min;
+        *max = (job.max[task] > *max) ? job.max[task] : *max;
+    }
+
+    return RETURN_SUCCESS;
+}
+
+// Binning is done in two passes over blocks of HISTOGRAM_BLOCKSIZE values :
+// bin indices are computed without branches (vectorized), then counted.
+// Counts array has 3 extra entries, receiving underflow, overflow and
+// ignored (NaN) values, so the counting pass has no branch either.
+#define HISTOGRAM_BLOCKSIZE 256
+
+// linear bins
+#define HISTOGRAM_BINVAL_LINEAR(v) (((v) - vmin) * scale)
+
+// logarithmic bins, values <= 0 are underflow, NaN is ignored
+#define HISTOGRAM_BINVAL_LOG(v)                                                \
+    (((v) > 0.0) ? (log(v) - logmin) * scale : (((v) <= 0.0) ? -1.0 : NAN))
+
+#define HISTOGRAM_BIN(arrayptr, BINVAL)                                        \
+    do                                                                         \
+    {                                                                          \
+        int32_t binindex[HISTOGRAM_BLOCKSIZE];                                 \
+        for(uint64_t ii0 = iistart; ii0 < iiend; ii0 += HISTOGRAM_BLOCKSIZE)   \
+        {                                                                      \
+            int nbval = (iiend - ii0 < HISTOGRAM_BLOCKSIZE)                    \
+                        ? (int)(iiend - ii0)                                   \
+                        : HISTOGRAM_BLOCKSIZE;                                 \
+            _Pragma("omp simd")                                                \
+            for(int i = 0; i < nbval; i++)                                     \
+            {                                                                  \
+                double  v  = (double) (arrayptr)[ii0 + i];                     \
+                double  x  = BINVAL(v);                                        \
+                int     in = (x >= 0.0) && (x < dnbbin);                       \
+                double  xin = in ? x : 0.0; /* no out-of-range conversion */   \
+                int32_t b  = binnan;                                           \
+                b          = (x >= dnbbin) ? binover : b;                      \
+                b          = (x < 0.0) ? binunder : b;                         \
+                b          = (v == vmax) ? binlast : b;                        \
+                b          = in ? (int32_t) xin : b;                           \
+                binindex[i] = b;                                               \
+            }                                                                  \
+            for(int i = 0; i < nbval; i++)                                     \
+            {                                                                  \
+                countpart[binindex[i]]++;                                      \
+            }                                                                  \
+        }                                                                      \
+    } while(0)
+
+#define HISTOGRAM_BIN_MODE(arrayptr)                                           \
+    do                                                                         \
+    {                                                                          \
+        if(logbins == 1)                                                       \
+        {                                                                      \
+            HISTOGRAM_BIN(arrayptr, HISTOGRAM_BINVAL_LOG);                     \
+        }                                                                      \
+        else                                                                   \
+        {                                                                      \
+            HISTOGRAM_BIN(arrayptr, HISTOGRAM_BINVAL_LINEAR);                  \
+        }                                                                      \
+    } while(0)
+
+// bin elements [iistart, iiend) into countpart[nbbin + 3]
+INFO_SIMD_CLONES
+static errno_t histogram_bin_range(IMAGE    *image,
+                                   uint64_t  iistart,
+                                   uint64_t  iiend,
+                                   long      nbbin,
+                                   int       logbins,
+                                   double    vmin,
+                                   double    vmax,
+                                   double    logmin,
+                                   double    scale,
+                                   uint64_t *countpart)
+{
+    double  dnbbin   = (double) nbbin;
+    int32_t binlast  = (int32_t)(nbbin - 1);
+    int32_t binunder = (int32_t) nbbin;
+    int32_t binover  = (int32_t)(nbbin + 1);
+    int32_t binnan   = (int32_t)(nbbin + 2);
+
+    switch(image->md[0].datatype)
+    {
+        case _DATATYPE_FLOAT:
+            HISTOGRAM_BIN_MODE(image->array.F);
+            break;
+        case _DATATYPE_DOUBLE:
+            HISTOGRAM_BIN_MODE(image->array.D);
+            break;
+        case _DATATYPE_UINT8:
+            HISTOGRAM_BIN_MODE(image->array.UI8);
+            break;
+        case _DATATYPE_INT8:
+            HISTOGRAM_BIN_MODE(image->array.SI8);
+            break;
+        case _DATATYPE_UINT16:
+            HISTOGRAM_BIN_MODE(image->array.UI16);
+            break;
+        case _DATATYPE_INT16:
+            HISTOGRAM_BIN_MODE(image->array.SI16);
+            break;
+        case _DATATYPE_UINT32:
+            HISTOGRAM_BIN_MODE(image->array.UI32);
+            break;
+        case _DATATYPE_INT32:
+            HISTOGRAM_BIN_MODE(image->array.SI32);
+            break;
+        case _DATATYPE_UINT64:
+            HISTOGRAM_BIN_MODE(image->array.UI64);
+            break;
+        case _DATATYPE_INT64:
+            HISTOGRAM_BIN_MODE(image->array.SI64);
+            break;
+        default:
+            return RETURN_FAILURE;
+    }
+
+    return RETURN_SUCCESS;
+}
+
+typedef struct
+{
+    IMAGE     *image;
+    long       nbbin;
+    int        logbins;
+    double     vmin;
+    double     vmax;
+    double     logmin;
+    double     scale;
+    uint64_t  *countpart; // nbbin + 3 counts per task
+    atomic_int ret;
+} HISTOGRAM_JOB;
+
+static void histogram_task(void *arg, int task, int nbtask)
+{
+    HISTOGRAM_JOB *job = (HISTOGRAM_JOB *) arg;
+    uint64_t       iistart;
+    uint64_t       iiend;
+
+    info_pool_range(job->image->md[0].nelement, task, nbtask, &iistart, &iiend);
+    if(histogram_bin_range(job->image,
+                           iistart,
+                           iiend,
+                           job->nbbin,
+                           job->logbins,
+                           job->vmin,
+                           job->vmax,
+                           job->logmin,
+                           job->scale,
+                           job->countpart + task * (job->nbbin + 3)) !=
+            RETURN_SUCCESS)
+    {
+        atomic_store(&job->ret, RETURN_FAILURE);
+    }
+}
+
+/**
+ * @brief Compute histogram of image values
+ *
+ * If accumulate is 0, counts are reset before binning. Otherwise counts are
+ * added to the existing ones, for accumulation over frames. With automatic
+ * range and accumulate = 1, the range is only set on the first call (when
+ * the histogram is empty), so that bins stay consistent between frames.
+ */
+errno_t image_histogram(IMAGE *image, IMHISTOGRAM *histo, int accumulate)
+{
+    INFO_INSTR_SCOPE("image_histogram");
+
+    long   nbbin   = histo->nbbin;
+    int    logbins = (histo->binmode == HISTOGRAM_BINS_LOG) ? 1 : 0;
+    double vmin;
+    double   vmax;
+    double scale;
+    double logmin = 0.0;
+
+    if(accumulate == 0)
+    {
+        histogram_reset(histo);
+    }
+
+    if((histo->rangemode == HISTOGRAM_RANGE_AUTO) && (histo->nbsample == 0))
+    {
+        FUNC_CHECK_RETURN(image_minmax(image, &histo->min, &histo->max));
+        if((logbins == 1) && (histo->min <= 0.0))
+        {
+            // smallest positive value unknown, use 6 decades below max
+            histo->min = 1.0e-6 * histo->max;
+        }
+    }
+
+    vmin = histo->min;
+    vmax = histo->max;
+    if(logbins == 1)
+    {
+        if((vmin <= 0.0) || (vmax <= vmin))
+        {
+            PRINT_ERROR("invalid log histogram range %g %g", vmin, vmax);
+            return RETURN_FAILURE;
+        }
+        logmin = log(vmin);
+        scale  = nbbin / (log(vmax) - logmin);
+    }
+    else
+    {
+        if(vmax > vmin)
+        {
+            scale = nbbin / (vmax - vmin);
+        }
+        else
+        {
+            // empty range : only values equal to min are binned (bin 0)
+            scale = 1.0e300;
+        }
+    }
+
+    HISTOGRAM_JOB job;
+    int nbtask = info_pool_nbtask(image->md[0].nelement, HISTOGRAM_NBPIX_THREAD);
+
+    job.image   = image;
+    job.nbbin   = nbbin;
+    job.logbins = logbins;
+    job.vmin    = vmin;
+    job.vmax    = vmax;
+    job.logmin  = logmin;
+    job.scale   = scale;
+    atomic_init(&job.ret, RETURN_SUCCESS);
+
+    // private bins of each task, followed by underflow, overflow and NaN
+    size_t scratchmark = info_scratch_mark();
+    job.countpart      = (uint64_t *) info_scratch_calloc(nbtask * (nbbin + 3),
+                                                          sizeof(uint64_t));
+
+    info_pool_run(nbtask, histogram_task, &job);
+
+    for(int task = 0; task < nbtask; task++)
+    {
+        uint64_t *countpart = job.countpart + task * (nbbin + 3);
+
+        for(long b = 0; b < nbbin; b++)
+        {
+            histo->count[b] += countpart[b];
+            histo->nbsample += countpart[b];
+        }
+        histo->underflow += countpart[nbbin];
+        histo->overflow += countpart[nbbin + 1];
+        histo->nbsample += countpart[nbbin] + countpart[nbbin + 1];
+    }
+
+    info_scratch_release(scratchmark);
+
+    if(atomic_load(&job.ret) != RETURN_SUCCESS)
+    {
+        PRINT_ERROR("datatype not supported");
+        return RETURN_FAILURE;
+    }
+
+    return RETURN_SUCCESS;
+}
+
+/**
+ * @brief Histogram of image values into 1D image of size nbsteps
+ *
+ * Linear bins over [min, max]. Values outside range are ignored.
+ */
+errno_t make_histogram(const char *ID_name,
+                       const char *ID_out_name,
+                       double      min,
+                       double      max,
+                       long        nbsteps)
+{
+    imageID     ID, ID_out;
+    IMHISTOGRAM histo;
+
+    ID = image_ID(ID_name);
+
+    FUNC_CHECK_RETURN(create_2Dimage_ID(ID_out_name, nbsteps, 1, &ID_out));
+
+    histogram_init(&histo,
+                   nbsteps,
+                   HISTOGRAM_RANGE_FIXED,
+                   HISTOGRAM_BINS_LINEAR,
+                   min,
+                   max);
+
+    image_histogram(&data.image[ID], &histo, 0);
+
+    for(long n = 0; n < nbsteps; n++)
+    {
+        data.image[ID_out].array.F[n] = (float) histo.count[n];
+    }
+
+    histogram_free(&histo);
+
+    return RETURN_SUCCESS;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file    histogram.h
+ */
+
+#ifndef _INFO_HISTOGRAM_H
+#define _INFO_HISTOGRAM_H
+
+#define HISTOGRAM_RANGE_FIXED 0 // use min and max from IMHISTOGRAM
+#define HISTOGRAM_RANGE_AUTO  1 // set min and max from image
+
+#define HISTOGRAM_BINS_LINEAR 0
+#define HISTOGRAM_BINS_LOG    1 // requires min > 0
+
+typedef struct
+{
+    long nbbin;
+    int  rangemode;
+    int  binmode;
+
+    // range, values equal to max are counted in last bin
+    double min;
+    double max;
+
+    uint64_t *count; // [nbbin]
+    uint64_t  underflow;
+    uint64_t  overflow;
+    uint64_t  nbsample; // number of values binned, excluding NaN
+} IMHISTOGRAM;
+
+errno_t histogram_init(IMHISTOGRAM *histo,
+                       long         nbbin,
+                       int          rangemode,
+                       int          binmode,
+                       double       min,
+                       double       max);
+
+void histogram_free(IMHISTOGRAM *histo);
+
+void histogram_reset(IMHISTOGRAM *histo);
+
+double histogram_binedge(IMHISTOGRAM *histo, long bin);
+
+errno_t image_minmax(IMAGE *image, double *min, double *max);
+
+errno_t image_histogram(IMAGE *image, IMHISTOGRAM *histo, int accumulate);
+
+errno_t make_histogram(const char *ID_name,
+                       const char *ID_out_name,
+                       double      min,
+                       double      max,
+                       long        nbsteps);
+
+errno_t histogram_addCLIcmd();
+
+#endif
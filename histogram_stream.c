@@ -0,0 +1,230 @@
+/**
+ * @file    histogram_stream.c
+ * @brief   histogram of image stream
+ *
+ * Output stream is 2D, size nbbin x 2, double :
+ *     row 0 : counts
+ *     row 1 : lower bin edge
+ *
+ * With .accumulate, counts are summed over frames, until .reset is set.
+ */
+
+#include <math.h>
+
+#include "CommandLineInterface/CLIcore.h"
+
+#include "COREMOD_memory/COREMOD_memory.h"
+
+#include "histogram.h"
+
+// Local variables pointers
+static char    *instreamname;
+static char    *outstreamname;
+static int64_t *nbbin;
+static double  *histmin;
+static double  *histmax;
+static int64_t *autorange;
+static int64_t *logbins;
+static int64_t *accumulate;
+static int64_t *resetcnt;
+
+static CLICMDARGDEF farg[] =
+{
+    {
+        CLIARG_IMG,
+        ".insname",
+        "input stream",
+        "im1",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &instreamname,
+        NULL
+    },
+    {
+        CLIARG_STR,
+        ".outsname",
+        "output histogram stream",
+        "im1histo",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &outstreamname,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".nbbin",
+        "number of bins",
+        "100",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &nbbin,
+        NULL
+    },
+    {
+        CLIARG_FLOAT64,
+        ".min",
+        "range min, ignored if autorange",
+        "0.0",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &histmin,
+        NULL
+    },
+    {
+        CLIARG_FLOAT64,
+        ".max",
+        "range max, ignored if autorange",
+        "1.0",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &histmax,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".autorange",
+        "range from image min/max (0/1)",
+        "0",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &autorange,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".logbins",
+        "logarithmic bins (0/1)",
+        "0",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &logbins,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".accumulate",
+        "accumulate counts over frames (0/1)",
+        "0",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &accumulate,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".reset",
+        "set to 1 to reset accumulated counts",
+        "0",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &resetcnt,
+        NULL
+    }
+};
+
+static CLICMDDATA CLIcmddata =
+{
+    "imhisto", "histogram of image stream", CLICMD_FIELDS_DEFAULTS
+};
+
+// detailed help
+static errno_t help_function()
+{
+    printf("Histogram of each new frame of input stream\n");
+    printf("Output stream rows: counts, lower bin edge\n");
+    printf("With autorange and accumulate, range is set on first frame "
+           "after reset\n");
+    printf("Changing .autorange, .logbins, .min or .max resets accumulated "
+           "counts\n");
+
+    return RETURN_SUCCESS;
+}
+
+static errno_t compute_function()
+{
+    DEBUG_TRACE_FSTART();
+
+    imageID ID = image_ID(instreamname);
+
+    long NBbin = *nbbin;
+
+    imageID  IDout;
+    uint32_t sizeout[2];
+    sizeout[0] = NBbin;
+    sizeout[1] = 2;
+    create_image_ID(outstreamname,
+                    2,
+                    sizeout,
+                    _DATATYPE_DOUBLE,
+                    1,
+                    0,
+                    0,
+                    &IDout);
+
+    IMHISTOGRAM histo;
+    histogram_init(&histo,
+                   NBbin,
+                   (*autorange == 1) ? HISTOGRAM_RANGE_AUTO
+                   : HISTOGRAM_RANGE_FIXED,
+                   (*logbins == 1) ? HISTOGRAM_BINS_LOG : HISTOGRAM_BINS_LINEAR,
+                   *histmin,
+                   *histmax);
+
+    INSERT_STD_PROCINFO_COMPUTEFUNC_INIT
+
+    INSERT_STD_PROCINFO_COMPUTEFUNC_LOOPSTART
+    {
+        if(*resetcnt == 1)
+        {
+            histogram_reset(&histo);
+            *resetcnt = 0;
+        }
+
+        // range mode, fixed range and bin mode may change at runtime :
+        // accumulated counts are reset if any of them changes
+        int rangemode = (*autorange == 1) ? HISTOGRAM_RANGE_AUTO
+                        : HISTOGRAM_RANGE_FIXED;
+        if(rangemode == HISTOGRAM_RANGE_FIXED)
+        {
+            if((histo.rangemode != rangemode) || (histo.min != *histmin) ||
+                    (histo.max != *histmax))
+            {
+                histogram_reset(&histo);
+            }
+            histo.min = *histmin;
+            histo.max = *histmax;
+        }
+        else if(histo.rangemode != rangemode)
+        {
+            histogram_reset(&histo);
+        }
+        histo.rangemode = rangemode;
+
+        int binmode = (*logbins == 1) ? HISTOGRAM_BINS_LOG
+                      : HISTOGRAM_BINS_LINEAR;
+        if(histo.binmode != binmode)
+        {
+            histogram_reset(&histo);
+        }
+        histo.binmode = binmode;
+
+        image_histogram(&data.image[ID], &histo, (int) *accumulate);
+
+        double *outarray = data.image[IDout].array.D;
+
+        data.image[IDout].md[0].write = 1;
+        for(long b = 0; b < NBbin; b++)
+        {
+            outarray[b]         = (double) histo.count[b];
+            outarray[NBbin + b] = histogram_binedge(&histo, b);
+        }
+        processinfo_update_output_stream(processinfo, IDout);
+    }
+    INSERT_STD_PROCINFO_COMPUTEFUNC_END
+
+    histogram_free(&histo);
+
+    DEBUG_TRACE_FEXIT();
+    return RETURN_SUCCESS;
+}
+
+INSERT_STD_FPSCLIfunctions
+
+// Register function in CLI
+errno_t CLIADDCMD_info__histogram_stream()
+{
+    INSERT_STD_CLIREGISTERFUNC
+
+    return RETURN_SUCCESS;
+}
@@ -0,0 +1,10 @@
+/**
+ * @file    histogram_stream.h
+ */
+
+#ifndef _INFO_HISTOGRAM_STREAM_H
+#define _INFO_HISTOGRAM_STREAM_H
+
+errno_t CLIADDCMD_info__histogram_stream();
+
+#endif
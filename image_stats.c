@@ -6,7 +6,34 @@
 #include "CommandLineInterface/CLIcore.h"
 
 #include "COREMOD_memory/COREMOD_memory.h"
-#include "COREMOD_tools/COREMOD_tools.h"
+
+#include "imsnapshot.h"
+#include "imstats.h"
+
+// percentiles reported, with variable names
+#define IMSTATS_NBPERC 12
+
+static struct
+{
+    double      p;
+    const char *label;  // terminal
+    const char *vname;  // CLI variable
+    const char *flabel; // file output
+} imstatsperc[IMSTATS_NBPERC] =
+{
+    {0.01, "1  percent", "vp01", "percentile01"},
+    {0.05, "5  percent", "vp05", "percentile05"},
+    {0.10, "10 percent", "vp10", "percentile10"},
+    {0.20, "20 percent", "vp20", "percentile20"},
+    {0.50, "50 percent", "vp50", "percentile50"},
+    {0.80, "80 percent", "vp80", "percentile80"},
+    {0.90, "90 percent", "vp90", "percentile90"},
+    {0.95, "95 percent", "vp95", "percentile95"},
+    {0.99, "99 percent", "vp99", "percentile99"},
+    {0.995, "99.5 percent", "vp995", "percentile995"},
+    {0.998, "99.8 percent", "vp998", "percentile998"},
+    {0.999, "99.9 percent", "vp999", "percentile999"}
+};
 
 
 // ==========================================
@@ -71,6 +98,29 @@ errno_t image_stats_addCLIcmd()
     return RETURN_SUCCESS;
 }
 
+// statistics and percentiles, computed on a consistent frame
+typedef struct
+{
+    IMSTATS imstats;
+    double *percarray;
+    double *percval;
+} IMAGE_STATS_RESULT;
+
+// run by imsnapshot_run()
+static errno_t info_image_stats_compute(IMAGE *image, void *arg)
+{
+    IMAGE_STATS_RESULT *result = (IMAGE_STATS_RESULT *) arg;
+
+    if(imstats_compute(image, &result->imstats) != RETURN_SUCCESS)
+    {
+        return RETURN_FAILURE;
+    }
+    return image_percentiles(image,
+                             IMSTATS_NBPERC,
+                             result->percarray,
+                             result->percval);
+}
+
 // option "fileout" : output to file imstat.info.txt
 errno_t info_image_stats(const char *ID_name, const char *options)
 {
@@ -79,13 +129,11 @@ errno_t info_image_stats(const char *ID_name, const char *options)
     double   rms;
     uint64_t nelements;
     double   tot;
-    double  *array;
     long     iimin, iimax;
     uint8_t  datatype;
     long     tmp_long;
     char     type[20];
     char     vname[200];
-    double   xtot, ytot;
     double   vbx, vby;
     FILE    *fp;
     int      mode = 0;
@@ -190,269 +238,145 @@ errno_t info_image_stats(const char *ID_name, const char *options)
         //      printf("Created:         %f\n", data.image[ID].creation_time);
         //      printf("Last access:     %f\n", data.image[ID].last_access);
 
-        if(datatype == _DATATYPE_FLOAT)
-        {
-            min = data.image[ID].array.F[0];
-            max = data.image[ID].array.F[0];
-
-            iimin = 0;
-            iimax = 0;
-            for(unsigned long ii = 0; ii < nelements; ii++)
-            {
-                if(min > data.image[ID].array.F[ii])
-                {
-                    min   = data.image[ID].array.F[ii];
-                    iimin = ii;
-                }
-                if(max < data.image[ID].array.F[ii])
-                {
-                    max   = data.image[ID].array.F[ii];
-                    iimax = ii;
-                }
-            }
-
-            array = (double *) malloc(nelements * sizeof(double));
-            tot   = 0.0;
-
-            rms = 0.0;
-            for(unsigned long ii = 0; ii < nelements; ii++)
-            {
-                if(isnan(data.image[ID].array.F[ii]) != 0)
-                {
-                    printf(
-                        "element %ld is NAN -> replacing by "
-                        "0\n",
-                        ii);
-                    data.image[ID].array.F[ii] = 0.0;
-                }
-                tot += data.image[ID].array.F[ii];
-                rms += data.image[ID].array.F[ii] * data.image[ID].array.F[ii];
-                array[ii] = data.image[ID].array.F[ii];
-            }
-            rms = sqrt(rms);
-
-            printf("minimum         (->vmin)     %20.18e [ pix %ld ]\n",
-                   min,
-                   iimin);
-            if(mode == 1)
-            {
-                fprintf(fp,
-                        "minimum                  %20.18e [ pix "
-                        "%ld ]\n",
-                        min,
-                        iimin);
-            }
-            create_variable_ID("vmin", min);
-            printf("maximum         (->vmax)     %20.18e [ pix %ld ]\n",
-                   max,
-                   iimax);
-            if(mode == 1)
-            {
-                fprintf(fp,
-                        "maximum                  %20.18e [ pix "
-                        "%ld ]\n",
-                        max,
-                        iimax);
-            }
-            create_variable_ID("vmax", max);
-            printf("total           (->vtot)     %20.18e\n", tot);
-            if(mode == 1)
-            {
-                fprintf(fp, "total                    %20.18e\n", tot);
-            }
-            create_variable_ID("vtot", tot);
-            printf("rms             (->vrms)     %20.18e\n", rms);
-            if(mode == 1)
-            {
-                fprintf(fp, "rms                      %20.18e\n", rms);
-            }
-            create_variable_ID("vrms", rms);
-            printf("rms per pixel   (->vrmsp)    %20.18e\n",
-                   rms / sqrt(nelements));
-            if(mode == 1)
-            {
-                fprintf(fp,
-                        "rms per pixel            %20.18e\n",
-                        rms / sqrt(nelements));
-            }
-            create_variable_ID("vrmsp", rms / sqrt(nelements));
-            printf("rms dev per pix (->vrmsdp)   %20.18e\n",
-                   sqrt(rms * rms / nelements -
-                        tot * tot / nelements / nelements));
-            create_variable_ID("vrmsdp",
-                               sqrt(rms * rms / nelements -
-                                    tot * tot / nelements / nelements));
-            printf("mean            (->vmean)    %20.18e\n", tot / nelements);
-            if(mode == 1)
-            {
-                fprintf(fp,
-                        "mean                     %20.18e\n",
-                        tot / nelements);
-            }
-            create_variable_ID("vmean", tot / nelements);
-
-            if(data.image[ID].md[0].naxis == 2)
-            {
-                xtot = 0.0;
-                ytot = 0.0;
-                for(unsigned long ii = 0; ii < data.image[ID].md[0].size[0];
-                        ii++)
-                    for(unsigned long jj = 0;
-                            jj < data.image[ID].md[0].size[1];
-                            jj++)
-                    {
-                        xtot += data.image[ID]
-                                .array
-                                .F[jj * data.image[ID].md[0].size[0] + ii] *
-                                ii;
-                        ytot += data.image[ID]
-                                .array
-                                .F[jj * data.image[ID].md[0].size[0] + ii] *
-                                jj;
-                    }
-                vbx = xtot / tot;
-                vby = ytot / tot;
-                printf("Barycenter x    (->vbx)      %20.18f\n", vbx);
-                if(mode == 1)
-                {
-                    fprintf(fp, "photocenterX             %20.18e\n", vbx);
-                }
-                create_variable_ID("vbx", vbx);
-                printf("Barycenter y    (->vby)      %20.18f\n", vby);
-                if(mode == 1)
-                {
-                    fprintf(fp, "photocenterY             %20.18e\n", vby);
-                }
-                create_variable_ID("vby", vby);
-            }
-
-            quick_sort_double(array, nelements);
-            printf("\n");
-            printf("percentile values:\n");
-
-            printf("1  percent      (->vp01)     %20.18e\n",
-                   array[(long)(0.01 * nelements)]);
-            if(mode == 1)
-            {
-                fprintf(fp,
-                        "percentile01             %20.18e\n",
-                        array[(long)(0.01 * nelements)]);
-            }
-            create_variable_ID("vp01", array[(long)(0.01 * nelements)]);
-
-            printf("5  percent      (->vp05)     %20.18e\n",
-                   array[(long)(0.05 * nelements)]);
-            if(mode == 1)
-            {
-                fprintf(fp,
-                        "percentile05             %20.18e\n",
-                        array[(long)(0.05 * nelements)]);
-            }
-            create_variable_ID("vp05", array[(long)(0.05 * nelements)]);
-
-            printf("10 percent      (->vp10)     %20.18e\n",
-                   array[(long)(0.1 * nelements)]);
-            if(mode == 1)
-            {
-                fprintf(fp,
-                        "percentile10             %20.18e\n",
-                        array[(long)(0.10 * nelements)]);
-            }
-            create_variable_ID("vp10", array[(long)(0.1 * nelements)]);
+        double             percval[IMSTATS_NBPERC];
+        double             percarray[IMSTATS_NBPERC];
+        IMAGE_STATS_RESULT result = {.percarray = percarray,
+                                     .percval   = percval
+                                    };
 
-            printf("20 percent      (->vp20)     %20.18e\n",
-                   array[(long)(0.2 * nelements)]);
-            if(mode == 1)
-            {
-                fprintf(fp,
-                        "percentile20             %20.18e\n",
-                        array[(long)(0.20 * nelements)]);
-            }
-            create_variable_ID("vp20", array[(long)(0.2 * nelements)]);
-
-            printf("50 percent      (->vp50)     %20.18e\n",
-                   array[(long)(0.5 * nelements)]);
-            if(mode == 1)
-            {
-                fprintf(fp,
-                        "percentile50             %20.18e\n",
-                        array[(long)(0.50 * nelements)]);
-            }
-            create_variable_ID("vp50", array[(long)(0.5 * nelements)]);
+        for(int i = 0; i < IMSTATS_NBPERC; i++)
+        {
+            percarray[i] = imstatsperc[i].p;
+        }
 
-            printf("80 percent      (->vp80)     %20.18e\n",
-                   array[(long)(0.8 * nelements)]);
+        // stream may be written while read : statistics and percentiles
+        // from the same frame
+        IMSNAPSHOT snap = {0};
+        errno_t    ret  = imsnapshot_run(&snap,
+                                         &data.image[ID],
+                                         info_image_stats_compute,
+                                         &result);
+        if(ret != RETURN_SUCCESS)
+        {
+            imsnapshot_free(&snap);
             if(mode == 1)
             {
-                fprintf(fp,
-                        "percentile80             %20.18e\n",
-                        array[(long)(0.80 * nelements)]);
+                fclose(fp);
             }
-            create_variable_ID("vp80", array[(long)(0.8 * nelements)]);
+            return RETURN_FAILURE;
+        }
+        IMSTATS imstats = result.imstats;
 
-            printf("90 percent      (->vp90)     %20.18e\n",
-                   array[(long)(0.9 * nelements)]);
-            if(mode == 1)
-            {
-                fprintf(fp,
-                        "percentile90             %20.18e\n",
-                        array[(long)(0.90 * nelements)]);
-            }
-            create_variable_ID("vp90", array[(long)(0.9 * nelements)]);
+        if(snap.nbretry > 0)
+        {
+            printf("frame changed during read : %lu retries, %lu copies, "
+                   "%lu torn\n",
+                   snap.nbretry,
+                   snap.nbcopy,
+                   snap.nbtorn);
+        }
+        create_variable_ID("vtorn", 1.0 * snap.nbtorn);
+        imsnapshot_free(&snap);
+
+        nelements = imstats.nelement;
+        min       = imstats.min;
+        max       = imstats.max;
+        iimin     = imstats.iimin;
+        iimax     = imstats.iimax;
+        tot       = imstats.total;
+        rms       = sqrt(imstats.total2);
+
+        if(imstats.nbnan > 0)
+        {
+            printf("%lu NAN element(s) ignored\n", (unsigned long) imstats.nbnan);
+        }
 
-            printf("95 percent      (->vp95)     %20.18e\n",
-                   array[(long)(0.95 * nelements)]);
-            if(mode == 1)
-            {
-                fprintf(fp,
-                        "percentile95             %20.18e\n",
-                        array[(long)(0.95 * nelements)]);
-            }
-            create_variable_ID("vp95", array[(long)(0.95 * nelements)]);
+        printf("minimum         (->vmin)     %20.18e [ pix %ld ]\n", min, iimin);
+        if(mode == 1)
+        {
+            fprintf(fp,
+                    "minimum                  %20.18e [ pix "
+                    "%ld ]\n",
+                    min,
+                    iimin);
+        }
+        create_variable_ID("vmin", min);
+        printf("maximum         (->vmax)     %20.18e [ pix %ld ]\n", max, iimax);
+        if(mode == 1)
+        {
+            fprintf(fp,
+                    "maximum                  %20.18e [ pix "
+                    "%ld ]\n",
+                    max,
+                    iimax);
+        }
+        create_variable_ID("vmax", max);
+        printf("total           (->vtot)     %20.18e\n", tot);
+        if(mode == 1)
+        {
+            fprintf(fp, "total                    %20.18e\n", tot);
+        }
+        create_variable_ID("vtot", tot);
+        printf("rms             (->vrms)     %20.18e\n", rms);
+        if(mode == 1)
+        {
+            fprintf(fp, "rms                      %20.18e\n", rms);
+        }
+        create_variable_ID("vrms", rms);
+        printf("rms per pixel   (->vrmsp)    %20.18e\n", rms / sqrt(nelements));
+        if(mode == 1)
+        {
+            fprintf(fp,
+                    "rms per pixel            %20.18e\n",
+                    rms / sqrt(nelements));
+        }
+        create_variable_ID("vrmsp", rms / sqrt(nelements));
+        printf("rms dev per pix (->vrmsdp)   %20.18e\n", imstats.rmsdev);
+        create_variable_ID("vrmsdp", imstats.rmsdev);
+        printf("mean            (->vmean)    %20.18e\n", imstats.mean);
+        if(mode == 1)
+        {
+            fprintf(fp, "mean                     %20.18e\n", imstats.mean);
+        }
+        create_variable_ID("vmean", imstats.mean);
 
-            printf("99 percent      (->vp99)     %20.18e\n",
-                   array[(long)(0.99 * nelements)]);
+        if(data.image[ID].md[0].naxis == 2)
+        {
+            vbx = imstats.xbary;
+            vby = imstats.ybary;
+            printf("Barycenter x    (->vbx)      %20.18f\n", vbx);
             if(mode == 1)
             {
-                fprintf(fp,
-                        "percentile99             %20.18e\n",
-                        array[(long)(0.99 * nelements)]);
+                fprintf(fp, "photocenterX             %20.18e\n", vbx);
             }
-            create_variable_ID("vp99", array[(long)(0.99 * nelements)]);
-
-            printf("99.5 percent    (->vp995)    %20.18e\n",
-                   array[(long)(0.995 * nelements)]);
+            create_variable_ID("vbx", vbx);
+            printf("Barycenter y    (->vby)      %20.18f\n", vby);
             if(mode == 1)
             {
-                fprintf(fp,
-                        "percentile995            %20.18e\n",
-                        array[(long)(0.995 * nelements)]);
+                fprintf(fp, "photocenterY             %20.18e\n", vby);
             }
-            create_variable_ID("vp995", array[(long)(0.995 * nelements)]);
+            create_variable_ID("vby", vby);
+        }
 
-            printf("99.8 percent    (->vp998)    %20.18e\n",
-                   array[(long)(0.998 * nelements)]);
-            if(mode == 1)
-            {
-                fprintf(fp,
-                        "percentile998            %20.18e\n",
-                        array[(long)(0.998 * nelements)]);
-            }
-            create_variable_ID("vp998", array[(long)(0.998 * nelements)]);
+        printf("\n");
+        printf("percentile values:\n");
+        for(int i = 0; i < IMSTATS_NBPERC; i++)
+        {
+            char vtag[20];
 
-            printf("99.9 percent    (->vp999)    %20.18e\n",
-                   array[(long)(0.999 * nelements)]);
+            snprintf(vtag, sizeof(vtag), "(->%s)", imstatsperc[i].vname);
+            printf("%-16s%-13s%20.18e\n",
+                   imstatsperc[i].label,
+                   vtag,
+                   percval[i]);
             if(mode == 1)
             {
-                fprintf(fp,
-                        "percentile999            %20.18e\n",
-                        array[(long)(0.999 * nelements)]);
+                fprintf(fp, "%-25s%20.18e\n", imstatsperc[i].flabel, percval[i]);
             }
-            create_variable_ID("vp999", array[(long)(0.999 * nelements)]);
-
-            printf("\n");
-            free(array);
+            create_variable_ID(imstatsperc[i].vname, percval[i]);
         }
+
+        printf("\n");
     }
 
     if(mode == 1)
@@ -16,15 +16,28 @@
 
 #include "CommandLineInterface/CLIcore.h"
 
-#include "COREMOD_arith/COREMOD_arith.h"
 #include "COREMOD_memory/COREMOD_memory.h"
+#include "cbstats.h"
+#include "histogram.h"
+#include "imagemon_dash.h"
+#include "imagemon_heatmap.h"
+#include "imagemon_sem.h"
+#include "imdecimate.h"
+#include "imsnapshot.h"
+#include "imstats.h"
+#include "info_instr.h"
+#include "info_scratch.h"
 #include "print_header.h"
+#include "streamhealth.h"
+#include "streamrate.h"
 #include "streamtiming_stats.h"
-#include "timediff.h"
 
 
 #include "TUItools.h"
 
+// median and histogram of stride 1 subsets larger than this are estimated
+// on a strided subsample
+#define IMGMON_HISTO_NBPIX 1048576
 
 
 
@@ -32,14 +45,21 @@
 static uint16_t wrow, wcol;
 
 
-static uint64_t       cntlast;
-static struct timespec tlast;
-
-
-
 // Local variables pointers
-static char  *instreamname;
-static float *updatefrequency;
+static char    *instreamname;
+static float   *updatefrequency;
+static int64_t *headless;
+static char    *outstreamname;
+static int64_t *pixstats;
+static char    *streamlist;
+static int64_t *cbslots;
+static int64_t *roix0;
+static int64_t *roiy0;
+static int64_t *roixsize;
+static int64_t *roiysize;
+static char    *roimaskname;
+static int64_t *samplestride;
+static int64_t *samplenpix;
 
 static CLICMDARGDEF farg[] =
 {
@@ -60,6 +80,114 @@ static CLICMDARGDEF farg[] =
         CLIARG_VISIBLE_DEFAULT,
         (void **) &updatefrequency,
         NULL
+    },
+    {
+        CLIARG_INT64,
+        ".headless",
+        "no display, publish health stream (0/1)",
+        "0",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &headless,
+        NULL
+    },
+    {
+        CLIARG_STR,
+        ".outsname",
+        "health stream, headless mode",
+        "im1health",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &outstreamname,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".stats",
+        "pixel statistics in health stream and dashboard (0/1)",
+        "1",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &pixstats,
+        NULL
+    },
+    {
+        CLIARG_STR,
+        ".streams",
+        "dashboard streams, comma-separated, wildcards allowed",
+        "",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &streamlist,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".cbslots",
+        "circular buffer frames in history screen, 0 for all",
+        "0",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &cbslots,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".roi.x0",
+        "statistics box origin x",
+        "0",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &roix0,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".roi.y0",
+        "statistics box origin y",
+        "0",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &roiy0,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".roi.xsize",
+        "statistics box size x, 0 for full frame",
+        "0",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &roixsize,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".roi.ysize",
+        "statistics box size y, 0 for full frame",
+        "0",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &roiysize,
+        NULL
+    },
+    {
+        CLIARG_STR,
+        ".roi.mask",
+        "statistics mask image, float, pixels > 0.5 used",
+        "",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &roimaskname,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".sample.stride",
+        "statistics pixel step along x and y, 0 or 1 for all",
+        "0",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &samplestride,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".sample.npix",
+        "statistics pixel budget per refresh, sets stride, 0 for none",
+        "0",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &samplenpix,
+        NULL
     }
 };
 
@@ -74,25 +202,271 @@ static CLICMDDATA CLIcmddata =
 // detailed help
 static errno_t help_function()
 {
+    printf("Interactive stream monitor, refreshed at .frequ\n");
+    printf("With .headless 1, no display : health samples of the stream are "
+           "written\n");
+    printf("to 1D stream .outsname at .frequ, fields in streamhealth.h\n");
+    printf("With .streams, screen F4 shows one row per stream, for example\n");
+    printf("  .streams \"aol0_*,dm00disp\" (wildcards match streams of the "
+           "shm directory)\n");
+    printf("Screen F5 shows statistics over the last .cbslots frames of the "
+           "circular\n");
+    printf("buffer, read in place : per frame, all frames, temporal RMS\n");
+    printf("Summary screen statistics are restricted to box .roi.* and mask "
+           ".roi.mask,\n");
+    printf("sampled every .sample.stride pixels, or at most .sample.npix "
+           "pixels :\n");
+    printf("the mean is shown with its standard error. With stride 1 the "
+           "subset is read\n");
+    printf("in place, and median / histogram of large subsets are "
+           "estimated (~)\n");
+    printf("These arguments can be changed while running\n");
+    printf("Screen F6 shows the frame as a heatmap reduced to the terminal "
+           "size\n");
+    printf("Screen F7 shows semaphore values over the last refreshes, their "
+           "growth rate,\n");
+    printf("and reader/writer process name, CPU affinity and dead PIDs\n");
+
     return RETURN_SUCCESS;
 }
 
 
 
 errno_t info_image_monitor(const char *ID_name, float frequ);
-errno_t printstatus(imageID ID);
+errno_t printstatus(imageID           ID,
+                    STREAMRATE_STATE *ratestate,
+                    IMSTATS_SAMPLE   *sample,
+                    IMSNAPSHOT       *snap);
+errno_t printcbstats(imageID ID, long nbslot, int maxrow);
+
+
+// mean screen update and statistics time, as processinfo status message
+// updated every second
+static void imgmon_instr_message(PROCESSINFO *processinfo)
+{
+    static uint64_t tmsg      = 0;
+    static uint64_t screencnt = 0;
+    static uint64_t screenns  = 0;
+    static uint64_t statscnt  = 0;
+    static uint64_t statsns   = 0;
+
+    uint64_t tnow = info_instr_now();
+    uint64_t cnt1, ns1;
+    uint64_t cnt2 = statscnt;
+    uint64_t ns2  = statsns;
+    char     msg[STRINGMAXLEN_DEFAULT];
+
+    if(tnow - tmsg < 1000000000)
+    {
+        return;
+    }
+    tmsg = tnow;
+
+    if(info_instr_phase_get("imgmon.screen", &cnt1, &ns1) != RETURN_SUCCESS)
+    {
+        return;
+    }
+    // statistics only computed on summary screen
+    info_instr_phase_get("imgmon.stats", &cnt2, &ns2);
+
+    WRITE_STRING(msg,
+                 "screen %.3f ms  stats %.3f ms",
+                 (cnt1 > screencnt) ? 1.0e-6 * (ns1 - screenns) /
+                 (cnt1 - screencnt)
+                 : 0.0,
+                 (cnt2 > statscnt) ? 1.0e-6 * (ns2 - statsns) /
+                 (cnt2 - statscnt)
+                 : 0.0);
+    processinfo_WriteMessage(processinfo, msg);
+
+    screencnt = cnt1;
+    screenns  = ns1;
+    statscnt  = cnt2;
+    statsns   = ns2;
+}
+
+
+
+// .roi and .sample arguments of current statistics subset
+typedef struct
+{
+    int64_t x0;
+    int64_t y0;
+    int64_t xsize;
+    int64_t ysize;
+    int64_t stride;
+    int64_t npix;
+    char    maskname[STRINGMAXLEN_IMAGE_NAME];
+} IMGMON_SAMPLEPAR;
+
+// returns 1 if .roi or .sample arguments differ from par, and updates par
+static int imgmon_sample_changed(IMGMON_SAMPLEPAR *par)
+{
+    IMGMON_SAMPLEPAR cur;
+
+    memset(&cur, 0, sizeof(IMGMON_SAMPLEPAR));
+    cur.x0     = *roix0;
+    cur.y0     = *roiy0;
+    cur.xsize  = *roixsize;
+    cur.ysize  = *roiysize;
+    cur.stride = *samplestride;
+    cur.npix   = *samplenpix;
+    strncpy(cur.maskname, roimaskname, STRINGMAXLEN_IMAGE_NAME - 1);
+
+    if(memcmp(&cur, par, sizeof(IMGMON_SAMPLEPAR)) == 0)
+    {
+        return 0;
+    }
+    *par = cur;
+    return 1;
+}
+
+// statistics subset from .roi and .sample arguments
+// returns NULL if statistics use the full frame
+static IMSTATS_SAMPLE *imgmon_sample_init(IMAGE          *image,
+                                          IMSTATS_SAMPLE *sample)
+{
+    sample->x0     = 0;
+    sample->y0     = 0;
+    sample->xsize  = 0;
+    sample->ysize  = 0;
+    sample->mask   = NULL;
+    sample->stride = 1;
+
+    // box coordinates are uint32 : out of range values are not cast
+    if((*roix0 < 0) || (*roiy0 < 0) || (*roixsize < 0) || (*roiysize < 0) ||
+            (*roix0 > UINT32_MAX) || (*roiy0 > UINT32_MAX) ||
+            (*roixsize > UINT32_MAX) || (*roiysize > UINT32_MAX))
+    {
+        PRINT_WARNING(".roi out of range, full frame used");
+    }
+    else
+    {
+        sample->x0    = (uint32_t) *roix0;
+        sample->y0    = (uint32_t) *roiy0;
+        sample->xsize = (uint32_t) *roixsize;
+        sample->ysize = (uint32_t) *roiysize;
+    }
+    if((*samplestride < 0) || (*samplestride > UINT32_MAX))
+    {
+        PRINT_WARNING(".sample.stride out of range, stride 1 used");
+    }
+    else
+    {
+        sample->stride = (uint32_t) *samplestride;
+    }
+
+    if(strlen(roimaskname) > 0)
+    {
+        imageID IDmask = image_ID(roimaskname);
+
+        if(IDmask == -1)
+        {
+            IDmask = read_sharedmem_image(roimaskname);
+        }
+        if((IDmask != -1) &&
+                (data.image[IDmask].md[0].datatype == _DATATYPE_FLOAT) &&
+                (data.image[IDmask].md[0].nelement == image->md[0].nelement))
+        {
+            sample->mask = data.image[IDmask].array.F;
+        }
+        else
+        {
+            PRINT_WARNING("mask %s : float image of stream size required",
+                          roimaskname);
+        }
+    }
+
+    if(*samplenpix > 0)
+    {
+        imstats_sample_budget(image, sample, (uint64_t) *samplenpix);
+    }
+    else
+    {
+        imstats_sample_maxsize(image, sample);
+    }
+
+    if((sample->mask == NULL) && (sample->stride == 1) &&
+            ((uint64_t) sample->xsize * sample->ysize ==
+             image->md[0].nelement))
+    {
+        return NULL;
+    }
+    return sample;
+}
+
+
+
+// publish health samples at .frequ, no terminal
+static errno_t compute_function_headless()
+{
+    DEBUG_TRACE_FSTART();
+
+    imageID            ID    = image_ID(instreamname);
+    STREAMHEALTH_STATE state = {0};
+
+    if(ID == -1)
+    {
+        PRINT_ERROR("stream %s not loaded", instreamname);
+        DEBUG_TRACE_FEXIT();
+        return RETURN_FAILURE;
+    }
+    IMAGE *image = &data.image[ID];
+
+    imageID  IDout;
+    uint32_t sizeout[1];
+    sizeout[0] = (uint32_t) streamhealth_size(image);
+    create_image_ID(outstreamname,
+                    1,
+                    sizeout,
+                    _DATATYPE_DOUBLE,
+                    1,
+                    0,
+                    0,
+                    &IDout);
+
+    INSERT_STD_PROCINFO_COMPUTEFUNC_INIT
+
+    // loop period from .frequ
+    double tperiod = 1.0 / *updatefrequency;
+    processinfo->triggermode          = PROCESSINFO_TRIGGERMODE_DELAY;
+    processinfo->triggerdelay.tv_sec  = (time_t) tperiod;
+    processinfo->triggerdelay.tv_nsec =
+        (long)((tperiod - (time_t) tperiod) * 1.0e9);
+
+    INSERT_STD_PROCINFO_COMPUTEFUNC_LOOPSTART
+    {
+        data.image[IDout].md[0].write = 1;
+        streamhealth_sample(image,
+                            &state,
+                            (int) *pixstats,
+                            data.image[IDout].array.D);
+        processinfo_update_output_stream(processinfo, IDout);
+    }
+    INSERT_STD_PROCINFO_COMPUTEFUNC_END
 
+    streamhealth_free(&state);
 
+    DEBUG_TRACE_FEXIT();
+    return RETURN_SUCCESS;
+}
 
 static errno_t compute_function()
 {
+    if(*headless == 1)
+    {
+        return compute_function_headless();
+    }
+
     DEBUG_TRACE_FSTART();
 
+    // UTF-8 half blocks of heatmap screen
+    setlocale(LC_CTYPE, "");
 
     INSERT_TUI_SETUP
 
     // define screens
-    static int NBTUIscreen = 3;
+    static int NBTUIscreen = 7;
 
     TUIscreenarray[0].index = 1;
     TUIscreenarray[0].keych = 'h';
@@ -106,9 +480,38 @@ static errno_t compute_function()
     TUIscreenarray[2].keych = KEY_F(3);
     strcpy(TUIscreenarray[2].name, "[F3] timing");
 
+    TUIscreenarray[3].index = 4;
+    TUIscreenarray[3].keych = KEY_F(4);
+    strcpy(TUIscreenarray[3].name, "[F4] streams");
+
+    TUIscreenarray[4].index = 5;
+    TUIscreenarray[4].keych = KEY_F(5);
+    strcpy(TUIscreenarray[4].name, "[F5] history");
+
+    TUIscreenarray[5].index = 6;
+    TUIscreenarray[5].keych = KEY_F(6);
+    strcpy(TUIscreenarray[5].name, "[F6] heatmap");
+
+    TUIscreenarray[6].index = 7;
+    TUIscreenarray[6].keych = KEY_F(7);
+    strcpy(TUIscreenarray[6].name, "[F7] semaphores");
 
     INSERT_STD_PROCINFO_COMPUTEFUNC_INIT
 
+    // phase timers, unless already enabled by INFO_INSTR
+    // read with command instrstat <process name>
+    if(info_instr_block == NULL)
+    {
+        char fname[STRINGMAXLEN_FULLFILENAME];
+
+        WRITE_FULLFILENAME(fname,
+                           "%s/%s%s",
+                           data.shmdir,
+                           processinfo->name,
+                           INFO_INSTR_SHMSUFFIX);
+        info_instr_init(fname);
+    }
+
     double pinfotdelay = 1.0 * processinfo->triggerdelay.tv_sec +
                          1.0e-9 * processinfo->triggerdelay.tv_nsec;
     int diplaycntinterval = (int)((1.0 / *updatefrequency) / pinfotdelay);
@@ -118,14 +521,51 @@ static errno_t compute_function()
     int     TUIscreen = 2;
     int     sem       = -1;
 
+    // frame rate measured between summary screen refreshes
+    STREAMRATE_STATE ratestate = {0};
+
+    // summary screen statistics on consistent frames
+    IMSNAPSHOT snap = {0};
+
+    // summary screen statistics on a pixel subset, NULL for full frame
+    // recomputed when .roi or .sample arguments change
+    IMSTATS_SAMPLE   sampledef = {0};
+    IMSTATS_SAMPLE  *sample    = NULL;
+    IMGMON_SAMPLEPAR samplepar = {0};
+
     int timingbuffinit = 0;
 
+    // heatmap screen
+    int heatmapmode  = IMDECIMATE_MEAN;
+    int heatmapscale = IMGMON_HEATMAP_LINEAR;
+
+    // semaphore screen, sampled at each refresh
+    IMGMON_SEM semmon = {0};
+
+    // dashboard streams, sampled in this loop
+    IMGMON_DASH dash;
+    imgmon_dash_open(&dash, streamlist);
+    if(dash.nbstream > 0)
+    {
+        TUIscreen = 4;
+    }
+
     INSERT_STD_PROCINFO_COMPUTEFUNC_LOOPSTART
 
     {
         INSTERT_TUI_KEYCONTROLS
 
 
+        if((TUIscreen == 6) && (TUIinputkch == 'm'))
+        {
+            heatmapmode = (heatmapmode == IMDECIMATE_MEAN) ? IMDECIMATE_MAX
+                          : IMDECIMATE_MEAN;
+        }
+        if((TUIscreen == 6) && (TUIinputkch == 's'))
+        {
+            heatmapscale = (heatmapscale + 1) % IMGMON_HEATMAP_NBSCALE;
+        }
+
         if(TUIinputkch == ' ')
         {
             TUI_printfw("BUFFER INIT\n");
@@ -135,6 +575,8 @@ static errno_t compute_function()
 
         if((dispcnt == 0) && (TUIpause == 0))
         {
+            INFO_INSTR_SCOPE("imgmon.screen");
+
             erase();
 
             // Check for screen size change
@@ -143,19 +585,34 @@ static errno_t compute_function()
             INSERT_TUI_SCREEN_MENU
             TUI_newline();
 
+            if(ID != -1)
+            {
+                imgmon_sem_update(&semmon, &data.image[ID]);
+            }
+
             if(TUIscreen == 1)
             {
-                TUI_printfw("h / F2 / F3 : change screen\n");
+                TUI_printfw("h / F2 / F3 / F4 / F5 / F6 / F7 : change screen\n");
+                TUI_printfw("m / s : heatmap mean or max, scaling\n");
                 TUI_printfw("x : exit\n");
             }
 
-            if(TUIscreen == 2)
+            if(((TUIscreen == 2) || (TUIscreen == 3) || (TUIscreen >= 5)) &&
+                    (ID == -1))
+            {
+                TUI_printfw("stream %s not loaded\n", instreamname);
+            }
+            else if(TUIscreen == 2)
             {
                 processinfo->triggermode = PROCESSINFO_TRIGGERMODE_DELAY;
-                printstatus(ID);
+                if(imgmon_sample_changed(&samplepar))
+                {
+                    sample = imgmon_sample_init(&data.image[ID], &sampledef);
+                }
+                printstatus(ID, &ratestate, sample, &snap);
             }
 
-            if(TUIscreen == 3)
+            if((TUIscreen == 3) && (ID != -1))
             {
                 processinfo->triggermode =
                     PROCESSINFO_TRIGGERMODE_IMMEDIATE; // DIIIIIIRTY
@@ -192,8 +649,38 @@ static errno_t compute_function()
                 sem = -1;
             }
 
+            if(TUIscreen == 4)
+            {
+                processinfo->triggermode = PROCESSINFO_TRIGGERMODE_DELAY;
+                imgmon_dash_update(&dash, (int) *pixstats);
+                imgmon_dash_print(&dash, (int) *pixstats, wrow - 6);
+            }
+
+            if((TUIscreen == 5) && (ID != -1))
+            {
+                processinfo->triggermode = PROCESSINFO_TRIGGERMODE_DELAY;
+                printcbstats(ID, (long) *cbslots, wrow - 12);
+            }
+
+            if((TUIscreen == 6) && (ID != -1))
+            {
+                processinfo->triggermode = PROCESSINFO_TRIGGERMODE_DELAY;
+                imgmon_heatmap_print(&data.image[ID],
+                                     heatmapmode,
+                                     heatmapscale,
+                                     wrow - 4,
+                                     wcol);
+            }
+
+            if((TUIscreen == 7) && (ID != -1))
+            {
+                processinfo->triggermode = PROCESSINFO_TRIGGERMODE_DELAY;
+                imgmon_sem_print(&semmon, &data.image[ID], wrow - 6);
+            }
+
             refresh();
         }
+        imgmon_instr_message(processinfo);
 
         if(++dispcnt > diplaycntinterval)
         {
@@ -203,6 +690,9 @@ static errno_t compute_function()
 
     INSERT_STD_PROCINFO_COMPUTEFUNC_END
 
+    imgmon_dash_close(&dash);
+    imsnapshot_free(&snap);
+
     endwin();
 
     DEBUG_TRACE_FEXIT();
@@ -229,14 +719,128 @@ CLIADDCMD_info__imagemon()
 
 
 
-errno_t printstatus(imageID ID)
+// summary screen statistics, inputs and results
+typedef struct
+{
+    IMSTATS_SAMPLE *sample; // NULL for full frame
+    IMHISTOGRAM    *histo;
+    long            nbbin;
+
+    IMSTATS  imstats;
+    double   median; // float images only
+    int      medianest; // median and histogram from a subsample
+    double   meanerr;
+    uint64_t nbtotal; // pixels of subset
+} IMGMON_STATS;
+
+// run by imsnapshot_run(), possibly several times per refresh
+static errno_t imgmon_stats_compute(IMAGE *image, void *arg)
+{
+    IMGMON_STATS   *stats       = (IMGMON_STATS *) arg;
+    IMSTATS_SAMPLE *sample      = stats->sample;
+    IMHISTOGRAM    *histo       = stats->histo;
+    IMAGE          *statimage   = image;
+    IMAGE           sampleimage;
+    IMAGE_METADATA  samplemd;
+    size_t          scratchmark = info_scratch_mark();
+
+    stats->median    = 0.0;
+    stats->medianest = 0;
+    stats->nbtotal   = image->md->nelement;
+    if(sample != NULL)
+    {
+        IMSTATS_SAMPLE  histosample = *sample;
+        IMSTATS_SAMPLE *gathered    = sample;
+
+        if(sample->stride == 1)
+        {
+            // box and mask read in place, median and histogram from at
+            // most IMGMON_HISTO_NBPIX pixels of the subset
+            imstats_sample_compute(image, sample, &stats->imstats);
+            stats->nbtotal =
+                stats->imstats.nelement + stats->imstats.nbnan;
+            imstats_sample_budget(image, &histosample, IMGMON_HISTO_NBPIX);
+            gathered         = &histosample;
+            stats->medianest = (histosample.stride > 1);
+        }
+
+        // sampled values, as a 1D double image
+        uint64_t maxsize = imstats_sample_maxsize(image, gathered);
+        double  *buf = (double *) info_scratch_alloc(sizeof(double) * maxsize);
+
+        memset(&sampleimage, 0, sizeof(IMAGE));
+        memset(&samplemd, 0, sizeof(IMAGE_METADATA));
+        samplemd.datatype   = _DATATYPE_DOUBLE;
+        samplemd.naxis      = 1;
+        samplemd.nelement   = imstats_sample_gather(image, gathered, buf);
+        samplemd.size[0]    = (uint32_t) samplemd.nelement;
+        samplemd.size[1]    = 1;
+        sampleimage.md      = &samplemd;
+        sampleimage.array.D = buf;
+        statimage           = &sampleimage;
+
+        if(sample->stride > 1)
+        {
+            // masked pixels of box, from the sampled fraction
+            stats->nbtotal = (uint64_t)((double) sample->xsize *
+                                        sample->ysize * samplemd.nelement /
+                                        maxsize);
+        }
+    }
+
+    // single pass over frame, no name lookup
+    if((sample == NULL) || (sample->stride > 1))
+    {
+        if(statimage->md->nelement > 0)
+        {
+            imstats_compute(statimage, &stats->imstats);
+        }
+        else
+        {
+            memset(&stats->imstats, 0, sizeof(IMSTATS));
+        }
+    }
+    stats->meanerr = imstats_sample_meanerr(&stats->imstats, stats->nbtotal);
+
+    if((image->md->datatype == _DATATYPE_FLOAT) &&
+            (statimage->md->nelement > 0))
+    {
+        double pmedian = 0.5;
+
+        image_percentiles(statimage, 1, &pmedian, &stats->median);
+    }
+
+    // histogram over final min/max range
+    if(histo->count == NULL)
+    {
+        histogram_init(histo,
+                       stats->nbbin,
+                       HISTOGRAM_RANGE_FIXED,
+                       HISTOGRAM_BINS_LINEAR,
+                       stats->imstats.min,
+                       stats->imstats.max);
+    }
+    histo->min = stats->imstats.min;
+    histo->max = stats->imstats.max;
+    image_histogram(statimage, histo, 0);
+
+    info_scratch_release(scratchmark);
+
+    return RETURN_SUCCESS;
+}
+
+
+
+errno_t printstatus(imageID           ID,
+                    STREAMRATE_STATE *ratestate,
+                    IMSTATS_SAMPLE   *sample,
+                    IMSNAPSHOT       *snap)
 {
     IMAGE *image = &data.image[ID];
 
     long          j;
-    double        frequ;
     long          NBhistopt = 20;
-    long         *vcnt;
+    static IMHISTOGRAM histo = {0}; // bins kept across refreshes
     long          h;
     unsigned long cnt;
     long          i;
@@ -246,13 +850,12 @@ errno_t printstatus(imageID ID)
     float  minPV = 60000;
     float  maxPV = 0;
     float charval;
-    double average;
     double imtotal;
+    IMSTATS imstats;
 
 
     char line1[200];
 
-    double tmp;
     double RMS = 0.0;
 
     static double RMS01 = 0.0;
@@ -295,22 +898,21 @@ errno_t printstatus(imageID ID)
     TUI_printfw("[status %2d] ", image->md->status);
 
     {
-        // timing and counters
-
-        struct timespec tnow;
-        struct timespec tdiff;
-        double          tdiffv;
+        // timing and counters, from writer timestamps
+        static const char *sourcename[] = {"-", "CB", "write", "clock"};
+        STREAMRATE         rate;
 
-        clock_gettime(CLOCK_REALTIME, &tnow);
-        tdiff = info_time_diff(tlast, tnow);
-        clock_gettime(CLOCK_REALTIME, &tlast);
+        streamrate_measure(image, ratestate, &rate);
 
-        tdiffv  = 1.0 * tdiff.tv_sec + 1.0e-9 * tdiff.tv_nsec;
-        frequ   = (image->md->cnt0 - cntlast) / tdiffv;
-        cntlast = image->md->cnt0;
-
-        TUI_printfw("[cnt0 %8d] [%6.2f Hz] ", image->md->cnt0, frequ);
+        TUI_printfw("[cnt0 %8d] [%8.2f Hz] ", image->md->cnt0, rate.frequ);
         TUI_printfw("[cnt1 %8d]\n", image->md->cnt1);
+        TUI_printfw("[dt min %9.3f  mean %9.3f  max %9.3f ms] "
+                    "[%5lu frames %5s]\n",
+                    1.0e3 * rate.dtmin,
+                    1.0e3 * rate.dtmean,
+                    1.0e3 * rate.dtmax,
+                    rate.nbframe,
+                    sourcename[rate.source]);
     }
 
 
@@ -354,304 +956,78 @@ errno_t printstatus(imageID ID)
 
     if(1)
     {
-        // image stats
-
-        average = arith_image_mean(image->name);
-
-        imtotal = arith_image_total(image->name);
-
-        if(datatype == _DATATYPE_FLOAT)
+        // image stats, computed before display, on a consistent frame
+        IMGMON_STATS stats;
+        stats.sample = sample;
+        stats.histo  = &histo;
+        stats.nbbin  = NBhistopt;
         {
-            TUI_printfw("median %12g   ", arith_image_median(image->name));
-        }
+            INFO_INSTR_SCOPE("imgmon.stats");
 
-        TUI_printfw("average %12g    total = %12g\n",
-                    imtotal / image->md->nelement,
-                    imtotal);
-
-        vcnt = (long *) malloc(sizeof(long) * NBhistopt);
-        if(vcnt == NULL)
-        {
-            PRINT_ERROR("malloc returns NULL pointer");
-            abort();
-        }
-        for(h = 0; h < NBhistopt; h++)
-        {
-            vcnt[h] = 0;
-        }
-
-        if(datatype == _DATATYPE_FLOAT)
-        {
-            minPV = image->array.F[0];
-            maxPV = minPV;
-
-            for(unsigned long ii = 0; ii < image->md->nelement; ii++)
-            {
-                if(image->array.F[ii] < minPV)
-                {
-                    minPV = image->array.F[ii];
-                }
-                if(image->array.F[ii] > maxPV)
-                {
-                    maxPV = image->array.F[ii];
-                }
-                tmp = (1.0 * image->array.F[ii] - average);
-                RMS += tmp * tmp;
-                h = (long)(1.0 * NBhistopt *
-                           ((float)(image->array.F[ii] - minPV)) /
-                           (maxPV - minPV));
-                if((h > -1) && (h < NBhistopt))
-                {
-                    vcnt[h]++;
-                }
-            }
+            imsnapshot_run(snap, image, imgmon_stats_compute, &stats);
         }
+        imstats          = stats.imstats;
+        double   median  = stats.median;
+        double   meanerr = stats.meanerr;
+        uint64_t nbtotal = stats.nbtotal;
 
-        if(datatype == _DATATYPE_DOUBLE)
+        if(sample == NULL)
         {
-            minPV = image->array.D[0];
-            maxPV = minPV;
-
-            for(unsigned long ii = 0; ii < image->md->nelement; ii++)
-            {
-                if(image->array.D[ii] < minPV)
-                {
-                    minPV = image->array.D[ii];
-                }
-                if(image->array.D[ii] > maxPV)
-                {
-                    maxPV = image->array.D[ii];
-                }
-                tmp = (1.0 * image->array.D[ii] - average);
-                RMS += tmp * tmp;
-                h = (long)(1.0 * NBhistopt *
-                           ((float)(image->array.D[ii] - minPV)) /
-                           (maxPV - minPV));
-                if((h > -1) && (h < NBhistopt))
-                {
-                    vcnt[h]++;
-                }
-            }
+            TUI_printfw("[stats full frame]\n");
         }
-
-        if(datatype == _DATATYPE_UINT8)
+        else
         {
-            minPV = image->array.UI8[0];
-            maxPV = minPV;
-
-            for(unsigned long ii = 0; ii < image->md->nelement; ii++)
-            {
-                if(image->array.UI8[ii] < minPV)
-                {
-                    minPV = image->array.UI8[ii];
-                }
-                if(image->array.UI8[ii] > maxPV)
-                {
-                    maxPV = image->array.UI8[ii];
-                }
-                tmp = (1.0 * image->array.UI8[ii] - average);
-                RMS += tmp * tmp;
-                h = (long)(1.0 * NBhistopt *
-                           ((float)(image->array.UI8[ii] - minPV)) /
-                           (maxPV - minPV));
-                if((h > -1) && (h < NBhistopt))
-                {
-                    vcnt[h]++;
-                }
-            }
+            TUI_printfw("[stats box %ux%u+%u+%u%s stride %u : %lu pixels]\n",
+                        sample->xsize,
+                        sample->ysize,
+                        sample->x0,
+                        sample->y0,
+                        (sample->mask == NULL) ? "" : " masked",
+                        sample->stride,
+                        imstats.nelement);
         }
 
-        if(datatype == _DATATYPE_UINT16)
+        if(snap->torn)
         {
-            minPV = image->array.UI16[0];
-            maxPV = minPV;
-
-            for(unsigned long ii = 0; ii < image->md->nelement; ii++)
-            {
-                if(image->array.UI16[ii] < minPV)
-                {
-                    minPV = image->array.UI16[ii];
-                }
-                if(image->array.UI16[ii] > maxPV)
-                {
-                    maxPV = image->array.UI16[ii];
-                }
-                tmp = (1.0 * image->array.UI16[ii] - average);
-                RMS += tmp * tmp;
-                h = (long)(1.0 * NBhistopt *
-                           ((float)(image->array.UI16[ii] - minPV)) /
-                           (maxPV - minPV));
-                if((h > -1) && (h < NBhistopt))
-                {
-                    vcnt[h]++;
-                }
-            }
+            attron(A_BOLD);
         }
-
-        if(datatype == _DATATYPE_UINT32)
+        TUI_printfw("[snapshot %s  retries %lu  copies %lu  torn %lu / %lu]\n",
+                    snap->torn ? "TORN" : "OK",
+                    snap->nbretry,
+                    snap->nbcopy,
+                    snap->nbtorn,
+                    snap->nbsnap);
+        if(snap->torn)
         {
-            minPV = image->array.UI32[0];
-            maxPV = minPV;
-
-            for(unsigned long ii = 0; ii < image->md->nelement; ii++)
-            {
-                if(image->array.UI32[ii] < minPV)
-                {
-                    minPV = image->array.UI32[ii];
-                }
-                if(image->array.UI32[ii] > maxPV)
-                {
-                    maxPV = image->array.UI32[ii];
-                }
-                tmp = (1.0 * image->array.UI32[ii] - average);
-                RMS += tmp * tmp;
-                h = (long)(1.0 * NBhistopt *
-                           ((float)(image->array.UI32[ii] - minPV)) /
-                           (maxPV - minPV));
-                if((h > -1) && (h < NBhistopt))
-                {
-                    vcnt[h]++;
-                }
-            }
+            attroff(A_BOLD);
         }
 
-        if(datatype == _DATATYPE_UINT64)
-        {
-            minPV = image->array.UI64[0];
-            maxPV = minPV;
-
-            for(unsigned long ii = 0; ii < image->md->nelement; ii++)
-            {
-                if(image->array.UI64[ii] < minPV)
-                {
-                    minPV = image->array.UI64[ii];
-                }
-                if(image->array.UI64[ii] > maxPV)
-                {
-                    maxPV = image->array.UI64[ii];
-                }
-                tmp = (1.0 * image->array.UI64[ii] - average);
-                RMS += tmp * tmp;
-                h = (long)(1.0 * NBhistopt *
-                           ((float)(image->array.UI64[ii] - minPV)) /
-                           (maxPV - minPV));
-                if((h > -1) && (h < NBhistopt))
-                {
-                    vcnt[h]++;
-                }
-            }
-        }
-
-        if(datatype == _DATATYPE_INT8)
-        {
-            minPV = image->array.SI8[0];
-            maxPV = minPV;
-
-            for(unsigned long ii = 0; ii < image->md->nelement; ii++)
-            {
-                if(image->array.SI8[ii] < minPV)
-                {
-                    minPV = image->array.SI8[ii];
-                }
-                if(image->array.SI8[ii] > maxPV)
-                {
-                    maxPV = image->array.SI8[ii];
-                }
-                tmp = (1.0 * image->array.SI8[ii] - average);
-                RMS += tmp * tmp;
-                h = (long)(1.0 * NBhistopt *
-                           ((float)(image->array.SI8[ii] - minPV)) /
-                           (maxPV - minPV));
-                if((h > -1) && (h < NBhistopt))
-                {
-                    vcnt[h]++;
-                }
-            }
-        }
-
-        if(datatype == _DATATYPE_INT16)
+        if(datatype == _DATATYPE_FLOAT)
         {
-            minPV = image->array.SI16[0];
-            maxPV = minPV;
-
-            for(unsigned long ii = 0; ii < image->md->nelement; ii++)
-            {
-                if(image->array.SI16[ii] < minPV)
-                {
-                    minPV = image->array.SI16[ii];
-                }
-                if(image->array.SI16[ii] > maxPV)
-                {
-                    maxPV = image->array.SI16[ii];
-                }
-                tmp = (1.0 * image->array.SI16[ii] - average);
-                RMS += tmp * tmp;
-                h = (long)(1.0 * NBhistopt *
-                           ((float)(image->array.SI16[ii] - minPV)) /
-                           (maxPV - minPV));
-                if((h > -1) && (h < NBhistopt))
-                {
-                    vcnt[h]++;
-                }
-            }
+            TUI_printfw("median %s%12g   ", stats.medianest ? "~" : "", median);
         }
 
-        if(datatype == _DATATYPE_INT32)
+        if(sample == NULL)
         {
-            minPV = image->array.SI32[0];
-            maxPV = minPV;
-
-            for(unsigned long ii = 0; ii < image->md->nelement; ii++)
-            {
-                if(image->array.SI32[ii] < minPV)
-                {
-                    minPV = image->array.SI32[ii];
-                }
-                if(image->array.SI32[ii] > maxPV)
-                {
-                    maxPV = image->array.SI32[ii];
-                }
-                tmp = (1.0 * image->array.SI32[ii] - average);
-                RMS += tmp * tmp;
-                h = (long)(1.0 * NBhistopt *
-                           ((float)(image->array.SI32[ii] - minPV)) /
-                           (maxPV - minPV));
-                if((h > -1) && (h < NBhistopt))
-                {
-                    vcnt[h]++;
-                }
-            }
+            imtotal = imstats.total;
+            TUI_printfw("average %12g    total = %12g\n",
+                        imtotal / image->md->nelement,
+                        imtotal);
         }
-
-        if(datatype == _DATATYPE_INT64)
+        else
         {
-            minPV = image->array.SI64[0];
-            maxPV = minPV;
-
-            for(unsigned long ii = 0; ii < image->md->nelement; ii++)
-            {
-                if(image->array.SI64[ii] < minPV)
-                {
-                    minPV = image->array.SI64[ii];
-                }
-                if(image->array.SI64[ii] > maxPV)
-                {
-                    maxPV = image->array.SI64[ii];
-                }
-                tmp = (1.0 * image->array.SI64[ii] - average);
-                RMS += tmp * tmp;
-                h = (long)(1.0 * NBhistopt *
-                           ((float)(image->array.SI64[ii] - minPV)) /
-                           (maxPV - minPV));
-                if((h > -1) && (h < NBhistopt))
-                {
-                    vcnt[h]++;
-                }
-            }
+            // total extrapolated to the subset
+            imtotal = imstats.mean * nbtotal;
+            TUI_printfw("average %12g +- %.3g (1 sigma)    total ~ %12g\n",
+                        imstats.mean,
+                        meanerr,
+                        imtotal);
         }
 
+        minPV = imstats.min;
+        maxPV = imstats.max;
+        RMS   = imstats.rmsdev;
 
-        RMS   = sqrt(RMS / image->md->nelement);
         RMS01 = 0.9 * RMS01 + 0.1 * RMS; // wut
 
         TUI_printfw("RMS = %12.6g     ->  %12.6g\n", RMS, RMS01);
@@ -666,9 +1042,9 @@ errno_t printstatus(imageID ID)
         {
             vcntmax = 0;
             for(h = 0; h < NBhistopt; h++)
-                if(vcnt[h] > vcntmax)
+                if((long) histo.count[h] > vcntmax)
                 {
-                    vcntmax = vcnt[h];
+                    vcntmax = histo.count[h];
                 }
 
             for(h = 0; h < NBhistopt; h++)
@@ -681,14 +1057,18 @@ errno_t printstatus(imageID ID)
                 }
                 sprintf(line1,
                         "[%12.4e - %12.4e] %7ld",
-                        (minPV + 1.0 * (maxPV - minPV) * h / NBhistopt),
-                        (minPV + 1.0 * (maxPV - minPV) * (h + 1) / NBhistopt),
-                        vcnt[h]);
+                        histogram_binedge(&histo, h),
+                        histogram_binedge(&histo, h + 1),
+                        (long) histo.count[h]);
 
                 TUI_printfw("%s", line1);
                 attron(COLOR_PAIR(customcolor));
 
-                cnt = vcnt[h] * (wcol - 2 - strlen(line1)) / vcntmax;
+                cnt = 0;
+                if(vcntmax > 0)
+                {
+                    cnt = histo.count[h] * (wcol - 2 - strlen(line1)) / vcntmax;
+                }
                 for(i = 0; i < cnt; ++i)
                 {
                     TUI_printfw(" ");
@@ -786,10 +1166,113 @@ errno_t printstatus(imageID ID)
                 }
             }
         }
+    }
+
+
+    return RETURN_SUCCESS;
+}
+
+
+
 
-        free(vcnt);
+// statistics over the last frames of the circular buffer, newest first
+errno_t printcbstats(imageID ID, long nbslot, int maxrow)
+{
+    IMAGE   *image = &data.image[ID];
+    uint64_t nelement = image->md->nelement;
+    CBSTATS  cbstats;
+
+    if(cbstats_nbslot(image) == 0)
+    {
+        TUI_printfw("stream %s has no circular buffer\n", image->name);
+        return RETURN_SUCCESS;
+    }
+
+    size_t   scratchmark = info_scratch_mark();
+    IMSTATS *framestats  = (IMSTATS *) info_scratch_alloc(
+                               sizeof(IMSTATS) * image->md->CBsize);
+    double  *tmean = (double *) info_scratch_alloc(sizeof(double) * nelement);
+    double  *trms  = (double *) info_scratch_alloc(sizeof(double) * nelement);
+
+    if(cbstats_compute(image, nbslot, framestats, tmean, trms, &cbstats) !=
+            RETURN_SUCCESS)
+    {
+        info_scratch_release(scratchmark);
+        return RETURN_FAILURE;
+    }
+
+    TUI_printfw("[circbuff %3u/%3u  %4lu]  %ld frames",
+                cbstats.CBindex,
+                image->md->CBsize,
+                cbstats.CBcycle,
+                cbstats.nbslot);
+    if(cbstats.nbtorn > 0)
+    {
+        attron(A_BOLD);
+        TUI_printfw("  %ld overwritten while read", cbstats.nbtorn);
+        attroff(A_BOLD);
+    }
+    TUI_newline();
+
+    print_header(" ALL FRAMES ", '-');
+    TUI_printfw("mean %12.6g   RMS %12.6g   min %12.6g   max %12.6g   "
+                "NaN %lu\n",
+                cbstats.total.mean,
+                cbstats.total.rmsdev,
+                cbstats.total.min,
+                cbstats.total.max,
+                cbstats.total.nbnan);
+
+    // temporal RMS map summary
+    double   trmstotal = 0.0;
+    uint64_t iitrmsmax = 0;
+    for(uint64_t ii = 0; ii < nelement; ii++)
+    {
+        trmstotal += trms[ii];
+        if(trms[ii] > trms[iitrmsmax])
+        {
+            iitrmsmax = ii;
+        }
+    }
+    TUI_printfw("temporal RMS   average %12.6g   max %12.6g at pixel %lu,%lu "
+                "(mean %g)\n",
+                trmstotal / nelement,
+                trms[iitrmsmax],
+                iitrmsmax % image->md->size[0],
+                iitrmsmax / image->md->size[0],
+                tmean[iitrmsmax]);
+
+    // time series of frame means, bar scaled to min-max of means
+    print_header(" FRAME MEANS ", '-');
+    double meanmin = INFINITY;
+    double meanmax = -INFINITY;
+    for(long k = 0; k < cbstats.nbslot; k++)
+    {
+        meanmin = fmin(meanmin, framestats[k].mean);
+        meanmax = fmax(meanmax, framestats[k].mean);
+    }
+    TUI_printfw("%5s %12s %12s %12s %12s\n", "age", "mean", "RMS", "min",
+                "max");
+    for(long age = 0; (age < cbstats.nbslot) && (age < maxrow); age++)
+    {
+        long k      = cbstats.nbslot - 1 - age;
+        int  nbchar = 0;
+        if(meanmax > meanmin)
+        {
+            nbchar = (int)(30.0 * (framestats[k].mean - meanmin) /
+                           (meanmax - meanmin));
+        }
+        TUI_printfw("%5ld %12.6g %12.6g %12.6g %12.6g |%.*s\n",
+                    age,
+                    framestats[k].mean,
+                    framestats[k].rmsdev,
+                    framestats[k].min,
+                    framestats[k].max,
+                    nbchar,
+                    "##############################");
     }
 
+    info_scratch_release(scratchmark);
 
     return RETURN_SUCCESS;
 }
@@ -0,0 +1,262 @@
+/**
+ * @file    imagemon_dash.c
+ * @brief   image monitor dashboard : one table row per stream
+ *
+ * Streams are given as a list separated by commas or spaces. Entries with
+ * wildcards (* ? [) are matched against the streams of the shared memory
+ * directory, for example "aol0_*,dm00disp". All streams are sampled in the
+ * monitor loop, one health sample each (streamhealth.c) per refresh.
+ */
+
+#include <glob.h>
+#include <math.h>
+#include <ncurses.h>
+
+#include "CommandLineInterface/CLIcore.h"
+
+#include "COREMOD_memory/COREMOD_memory.h"
+#include "imagemon_dash.h"
+#include "info_instr.h"
+#include "streamhealth.h"
+
+#include "TUItools.h"
+
+// shared memory file name suffix of streams
+#define IMGMON_DASH_SHMSUFFIX ".im.shm"
+
+// add stream name to dashboard, skipped if it cannot be loaded
+static void imgmon_dash_add(IMGMON_DASH *dash, const char *name)
+{
+    imageID ID = image_ID(name);
+
+    if(ID == -1)
+    {
+        ID = read_sharedmem_image(name);
+    }
+    if(ID == -1)
+    {
+        PRINT_WARNING("stream %s not found", name);
+        return;
+    }
+    for(long i = 0; i < dash->nbstream; i++)
+    {
+        if(dash->stream[i].ID == ID)
+        {
+            return;
+        }
+    }
+
+    dash->stream = (IMGMON_DASH_STREAM *) realloc(
+                       dash->stream,
+                       sizeof(IMGMON_DASH_STREAM) * (dash->nbstream + 1));
+    if(dash->stream == NULL)
+    {
+        PRINT_ERROR("realloc returns NULL pointer");
+        abort();
+    }
+
+    IMGMON_DASH_STREAM *stream = &dash->stream[dash->nbstream];
+    stream->ID                 = ID;
+    memset(&stream->state, 0, sizeof(STREAMHEALTH_STATE));
+    stream->health = (double *) malloc(
+                         sizeof(double) * streamhealth_size(&data.image[ID]));
+    if(stream->health == NULL)
+    {
+        PRINT_ERROR("malloc returns NULL pointer");
+        abort();
+    }
+    for(long k = 0; k < STREAMHEALTH_NBFIELD; k++)
+    {
+        stream->health[k] = NAN;
+    }
+    dash->nbstream++;
+}
+
+/**
+ * @brief Load streams of streamlist
+ *
+ * Wildcard entries are matched in the shared memory directory, in
+ * alphabetical order.
+ */
+errno_t imgmon_dash_open(IMGMON_DASH *dash, const char *streamlist)
+{
+    char  list[STRINGMAXLEN_DEFAULT];
+    char *saveptr;
+
+    dash->nbstream = 0;
+    dash->stream   = NULL;
+
+    strncpy(list, streamlist, STRINGMAXLEN_DEFAULT - 1);
+    list[STRINGMAXLEN_DEFAULT - 1] = '\0';
+
+    for(char *entry = strtok_r(list, ", ", &saveptr); entry != NULL;
+            entry      = strtok_r(NULL, ", ", &saveptr))
+    {
+        if(strpbrk(entry, "*?[") == NULL)
+        {
+            imgmon_dash_add(dash, entry);
+            continue;
+        }
+
+        char   pattern[STRINGMAXLEN_FULLFILENAME];
+        glob_t globbuf;
+
+        WRITE_FULLFILENAME(pattern,
+                           "%s/%s%s",
+                           data.shmdir,
+                           entry,
+                           IMGMON_DASH_SHMSUFFIX);
+        if(glob(pattern, 0, NULL, &globbuf) != 0)
+        {
+            PRINT_WARNING("no stream matches %s", entry);
+            continue;
+        }
+        for(size_t i = 0; i < globbuf.gl_pathc; i++)
+        {
+            char  name[STRINGMAXLEN_IMGNAME];
+            char *fname = strrchr(globbuf.gl_pathv[i], '/');
+
+            fname = (fname == NULL) ? globbuf.gl_pathv[i] : fname + 1;
+            WRITE_IMAGENAME(name,
+                            "%.*s",
+                            (int)(strlen(fname) - strlen(IMGMON_DASH_SHMSUFFIX)),
+                            fname);
+            imgmon_dash_add(dash, name);
+        }
+        globfree(&globbuf);
+    }
+
+    return RETURN_SUCCESS;
+}
+
+void imgmon_dash_close(IMGMON_DASH *dash)
+{
+    for(long i = 0; i < dash->nbstream; i++)
+    {
+        streamhealth_free(&dash->stream[i].state);
+        free(dash->stream[i].health);
+    }
+    free(dash->stream);
+    dash->stream   = NULL;
+    dash->nbstream = 0;
+}
+
+/**
+ * @brief New health sample of each stream
+ */
+errno_t imgmon_dash_update(IMGMON_DASH *dash, int stats)
+{
+    INFO_INSTR_SCOPE("imgmon_dash_update");
+
+    for(long i = 0; i < dash->nbstream; i++)
+    {
+        IMGMON_DASH_STREAM *stream = &dash->stream[i];
+
+        streamhealth_sample(&data.image[stream->ID],
+                            &stream->state,
+                            stats,
+                            stream->health);
+    }
+
+    return RETURN_SUCCESS;
+}
+
+/**
+ * @brief Print table, at most maxrow streams
+ *
+ * Streams with unread frames on a semaphore, or without new frame since
+ * previous sample, are shown in bold.
+ */
+errno_t imgmon_dash_print(IMGMON_DASH *dash, int stats, int maxrow)
+{
+    TUI_printfw("%ld streams, pixel statistics %s\n",
+                dash->nbstream,
+                (stats == 1) ? "on" : "off");
+    TUI_printfw("%-24s %-6s %-16s %12s %10s %2s %4s %9s",
+                "stream",
+                "type",
+                "size",
+                "cnt0",
+                "rate[Hz]",
+                "w",
+                "sem",
+                "CB");
+    if(stats == 1)
+    {
+        TUI_printfw(" %12s %12s %12s %12s", "min", "max", "mean", "rms");
+    }
+    TUI_newline();
+
+    for(long i = 0; (i < dash->nbstream) && (i < maxrow); i++)
+    {
+        IMAGE  *image  = &data.image[dash->stream[i].ID];
+        double *health = dash->stream[i].health;
+        char    sizestr[32];
+        char    cbstr[32];
+        int     alert  = (health[STREAMHEALTH_SEMMAX] > 0) ||
+                         (health[STREAMHEALTH_FREQU] == 0.0);
+
+        if(image->md[0].naxis == 3)
+        {
+            snprintf(sizestr,
+                     sizeof(sizestr),
+                     "%ux%ux%u",
+                     image->md[0].size[0],
+                     image->md[0].size[1],
+                     image->md[0].size[2]);
+        }
+        else
+        {
+            snprintf(sizestr,
+                     sizeof(sizestr),
+                     "%ux%u",
+                     image->md[0].size[0],
+                     (image->md[0].naxis < 2) ? 1 : image->md[0].size[1]);
+        }
+        if(image->md[0].CBsize > 0)
+        {
+            snprintf(cbstr,
+                     sizeof(cbstr),
+                     "%.0f/%.0f",
+                     health[STREAMHEALTH_CBINDEX],
+                     health[STREAMHEALTH_CBSIZE]);
+        }
+        else
+        {
+            snprintf(cbstr, sizeof(cbstr), "-");
+        }
+
+        if(alert)
+        {
+            attron(A_BOLD);
+        }
+        TUI_printfw("%-24.24s %-6.6s %-16.16s %12.0f %10.2f %2.0f %4.0f %9s",
+                    image->md[0].name,
+                    ImageStreamIO_typename(image->md[0].datatype),
+                    sizestr,
+                    health[STREAMHEALTH_CNT0],
+                    health[STREAMHEALTH_FREQU],
+                    health[STREAMHEALTH_WRITE],
+                    health[STREAMHEALTH_SEMMAX],
+                    cbstr);
+        if(stats == 1)
+        {
+            TUI_printfw(" %12.5g %12.5g %12.5g %12.5g",
+                        health[STREAMHEALTH_MIN],
+                        health[STREAMHEALTH_MAX],
+                        health[STREAMHEALTH_MEAN],
+                        health[STREAMHEALTH_RMS]);
+        }
+        if(alert)
+        {
+            attroff(A_BOLD);
+        }
+        TUI_newline();
+    }
+    if(dash->nbstream > maxrow)
+    {
+        TUI_printfw("... %ld more\n", dash->nbstream - maxrow);
+    }
+
+    return RETURN_SUCCESS;
+}
@@ -0,0 +1,31 @@
+/**
+ * @file    imagemon_dash.h
+ */
+
+#ifndef _INFO_IMAGEMON_DASH_H
+#define _INFO_IMAGEMON_DASH_H
+
+#include "streamhealth.h"
+
+typedef struct
+{
+    imageID            ID;
+    STREAMHEALTH_STATE state;
+    double            *health; // [streamhealth_size()]
+} IMGMON_DASH_STREAM;
+
+typedef struct
+{
+    long                nbstream;
+    IMGMON_DASH_STREAM *stream;
+} IMGMON_DASH;
+
+errno_t imgmon_dash_open(IMGMON_DASH *dash, const char *streamlist);
+
+void imgmon_dash_close(IMGMON_DASH *dash);
+
+errno_t imgmon_dash_update(IMGMON_DASH *dash, int stats);
+
+errno_t imgmon_dash_print(IMGMON_DASH *dash, int stats, int maxrow);
+
+#endif
@@ -0,0 +1,209 @@
+/**
+ * @file    imagemon_heatmap.c
+ * @brief   image monitor heatmap : frame reduced to the terminal size
+ *
+ * The frame is block-reduced (imdecimate.c) to the terminal size, and each
+ * character cell shows two pixels with the upper half block character :
+ * upper pixel as foreground color, lower pixel as background color.
+ * Terminals with fewer than 256 colors get one pixel per cell, as an ASCII
+ * intensity ramp.
+ */
+
+#include <math.h>
+#include <ncurses.h>
+
+#include "CommandLineInterface/CLIcore.h"
+
+#include "imagemon_heatmap.h"
+#include "imdecimate.h"
+#include "imstats.h"
+#include "info_instr.h"
+#include "info_scratch.h"
+
+#include "TUItools.h"
+
+// color pairs used, above those of the TUI
+#define IMGMON_HEATMAP_PAIRBASE 32
+
+// palette : black, red, yellow, white (xterm 256 color indices)
+static const short heatmap_palette[] =
+{16, 52, 88, 124, 160, 196, 202, 208, 214, 220, 226, 231};
+#define IMGMON_HEATMAP_NBLEVEL                                                 \
+    ((int)(sizeof(heatmap_palette) / sizeof(heatmap_palette[0])))
+
+static const char heatmap_ramp[] = " .:-=+*#%@";
+
+static const char *heatmap_scalename[] = {"linear", "log", "1-99%"};
+
+// one color pair per foreground and background level
+static int imgmon_heatmap_initcolor()
+{
+    static int colorOK = -1;
+
+    if(colorOK != -1)
+    {
+        return colorOK;
+    }
+    colorOK = (has_colors() && (COLORS >= 256) &&
+               (COLOR_PAIRS > IMGMON_HEATMAP_PAIRBASE +
+                IMGMON_HEATMAP_NBLEVEL * IMGMON_HEATMAP_NBLEVEL));
+    if(colorOK)
+    {
+        for(int fg = 0; fg < IMGMON_HEATMAP_NBLEVEL; fg++)
+        {
+            for(int bg = 0; bg < IMGMON_HEATMAP_NBLEVEL; bg++)
+            {
+                init_pair(IMGMON_HEATMAP_PAIRBASE +
+                          fg * IMGMON_HEATMAP_NBLEVEL + bg,
+                          heatmap_palette[fg],
+                          heatmap_palette[bg]);
+            }
+        }
+    }
+    return colorOK;
+}
+
+// level 0 to nblevel-1 of value v, NaN at level 0
+static int imgmon_heatmap_level(float  v,
+                                double vmin,
+                                double vmax,
+                                int    scale,
+                                int    nblevel)
+{
+    if(isnan(v) || !(vmax > vmin))
+    {
+        return 0;
+    }
+
+    double u = (v - vmin) / (vmax - vmin);
+    u        = (u < 0.0) ? 0.0 : ((u > 1.0) ? 1.0 : u);
+    if(scale == IMGMON_HEATMAP_LOG)
+    {
+        u = log10(1.0 + 999.0 * u) / 3.0;
+    }
+
+    int level = (int)(u * nblevel);
+    return (level < nblevel) ? level : nblevel - 1;
+}
+
+/**
+ * @brief Print heatmap of image within nbrow x nbcol character cells
+ *
+ * decimmode is IMDECIMATE_MEAN or IMDECIMATE_MAX.
+ */
+errno_t imgmon_heatmap_print(IMAGE   *image,
+                             int      decimmode,
+                             int      scale,
+                             uint16_t nbrow,
+                             uint16_t nbcol)
+{
+    INFO_INSTR_SCOPE("imgmon_heatmap_print");
+
+    int      halfblock = imgmon_heatmap_initcolor();
+    uint32_t outxsize;
+    uint32_t outysize;
+
+    if((nbrow < 2) || (nbcol < 2))
+    {
+        return RETURN_SUCCESS;
+    }
+
+    // square pixels : two per cell vertically
+    imdecimate_size(image, nbcol - 1, 2 * (nbrow - 1), &outxsize, &outysize);
+
+    size_t scratchmark = info_scratch_mark();
+    float *map         = (float *) info_scratch_alloc(sizeof(float) *
+                                                      outxsize * outysize);
+
+    if(image_decimate(image, outxsize, outysize, decimmode, map) !=
+            RETURN_SUCCESS)
+    {
+        info_scratch_release(scratchmark);
+        return RETURN_FAILURE;
+    }
+
+    double vmin = INFINITY;
+    double vmax = -INFINITY;
+    if(scale == IMGMON_HEATMAP_PERCENTILE)
+    {
+        double perc[2] = {0.01, 0.99};
+        double val[2];
+
+        percentile_array(map,
+                         _DATATYPE_FLOAT,
+                         (uint64_t) outxsize * outysize,
+                         2,
+                         perc,
+                         val);
+        vmin = val[0];
+        vmax = val[1];
+    }
+    else
+    {
+        for(uint64_t ii = 0; ii < (uint64_t) outxsize * outysize; ii++)
+        {
+            vmin = (map[ii] < vmin) ? map[ii] : vmin;
+            vmax = (map[ii] > vmax) ? map[ii] : vmax;
+        }
+    }
+
+    TUI_printfw("[%s %ux%u of %ux%lu]  [%s %g .. %g]  "
+                "m : mean/max  s : scale\n",
+                (decimmode == IMDECIMATE_MAX) ? "max" : "mean",
+                outxsize,
+                outysize,
+                image->md[0].size[0],
+                image->md[0].nelement / image->md[0].size[0],
+                heatmap_scalename[scale],
+                vmin,
+                vmax);
+
+    for(uint32_t jo = 0; jo < outysize; jo += 2)
+    {
+        const float *row1 = map + (uint64_t) jo * outxsize;
+        const float *row2 = (jo + 1 < outysize) ? row1 + outxsize : NULL;
+        int          pair = -1;
+
+        for(uint32_t io = 0; io < outxsize; io++)
+        {
+            if(halfblock)
+            {
+                int fg = imgmon_heatmap_level(row1[io], vmin, vmax, scale,
+                                              IMGMON_HEATMAP_NBLEVEL);
+                int bg = (row2 == NULL) ? 0 :
+                         imgmon_heatmap_level(row2[io], vmin, vmax, scale,
+                                              IMGMON_HEATMAP_NBLEVEL);
+                int newpair = IMGMON_HEATMAP_PAIRBASE +
+                              fg * IMGMON_HEATMAP_NBLEVEL + bg;
+
+                if(newpair != pair)
+                {
+                    attron(COLOR_PAIR(newpair));
+                    pair = newpair;
+                }
+                addstr("▀");
+            }
+            else
+            {
+                float v = (row2 == NULL) ? row1[io]
+                          : 0.5f * (row1[io] + row2[io]);
+
+                addch(heatmap_ramp[imgmon_heatmap_level(
+                                       v,
+                                       vmin,
+                                       vmax,
+                                       scale,
+                                       (int) strlen(heatmap_ramp))]);
+            }
+        }
+        if(pair != -1)
+        {
+            attroff(COLOR_PAIR(pair));
+        }
+        TUI_newline();
+    }
+
+    info_scratch_release(scratchmark);
+
+    return RETURN_SUCCESS;
+}
@@ -0,0 +1,20 @@
+/**
+ * @file    imagemon_heatmap.h
+ */
+
+#ifndef _INFO_IMAGEMON_HEATMAP_H
+#define _INFO_IMAGEMON_HEATMAP_H
+
+// intensity scaling
+#define IMGMON_HEATMAP_LINEAR     0 // min to max
+#define IMGMON_HEATMAP_LOG        1 // min to max, 3 decades
+#define IMGMON_HEATMAP_PERCENTILE 2 // 1% to 99% percentiles, linear
+#define IMGMON_HEATMAP_NBSCALE    3
+
+errno_t imgmon_heatmap_print(IMAGE   *image,
+                             int      decimmode,
+                             int      scale,
+                             uint16_t nbrow,
+                             uint16_t nbcol);
+
+#endif
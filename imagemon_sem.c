@@ -0,0 +1,269 @@
+/**
+ * @file    imagemon_sem.c
+ * @brief   image monitor semaphore screen : backlog and reader lag
+ *
+ * A semaphore value is the number of frames posted and not yet waited for
+ * by its reader. Values are sampled at each refresh and kept over the last
+ * IMGMON_SEM_NBSAMPLE refreshes : the growth rate, least-squares slope of
+ * the value over that window, is how fast the reader falls behind the
+ * writer.
+ *
+ * Reader and writer PIDs are resolved to process name and CPU affinity
+ * from /proc, and flagged if the process no longer exists.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <string.h>
+#include <ncurses.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+
+#include "CommandLineInterface/CLIcore.h"
+
+#include "imagemon_sem.h"
+
+#include "TUItools.h"
+
+// history characters, lowest to highest value
+static const char sem_ramp[] = " .:-=+*#";
+
+/**
+ * @brief Sample semaphore values of image
+ */
+void imgmon_sem_update(IMGMON_SEM *semmon, IMAGE *image)
+{
+    struct timespec t;
+    long            k = semmon->nbsample % IMGMON_SEM_NBSAMPLE;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    for(int s = 0; (s < image->md[0].sem) && (s < IMAGE_NB_SEMAPHORE); s++)
+    {
+        int semval = 0;
+
+        sem_getvalue(image->semptr[s], &semval);
+        semmon->sem[s].value[k] = semval;
+        semmon->sem[s].t[k]     = t.tv_sec + 1.0e-9 * t.tv_nsec;
+    }
+    semmon->nbsample++;
+}
+
+// value growth rate over history [1/s], least-squares slope
+static double imgmon_sem_growth(IMGMON_SEM_HISTORY *hist, long nbsample)
+{
+    double tmean = 0.0;
+    double vmean = 0.0;
+    double stt   = 0.0;
+    double stv   = 0.0;
+
+    if(nbsample < 2)
+    {
+        return 0.0;
+    }
+    for(long k = 0; k < nbsample; k++)
+    {
+        tmean += hist->t[k];
+        vmean += hist->value[k];
+    }
+    tmean /= nbsample;
+    vmean /= nbsample;
+    for(long k = 0; k < nbsample; k++)
+    {
+        double dt = hist->t[k] - tmean;
+
+        stt += dt * dt;
+        stv += dt * (hist->value[k] - vmean);
+    }
+
+    return (stt > 0.0) ? stv / stt : 0.0;
+}
+
+// CPU affinity of pid as a list, for example 0-3,8
+static void imgmon_sem_cpulist(pid_t pid, char *str, size_t strsize)
+{
+    cpu_set_t cpuset;
+    size_t    len = 0;
+
+    snprintf(str, strsize, "?");
+    if(sched_getaffinity(pid, sizeof(cpu_set_t), &cpuset) != 0)
+    {
+        return;
+    }
+    str[0] = '\0';
+    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if(!CPU_ISSET(cpu, &cpuset))
+        {
+            continue;
+        }
+        int cpuend = cpu;
+        while((cpuend + 1 < CPU_SETSIZE) && CPU_ISSET(cpuend + 1, &cpuset))
+        {
+            cpuend++;
+        }
+        int n = (cpuend > cpu)
+                ? snprintf(str + len, strsize - len, "%s%d-%d",
+                           (len > 0) ? "," : "", cpu, cpuend)
+                : snprintf(str + len, strsize - len, "%s%d",
+                           (len > 0) ? "," : "", cpu);
+        if((n < 0) || (len + n >= strsize))
+        {
+            break;
+        }
+        len += n;
+        cpu = cpuend;
+    }
+}
+
+// process name and CPU affinity of pid
+// returns 1 if running, 0 if dead, -1 if no pid
+static int imgmon_sem_procinfo(pid_t  pid,
+                               char  *name,
+                               size_t namesize,
+                               char  *cpus,
+                               size_t cpusize)
+{
+    snprintf(name, namesize, "-");
+    snprintf(cpus, cpusize, "-");
+    if(pid <= 0)
+    {
+        return -1;
+    }
+    if((kill(pid, 0) != 0) && (errno != EPERM))
+    {
+        snprintf(name, namesize, "DEAD");
+        return 0;
+    }
+
+    char  fname[64];
+    FILE *fp;
+
+    snprintf(fname, sizeof(fname), "/proc/%d/comm", (int) pid);
+    fp = fopen(fname, "r");
+    if(fp != NULL)
+    {
+        if(fgets(name, (int) namesize, fp) != NULL)
+        {
+            name[strcspn(name, "\n")] = '\0';
+        }
+        fclose(fp);
+    }
+    imgmon_sem_cpulist(pid, cpus, cpusize);
+
+    return 1;
+}
+
+/**
+ * @brief Print one row per semaphore, at most maxrow
+ *
+ * Semaphores with a growing backlog, or a dead reader, are shown in bold.
+ */
+errno_t imgmon_sem_print(IMGMON_SEM *semmon, IMAGE *image, int maxrow)
+{
+    long nbsample = (semmon->nbsample < IMGMON_SEM_NBSAMPLE)
+                    ? semmon->nbsample : IMGMON_SEM_NBSAMPLE;
+    long klast    = (semmon->nbsample - 1) % IMGMON_SEM_NBSAMPLE;
+    int  nbsem    = (image->md[0].sem < IMAGE_NB_SEMAPHORE)
+                    ? image->md[0].sem : IMAGE_NB_SEMAPHORE;
+
+    if(nbsample == 0)
+    {
+        return RETURN_SUCCESS;
+    }
+
+    // writer, usually the same process for all semaphores
+    {
+        char name[32];
+        char cpus[64];
+        int  alive = imgmon_sem_procinfo(image->semWritePID[0],
+                                         name,
+                                         sizeof(name),
+                                         cpus,
+                                         sizeof(cpus));
+
+        if(alive == 0)
+        {
+            attron(A_BOLD);
+        }
+        TUI_printfw("writer  %7d %-16s cpus %-12s   %ld samples\n",
+                    (int) image->semWritePID[0],
+                    name,
+                    cpus,
+                    nbsample);
+        if(alive == 0)
+        {
+            attroff(A_BOLD);
+        }
+    }
+
+    TUI_printfw("%3s %6s %6s %10s  %-32s %7s %-16s %-12s",
+                "sem",
+                "value",
+                "max",
+                "growth/s",
+                "history",
+                "reader",
+                "name",
+                "cpus");
+    TUI_newline();
+
+    for(int s = 0; (s < nbsem) && (s < maxrow); s++)
+    {
+        IMGMON_SEM_HISTORY *hist = &semmon->sem[s];
+        double growth = imgmon_sem_growth(hist, nbsample);
+        int    vmax   = 0;
+        char   history[IMGMON_SEM_NBSAMPLE + 1];
+        char   name[32];
+        char   cpus[64];
+
+        for(long k = 0; k < nbsample; k++)
+        {
+            vmax = (hist->value[k] > vmax) ? hist->value[k] : vmax;
+        }
+
+        // last 32 samples, oldest first, scaled to window maximum
+        long nbhist = (nbsample < 32) ? nbsample : 32;
+        for(long n = 0; n < nbhist; n++)
+        {
+            long k = (klast - (nbhist - 1 - n) + IMGMON_SEM_NBSAMPLE) %
+                     IMGMON_SEM_NBSAMPLE;
+            int  level =
+                (vmax > 0)
+                ? (int)((double) hist->value[k] * (sizeof(sem_ramp) - 2) / vmax)
+                : 0;
+            history[n] = sem_ramp[level];
+        }
+        history[nbhist] = '\0';
+
+        int alive = imgmon_sem_procinfo(image->semReadPID[s],
+                                        name,
+                                        sizeof(name),
+                                        cpus,
+                                        sizeof(cpus));
+        int alert = (alive == 0) ||
+                    ((growth > 0.0) && (hist->value[klast] > 0));
+
+        if(alert)
+        {
+            attron(A_BOLD);
+        }
+        TUI_printfw("%3d %6d %6d %10.2f  %-32s %7d %-16s %-12s",
+                    s,
+                    hist->value[klast],
+                    vmax,
+                    growth,
+                    history,
+                    (int) image->semReadPID[s],
+                    name,
+                    cpus);
+        if(alert)
+        {
+            attroff(A_BOLD);
+        }
+        TUI_newline();
+    }
+
+    return RETURN_SUCCESS;
+}
@@ -0,0 +1,27 @@
+/**
+ * @file    imagemon_sem.h
+ */
+
+#ifndef _INFO_IMAGEMON_SEM_H
+#define _INFO_IMAGEMON_SEM_H
+
+// semaphore values kept per semaphore
+#define IMGMON_SEM_NBSAMPLE 64
+
+typedef struct
+{
+    int    value[IMGMON_SEM_NBSAMPLE];
+    double t[IMGMON_SEM_NBSAMPLE]; // CLOCK_MONOTONIC [s]
+} IMGMON_SEM_HISTORY;
+
+typedef struct
+{
+    long               nbsample; // samples taken, history is circular
+    IMGMON_SEM_HISTORY sem[IMAGE_NB_SEMAPHORE];
+} IMGMON_SEM;
+
+void imgmon_sem_update(IMGMON_SEM *semmon, IMAGE *image);
+
+errno_t imgmon_sem_print(IMGMON_SEM *semmon, IMAGE *image, int maxrow);
+
+#endif
@@ -0,0 +1,792 @@
+/**
+ * @file    imbackground.c
+ * @brief   robust background and noise estimation
+ *
+ * Median, median absolute deviation (MAD) and iterative sigma-clipping,
+ * without sorting :
+ * - integer images with a value range not much larger than the number of
+ *   pixels use a histogram with unit bins. Quantiles and MAD are then read
+ *   from cumulative counts, and clipping only narrows the bin range.
+ * - other images use quickselect on a copy of the pixel values, O(n) per
+ *   quantile.
+ * Both give the same result, quantile k of n values being the value of
+ * rank k = (long) (p n) as in percentile.c.
+ *
+ * sigmalowq is computed before clipping from quantiles F(-1.3 sig) and
+ * F(-0.3 sig) of the normal distribution, as in the former
+ * background_photon_noise(). It only uses the lower part of the
+ * distribution, so it is insensitive to sources.
+ *
+ * Tile mode computes the background and noise in each tile of a grid, tiles
+ * being processed in parallel by the worker pool.
+ */
+
+#include <math.h>
+#include <stdatomic.h>
+
+#include "CommandLineInterface/CLIcore.h"
+
+#include "COREMOD_memory/COREMOD_memory.h"
+
+#include "imbackground.h"
+#include "info_instr.h"
+#include "info_pool.h"
+#include "info_scratch.h"
+
+// MAD to standard deviation, normal distribution
+#define IMBKG_MAD2SIGMA 1.482602218505602
+
+// normal distribution repartition function F(-1.3) and F(-0.3)
+#define IMBKG_F_M13 0.0968004845855
+#define IMBKG_F_M03 0.382088577811
+
+// largest histogram, in bins
+#define IMBKG_HISTSIZE_MAX (1 << 20)
+
+// minimum number of pixels per thread
+#define IMBKG_NBPIX_THREAD 65536
+
+// Local variables pointers
+static char     *instreamname;
+static char     *outstreamname;
+static uint32_t *tilexsize;
+static uint32_t *tileysize;
+static double   *nsigmaclip;
+static uint32_t *maxiterclip;
+
+static CLICMDARGDEF farg[] =
+{
+    {
+        CLIARG_IMG,
+        ".insname",
+        "input stream",
+        "im1",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &instreamname,
+        NULL
+    },
+    {
+        CLIARG_STR,
+        ".outsname",
+        "output background map",
+        "im1bkg",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &outstreamname,
+        NULL
+    },
+    {
+        CLIARG_UINT32,
+        ".tilexsize",
+        "tile x size, 0 for full frame",
+        "64",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &tilexsize,
+        NULL
+    },
+    {
+        CLIARG_UINT32,
+        ".tileysize",
+        "tile y size, 0 for full frame",
+        "64",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &tileysize,
+        NULL
+    },
+    {
+        CLIARG_FLOAT64,
+        ".nsigma",
+        "clipping threshold [sigma], 0 for no clipping",
+        "3.0",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &nsigmaclip,
+        NULL
+    },
+    {
+        CLIARG_UINT32,
+        ".maxiter",
+        "maximum number of clipping iterations",
+        "5",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &maxiterclip,
+        NULL
+    }
+};
+
+static CLICMDDATA CLIcmddata =
+{
+    "imbkg", "robust background and noise of image stream",
+    CLICMD_FIELDS_DEFAULTS
+};
+
+// detailed help
+static errno_t help_function()
+{
+    printf("Background (median) and noise (1.4826 MAD) per tile, after "
+           "sigma-clipping\n");
+    printf("Output : <outsname> background map, <outsname>noise noise map\n");
+    printf("Tile size 0 along an axis uses the full frame along that axis\n");
+
+    return RETURN_SUCCESS;
+}
+
+// work buffers, from the scratch arena of the calling thread
+typedef struct
+{
+    double   *a;
+    double   *d;
+    uint64_t *hist;
+} IMBKG_WORK;
+
+static inline int imbkg_isinteger(uint8_t datatype)
+{
+    return (datatype != _DATATYPE_FLOAT) && (datatype != _DATATYPE_DOUBLE);
+}
+
+/**
+ * @brief k-th smallest value, quickselect
+ *
+ * Reorders a so that a[k] is in sorted position, smaller values before it,
+ * larger values after it.
+ */
+static double imbkg_select(double *a, uint64_t n, uint64_t k)
+{
+    int64_t lo = 0;
+    int64_t hi = (int64_t) n - 1;
+
+    while(hi > lo)
+    {
+        int64_t mid = lo + (hi - lo) / 2;
+        double  tmp;
+
+        // median of 3 pivot, also sentinels for the partition loops
+        if(a[mid] < a[lo])
+        {
+            tmp    = a[mid];
+            a[mid] = a[lo];
+            a[lo]  = tmp;
+        }
+        if(a[hi] < a[lo])
+        {
+            tmp   = a[hi];
+            a[hi] = a[lo];
+            a[lo] = tmp;
+        }
+        if(a[hi] < a[mid])
+        {
+            tmp    = a[hi];
+            a[hi]  = a[mid];
+            a[mid] = tmp;
+        }
+        double pivot = a[mid];
+
+        int64_t i = lo;
+        int64_t j = hi;
+        while(i <= j)
+        {
+            while(a[i] < pivot)
+            {
+                i++;
+            }
+            while(a[j] > pivot)
+            {
+                j--;
+            }
+            if(i <= j)
+            {
+                tmp  = a[i];
+                a[i] = a[j];
+                a[j] = tmp;
+                i++;
+                j--;
+            }
+        }
+
+        if((int64_t) k <= j)
+        {
+            hi = j;
+        }
+        else if((int64_t) k >= i)
+        {
+            lo = i;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    return a[k];
+}
+
+// background of n values in work->a, reordered and overwritten
+static void imbkg_from_array(IMBKG_WORK   *work,
+                             uint64_t      n,
+                             double        nsigma,
+                             int           maxiter,
+                             IMBACKGROUND *bkg)
+{
+    double *a = work->a;
+    double *d = work->d;
+
+    uint64_t k13 = (uint64_t)(IMBKG_F_M13 * n);
+    uint64_t k03 = (uint64_t)(IMBKG_F_M03 * n);
+    double   q13 = imbkg_select(a, n, k13);
+    double   q03 = imbkg_select(a + k13, n - k13, k03 - k13);
+    bkg->sigmalowq = (q03 - q13) / (1.3 - 0.3);
+
+    bkg->nbiter = 0;
+    for(;;)
+    {
+        bkg->median = imbkg_select(a, n, n / 2);
+        double median = bkg->median;
+        #pragma omp simd
+        for(uint64_t i = 0; i < n; i++)
+        {
+            d[i] = fabs(a[i] - median);
+        }
+        bkg->mad   = imbkg_select(d, n, n / 2);
+        bkg->sigma = IMBKG_MAD2SIGMA * bkg->mad;
+        bkg->nbpix = n;
+
+        if((nsigma <= 0.0) || (bkg->nbiter == maxiter))
+        {
+            break;
+        }
+
+        double   lim = nsigma * bkg->sigma;
+        uint64_t m   = 0;
+        for(uint64_t i = 0; i < n; i++)
+        {
+            if(fabs(a[i] - median) <= lim)
+            {
+                a[m++] = a[i];
+            }
+        }
+        if((m == n) || (m == 0))
+        {
+            break;
+        }
+        n = m;
+        bkg->nbiter++;
+    }
+}
+
+// bin of rank k within [blo, bhi]
+static long imbkg_hist_select(uint64_t *hist, long blo, long bhi, uint64_t k)
+{
+    uint64_t cum = 0;
+
+    for(long b = blo; b <= bhi; b++)
+    {
+        cum += hist[b];
+        if(cum > k)
+        {
+            return b;
+        }
+    }
+    return bhi;
+}
+
+// background of n values histogrammed in work->hist, bin b is value vmin + b
+static void imbkg_from_hist(IMBKG_WORK   *work,
+                            long          nbin,
+                            double        vmin,
+                            uint64_t      n,
+                            double        nsigma,
+                            int           maxiter,
+                            IMBACKGROUND *bkg)
+{
+    uint64_t *hist = work->hist;
+    long      blo  = 0;
+    long      bhi  = nbin - 1;
+
+    long b13 = imbkg_hist_select(hist, blo, bhi, (uint64_t)(IMBKG_F_M13 * n));
+    long b03 = imbkg_hist_select(hist, blo, bhi, (uint64_t)(IMBKG_F_M03 * n));
+    bkg->sigmalowq = (b03 - b13) / (1.3 - 0.3);
+
+    bkg->nbiter = 0;
+    for(;;)
+    {
+        long bmed = imbkg_hist_select(hist, blo, bhi, n / 2);
+
+        // walk outward from median until half of the values are reached
+        uint64_t cum  = hist[bmed];
+        long     dist = 0;
+        while(cum <= n / 2)
+        {
+            dist++;
+            if(bmed - dist >= blo)
+            {
+                cum += hist[bmed - dist];
+            }
+            if(bmed + dist <= bhi)
+            {
+                cum += hist[bmed + dist];
+            }
+        }
+
+        bkg->median = vmin + bmed;
+        bkg->mad    = dist;
+        bkg->sigma  = IMBKG_MAD2SIGMA * bkg->mad;
+        bkg->nbpix  = n;
+
+        if((nsigma <= 0.0) || (bkg->nbiter == maxiter))
+        {
+            break;
+        }
+
+        double lim    = nsigma * bkg->sigma;
+        long   blonew = (long) ceil(bmed - lim);
+        long   bhinew = (long) floor(bmed + lim);
+        if(blonew < blo)
+        {
+            blonew = blo;
+        }
+        if(bhinew > bhi)
+        {
+            bhinew = bhi;
+        }
+
+        uint64_t m = 0;
+        for(long b = blonew; b <= bhinew; b++)
+        {
+            m += hist[b];
+        }
+        if((m == n) || (m == 0))
+        {
+            break;
+        }
+        blo = blonew;
+        bhi = bhinew;
+        n   = m;
+        bkg->nbiter++;
+    }
+}
+
+// copy rows [jjstart, jjend) of region into a, NaN skipped later
+#define IMBKG_LOAD(arrayptr)                                                   \
+    do                                                                         \
+    {                                                                          \
+        for(uint32_t jj = jjstart; jj < jjend; jj++)                           \
+        {                                                                      \
+            uint64_t pix0 = (uint64_t)(y0 + jj) * xsizeim + x0;                \
+            double  *aj   = a + (uint64_t) jj * xsize;                         \
+            for(uint32_t ii = 0; ii < xsize; ii++)                             \
+            {                                                                  \
+                double v = (double) (arrayptr)[pix0 + ii];                     \
+                aj[ii]   = v;                                                  \
+                vmin     = (v < vmin) ? v : vmin;                              \
+                vmax     = (v > vmax) ? v : vmax;                              \
+                nbnan += (v != v);                                             \
+            }                                                                  \
+        }                                                                      \
+    } while(0)
+
+typedef struct
+{
+    IMAGE     *image;
+    uint32_t   x0;
+    uint32_t   y0;
+    uint32_t   xsize;
+    uint32_t   ysize;
+    double    *a;
+    double     vmin[INFO_POOL_MAXTHREAD];
+    double     vmax[INFO_POOL_MAXTHREAD];
+    uint64_t   nbnan[INFO_POOL_MAXTHREAD];
+    atomic_int ret;
+} IMBKG_LOAD_JOB;
+
+static void imbkg_load_task(void *arg, int task, int nbtask)
+{
+    IMBKG_LOAD_JOB *job     = (IMBKG_LOAD_JOB *) arg;
+    IMAGE          *image   = job->image;
+    uint32_t        xsizeim = image->md[0].size[0];
+    uint32_t        x0      = job->x0;
+    uint32_t        y0      = job->y0;
+    uint32_t        xsize   = job->xsize;
+    double         *a       = job->a;
+    double          vmin    = INFINITY;
+    double          vmax    = -INFINITY;
+    uint64_t        nbnan   = 0;
+    uint64_t        jjstart;
+    uint64_t        jjend;
+
+    info_pool_range(job->ysize, task, nbtask, &jjstart, &jjend);
+
+    switch(image->md[0].datatype)
+    {
+        case _DATATYPE_FLOAT:
+            IMBKG_LOAD(image->array.F);
+            break;
+        case _DATATYPE_DOUBLE:
+            IMBKG_LOAD(image->array.D);
+            break;
+        case _DATATYPE_UINT8:
+            IMBKG_LOAD(image->array.UI8);
+            break;
+        case _DATATYPE_INT8:
+            IMBKG_LOAD(image->array.SI8);
+            break;
+        case _DATATYPE_UINT16:
+            IMBKG_LOAD(image->array.UI16);
+            break;
+        case _DATATYPE_INT16:
+            IMBKG_LOAD(image->array.SI16);
+            break;
+        case _DATATYPE_UINT32:
+            IMBKG_LOAD(image->array.UI32);
+            break;
+        case _DATATYPE_INT32:
+            IMBKG_LOAD(image->array.SI32);
+            break;
+        case _DATATYPE_UINT64:
+            IMBKG_LOAD(image->array.UI64);
+            break;
+        case _DATATYPE_INT64:
+            IMBKG_LOAD(image->array.SI64);
+            break;
+        default:
+            atomic_store(&job->ret, RETURN_FAILURE);
+            break;
+    }
+
+    job->vmin[task]  = vmin;
+    job->vmax[task]  = vmax;
+    job->nbnan[task] = nbnan;
+}
+
+// background of image region
+static errno_t imbkg_region(IMAGE        *image,
+                            uint32_t      x0,
+                            uint32_t      y0,
+                            uint32_t      xsize,
+                            uint32_t      ysize,
+                            double        nsigma,
+                            int           maxiter,
+                            IMBACKGROUND *bkg)
+{
+    uint64_t       n      = (uint64_t) xsize * ysize;
+    int            nbtask = info_pool_nbtask(n, IMBKG_NBPIX_THREAD);
+    double         vmin   = INFINITY;
+    double         vmax   = -INFINITY;
+    uint64_t       nbnan  = 0;
+    IMBKG_LOAD_JOB job;
+    IMBKG_WORK     work;
+    size_t         scratchmark = info_scratch_mark();
+
+    work.a    = (double *) info_scratch_alloc(sizeof(double) * n);
+    work.d    = NULL;
+    work.hist = NULL;
+    double *a = work.a;
+
+    job.image = image;
+    job.x0    = x0;
+    job.y0    = y0;
+    job.xsize = xsize;
+    job.ysize = ysize;
+    job.a     = a;
+    atomic_init(&job.ret, RETURN_SUCCESS);
+
+    info_pool_run(nbtask, imbkg_load_task, &job);
+
+    if(atomic_load(&job.ret) != RETURN_SUCCESS)
+    {
+        PRINT_ERROR("datatype not supported");
+        info_scratch_release(scratchmark);
+        return RETURN_FAILURE;
+    }
+    for(int task = 0; task < nbtask; task++)
+    {
+        vmin = (job.vmin[task] < vmin) ? job.vmin[task] : vmin;
+        vmax = (job.vmax[task] > vmax) ? job.vmax[task] : vmax;
+        nbnan += job.nbnan[task];
+    }
+
+    if(nbnan > 0)
+    {
+        uint64_t m = 0;
+        for(uint64_t i = 0; i < n; i++)
+        {
+            if(!isnan(a[i]))
+            {
+                a[m++] = a[i];
+            }
+        }
+        n = m;
+    }
+
+    if(n == 0)
+    {
+        bkg->median    = NAN;
+        bkg->mad       = NAN;
+        bkg->sigma     = NAN;
+        bkg->sigmalowq = NAN;
+        bkg->nbpix     = 0;
+        bkg->nbiter    = 0;
+        info_scratch_release(scratchmark);
+        return RETURN_SUCCESS;
+    }
+
+    // histogram if integer values, and range not much larger than n
+    double range = vmax - vmin + 1.0;
+    if(imbkg_isinteger(image->md[0].datatype) &&
+            (range <= IMBKG_HISTSIZE_MAX) && (range <= 4.0 * n + 1024))
+    {
+        long nbin = (long) range;
+        work.hist = (uint64_t *) info_scratch_calloc(nbin, sizeof(uint64_t));
+        for(uint64_t i = 0; i < n; i++)
+        {
+            work.hist[(long)(a[i] - vmin)]++;
+        }
+        imbkg_from_hist(&work, nbin, vmin, n, nsigma, maxiter, bkg);
+    }
+    else
+    {
+        work.d = (double *) info_scratch_alloc(sizeof(double) * n);
+        imbkg_from_array(&work, n, nsigma, maxiter, bkg);
+    }
+
+    info_scratch_release(scratchmark);
+
+    return RETURN_SUCCESS;
+}
+
+/**
+ * @brief Robust background and noise of image
+ *
+ * Median and MAD of pixel values, iteratively clipping values further than
+ * nsigma sigma from the median, at most maxiter times.
+ * No clipping if nsigma <= 0 or maxiter = 0. NaN pixels are ignored.
+ */
+errno_t image_background(IMAGE        *image,
+                         double        nsigma,
+                         int           maxiter,
+                         IMBACKGROUND *bkg)
+{
+    INFO_INSTR_SCOPE("image_background");
+
+    uint32_t ysize = (image->md[0].naxis < 2) ? 1 : image->md[0].size[1];
+
+    return imbkg_region(image,
+                        0,
+                        0,
+                        image->md[0].size[0],
+                        ysize,
+                        nsigma,
+                        maxiter,
+                        bkg);
+}
+
+typedef struct
+{
+    IMAGE      *image;
+    uint32_t    tilexsize;
+    uint32_t    tileysize;
+    uint32_t    ntx;
+    long        ntile;
+    double      nsigma;
+    int         maxiter;
+    float      *bkgmap;
+    float      *noisemap;
+    atomic_long nexttile;
+    atomic_int  ret;
+} IMBKG_MAP_JOB;
+
+// process tiles until none is left
+static void imbkg_map_task(void *arg, int task, int nbtask)
+{
+    IMBKG_MAP_JOB *job   = (IMBKG_MAP_JOB *) arg;
+    uint32_t       xsize = job->image->md[0].size[0];
+    uint32_t       ysize =
+        (job->image->md[0].naxis < 2) ? 1 : job->image->md[0].size[1];
+    long t;
+
+    (void) task;
+    (void) nbtask;
+
+    while((t = atomic_fetch_add(&job->nexttile, 1)) < job->ntile)
+    {
+        uint32_t x0 = (t % job->ntx) * job->tilexsize;
+        uint32_t y0 = (t / job->ntx) * job->tileysize;
+        uint32_t tx =
+            (x0 + job->tilexsize > xsize) ? xsize - x0 : job->tilexsize;
+        uint32_t ty =
+            (y0 + job->tileysize > ysize) ? ysize - y0 : job->tileysize;
+        IMBACKGROUND bkg;
+
+        if(imbkg_region(job->image,
+                        x0,
+                        y0,
+                        tx,
+                        ty,
+                        job->nsigma,
+                        job->maxiter,
+                        &bkg) != RETURN_SUCCESS)
+        {
+            atomic_store(&job->ret, RETURN_FAILURE);
+            continue;
+        }
+        if(job->bkgmap != NULL)
+        {
+            job->bkgmap[t] = (float) bkg.median;
+        }
+        if(job->noisemap != NULL)
+        {
+            job->noisemap[t] = (float) bkg.sigma;
+        }
+    }
+}
+
+/**
+ * @brief Background and noise maps, one value per tile
+ *
+ * Maps have ceil(xsize / tilexsize) x ceil(ysize / tileysize) elements.
+ * Last tiles along each axis are smaller if the image size is not a
+ * multiple of the tile size. A tile size of 0 spans the full frame.
+ * bkgmap receives the median, noisemap the clipped sigma.
+ * Either may be NULL.
+ */
+errno_t image_background_map(IMAGE   *image,
+                             uint32_t tilexsize,
+                             uint32_t tileysize,
+                             double   nsigma,
+                             int      maxiter,
+                             float   *bkgmap,
+                             float   *noisemap)
+{
+    INFO_INSTR_SCOPE("image_background_map");
+
+    uint32_t      xsize = image->md[0].size[0];
+    uint32_t      ysize = (image->md[0].naxis < 2) ? 1 : image->md[0].size[1];
+    IMBKG_MAP_JOB job;
+
+    if((tilexsize == 0) || (tilexsize > xsize))
+    {
+        tilexsize = xsize;
+    }
+    if((tileysize == 0) || (tileysize > ysize))
+    {
+        tileysize = ysize;
+    }
+
+    job.image     = image;
+    job.tilexsize = tilexsize;
+    job.tileysize = tileysize;
+    job.ntx       = (xsize + tilexsize - 1) / tilexsize;
+    job.ntile     = (long) job.ntx * ((ysize + tileysize - 1) / tileysize);
+    job.nsigma    = nsigma;
+    job.maxiter   = maxiter;
+    job.bkgmap    = bkgmap;
+    job.noisemap  = noisemap;
+    atomic_init(&job.nexttile, 0);
+    atomic_init(&job.ret, RETURN_SUCCESS);
+
+    // one task per thread, tiles handed out in order
+    info_pool_run(info_pool_nbtask(job.ntile, 1), imbkg_map_task, &job);
+
+    return atomic_load(&job.ret);
+}
+
+/**
+ * @brief Noise from lower quantiles of pixel values
+ *
+ * Uses F(-1.3 sig) and F(-0.3 sig) quantiles of the normal distribution.
+ */
+double background_photon_noise(const char *ID_name)
+{
+    imageID      ID = image_ID(ID_name);
+    IMBACKGROUND bkg;
+
+    if(ID == -1)
+    {
+        PRINT_ERROR("image %s not found", ID_name);
+        return NAN;
+    }
+
+    if(image_background(&data.image[ID], 0.0, 0, &bkg) != RETURN_SUCCESS)
+    {
+        return NAN;
+    }
+
+    printf("(-1.3 -0.3) %f\n", bkg.sigmalowq);
+    printf("median %f   MAD sigma %f\n", bkg.median, bkg.sigma);
+
+    return bkg.sigmalowq;
+}
+
+static errno_t compute_function()
+{
+    DEBUG_TRACE_FSTART();
+
+    imageID  ID    = image_ID(instreamname);
+    uint32_t xsize = data.image[ID].md[0].size[0];
+    uint32_t ysize = (data.image[ID].md[0].naxis < 2)
+                     ? 1 : data.image[ID].md[0].size[1];
+    uint32_t tx    = *tilexsize;
+    uint32_t ty    = *tileysize;
+
+    if((tx == 0) || (tx > xsize))
+    {
+        tx = xsize;
+    }
+    if((ty == 0) || (ty > ysize))
+    {
+        ty = ysize;
+    }
+
+    imageID  IDbkg;
+    uint32_t sizeout[2];
+    sizeout[0] = (xsize + tx - 1) / tx;
+    sizeout[1] = (ysize + ty - 1) / ty;
+    create_image_ID(outstreamname,
+                    2,
+                    sizeout,
+                    _DATATYPE_FLOAT,
+                    1,
+                    0,
+                    0,
+                    &IDbkg);
+
+    imageID IDnoise;
+    char    noisename[STRINGMAXLEN_IMGNAME];
+    WRITE_IMAGENAME(noisename, "%snoise", outstreamname);
+    create_image_ID(noisename,
+                    2,
+                    sizeout,
+                    _DATATYPE_FLOAT,
+                    1,
+                    0,
+                    0,
+                    &IDnoise);
+
+    INSERT_STD_PROCINFO_COMPUTEFUNC_INIT
+
+    INSERT_STD_PROCINFO_COMPUTEFUNC_LOOPSTART
+    {
+        data.image[IDbkg].md[0].write   = 1;
+        data.image[IDnoise].md[0].write = 1;
+        image_background_map(&data.image[ID],
+                             tx,
+                             ty,
+                             *nsigmaclip,
+                             (int) *maxiterclip,
+                             data.image[IDbkg].array.F,
+                             data.image[IDnoise].array.F);
+        processinfo_update_output_stream(processinfo, IDbkg);
+        processinfo_update_output_stream(processinfo, IDnoise);
+    }
+    INSERT_STD_PROCINFO_COMPUTEFUNC_END
+
+    DEBUG_TRACE_FEXIT();
+    return RETURN_SUCCESS;
+}
+
+INSERT_STD_FPSCLIfunctions
+
+// Register function in CLI
+errno_t CLIADDCMD_info__imbackground()
+{
+    INSERT_STD_CLIREGISTERFUNC
+
+    return RETURN_SUCCESS;
+}
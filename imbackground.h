@@ -0,0 +1,35 @@
+/**
+ * @file    imbackground.h
+ */
+
+#ifndef _INFO_IMBACKGROUND_H
+#define _INFO_IMBACKGROUND_H
+
+typedef struct
+{
+    double   median;    // after clipping
+    double   mad;       // median absolute deviation, after clipping
+    double   sigma;     // 1.4826 mad
+    double   sigmalowq; // from lower quantiles, before clipping
+    uint64_t nbpix;     // number of pixels kept after clipping
+    int      nbiter;    // number of clipping iterations done
+} IMBACKGROUND;
+
+errno_t image_background(IMAGE        *image,
+                         double        nsigma,
+                         int           maxiter,
+                         IMBACKGROUND *bkg);
+
+errno_t image_background_map(IMAGE   *image,
+                             uint32_t tilexsize,
+                             uint32_t tileysize,
+                             double   nsigma,
+                             int      maxiter,
+                             float   *bkgmap,
+                             float   *noisemap);
+
+double background_photon_noise(const char *ID_name);
+
+errno_t CLIADDCMD_info__imbackground();
+
+#endif
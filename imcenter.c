@@ -0,0 +1,286 @@
+/**
+ * @file    imcenter.c
+ * @brief   fast peak / centroid finder
+ *
+ * Locates the brightest pixel, then refines its position to sub-pixel
+ * accuracy using only a small window around it.
+ * When a previous position is known, the peak search is restricted to a
+ * box around it, so tracking a drifting spot costs much less than a full
+ * pass over the frame.
+ */
+
+#include <math.h>
+
+#include "info_core.h"
+
+#include "imcenter.h"
+#include "info_instr.h"
+
+#define IMCENTER_PEAKSEARCH(arrayptr)                                          \
+    do                                                                         \
+    {                                                                          \
+        for(long jj = jjmin; jj <= jjmax; jj++)                                \
+        {                                                                      \
+            for(long ii = iimin; ii <= iimax; ii++)                            \
+            {                                                                  \
+                double v = (double) (arrayptr)[jj * xsize + ii];               \
+                if(v > vmax)                                                   \
+                {                                                              \
+                    vmax    = v;                                               \
+                    iipeak  = ii;                                              \
+                    jjpeak  = jj;                                              \
+                }                                                              \
+            }                                                                  \
+        }                                                                      \
+    } while(0)
+
+static inline double imcenter_pixval(IMAGE *image, uint64_t pix)
+{
+    switch(image->md[0].datatype)
+    {
+        case _DATATYPE_FLOAT:
+            return image->array.F[pix];
+        case _DATATYPE_DOUBLE:
+            return image->array.D[pix];
+        case _DATATYPE_UINT8:
+            return image->array.UI8[pix];
+        case _DATATYPE_INT8:
+            return image->array.SI8[pix];
+        case _DATATYPE_UINT16:
+            return image->array.UI16[pix];
+        case _DATATYPE_INT16:
+            return image->array.SI16[pix];
+        case _DATATYPE_UINT32:
+            return image->array.UI32[pix];
+        case _DATATYPE_INT32:
+            return image->array.SI32[pix];
+        case _DATATYPE_UINT64:
+            return image->array.UI64[pix];
+        case _DATATYPE_INT64:
+            return image->array.SI64[pix];
+        default:
+            return 0.0;
+    }
+}
+
+/**
+ * @brief Find brightest pixel
+ *
+ * If searchradius > 0, search is restricted to the box of half-width
+ * searchradius around (xprev, yprev). Otherwise the full frame is searched.
+ * Fails if the search box is empty or holds no pixel above -inf (NaN only).
+ */
+errno_t image_peak_find(IMAGE *image,
+                        double xprev,
+                        double yprev,
+                        long   searchradius,
+                        long  *iipeakout,
+                        long  *jjpeakout)
+{
+    long   xsize  = image->md[0].size[0];
+    long   ysize  = image->md[0].size[1];
+    long   iimin  = 0;
+    long   iimax  = xsize - 1;
+    long   jjmin  = 0;
+    long   jjmax  = ysize - 1;
+    long   iipeak = -1;
+    long   jjpeak = -1;
+    double vmax   = -INFINITY;
+
+    if(image->md[0].naxis < 2)
+    {
+        ysize = 1;
+        jjmax = 0;
+    }
+
+    if(searchradius > 0)
+    {
+        iimin = (long)(xprev + 0.5) - searchradius;
+        iimax = (long)(xprev + 0.5) + searchradius;
+        jjmin = (long)(yprev + 0.5) - searchradius;
+        jjmax = (long)(yprev + 0.5) + searchradius;
+        if(iimin < 0)
+        {
+            iimin = 0;
+        }
+        if(jjmin < 0)
+        {
+            jjmin = 0;
+        }
+        if(iimax > xsize - 1)
+        {
+            iimax = xsize - 1;
+        }
+        if(jjmax > ysize - 1)
+        {
+            jjmax = ysize - 1;
+        }
+    }
+
+    switch(image->md[0].datatype)
+    {
+        case _DATATYPE_FLOAT:
+            IMCENTER_PEAKSEARCH(image->array.F);
+            break;
+        case _DATATYPE_DOUBLE:
+            IMCENTER_PEAKSEARCH(image->array.D);
+            break;
+        case _DATATYPE_UINT8:
+            IMCENTER_PEAKSEARCH(image->array.UI8);
+            break;
+        case _DATATYPE_INT8:
+            IMCENTER_PEAKSEARCH(image->array.SI8);
+            break;
+        case _DATATYPE_UINT16:
+            IMCENTER_PEAKSEARCH(image->array.UI16);
+            break;
+        case _DATATYPE_INT16:
+            IMCENTER_PEAKSEARCH(image->array.SI16);
+            break;
+        case _DATATYPE_UINT32:
+            IMCENTER_PEAKSEARCH(image->array.UI32);
+            break;
+        case _DATATYPE_INT32:
+            IMCENTER_PEAKSEARCH(image->array.SI32);
+            break;
+        case _DATATYPE_UINT64:
+            IMCENTER_PEAKSEARCH(image->array.UI64);
+            break;
+        case _DATATYPE_INT64:
+            IMCENTER_PEAKSEARCH(image->array.SI64);
+            break;
+        default:
+            PRINT_ERROR("datatype not supported");
+            return RETURN_FAILURE;
+    }
+
+    if(iipeak == -1)
+    {
+        PRINT_ERROR("image %s : no valid pixel in peak search box",
+                    image->name);
+        return RETURN_FAILURE;
+    }
+
+    *iipeakout = iipeak;
+    *jjpeakout = jjpeak;
+
+    return RETURN_SUCCESS;
+}
+
+/**
+ * @brief Sub-pixel position of brightest spot
+ *
+ * mode IMCENTER_MODE_CENTROID : centroid over (2 window + 1)^2 box around
+ * peak, after subtracting the box minimum
+ *
+ * mode IMCENTER_MODE_PEAKFIT : separable parabola fit through the peak and
+ * its 4 neighbors
+ *
+ * See image_peak_find() for searchradius, xprev and yprev.
+ */
+errno_t image_center_find(IMAGE  *image,
+                          int     mode,
+                          long    window,
+                          double  xprev,
+                          double  yprev,
+                          long    searchradius,
+                          double *xcenter,
+                          double *ycenter)
+{
+    INFO_INSTR_SCOPE("image_center_find");
+
+    long xsize = image->md[0].size[0];
+    long ysize = (image->md[0].naxis < 2) ? 1 : image->md[0].size[1];
+    long iipeak;
+    long jjpeak;
+
+    if(image_peak_find(image, xprev, yprev, searchradius, &iipeak, &jjpeak) !=
+            RETURN_SUCCESS)
+    {
+        return RETURN_FAILURE;
+    }
+
+    *xcenter = iipeak;
+    *ycenter = jjpeak;
+
+    if(mode == IMCENTER_MODE_PEAKFIT)
+    {
+        if((iipeak > 0) && (iipeak < xsize - 1))
+        {
+            double vm = imcenter_pixval(image, jjpeak * xsize + iipeak - 1);
+            double v0 = imcenter_pixval(image, jjpeak * xsize + iipeak);
+            double vp = imcenter_pixval(image, jjpeak * xsize + iipeak + 1);
+            double denom = vm - 2.0 * v0 + vp;
+            if(denom < 0.0)
+            {
+                *xcenter += 0.5 * (vm - vp) / denom;
+            }
+        }
+        if((jjpeak > 0) && (jjpeak < ysize - 1))
+        {
+            double vm = imcenter_pixval(image, (jjpeak - 1) * xsize + iipeak);
+            double v0 = imcenter_pixval(image, jjpeak * xsize + iipeak);
+            double vp = imcenter_pixval(image, (jjpeak + 1) * xsize + iipeak);
+            double denom = vm - 2.0 * v0 + vp;
+            if(denom < 0.0)
+            {
+                *ycenter += 0.5 * (vm - vp) / denom;
+            }
+        }
+    }
+    else
+    {
+        long   iimin = iipeak - window;
+        long   iimax = iipeak + window;
+        long   jjmin = jjpeak - window;
+        long   jjmax = jjpeak + window;
+        double vmin  = INFINITY;
+        double tot   = 0.0;
+        double xtot  = 0.0;
+        double ytot  = 0.0;
+
+        if(iimin < 0)
+        {
+            iimin = 0;
+        }
+        if(jjmin < 0)
+        {
+            jjmin = 0;
+        }
+        if(iimax > xsize - 1)
+        {
+            iimax = xsize - 1;
+        }
+        if(jjmax > ysize - 1)
+        {
+            jjmax = ysize - 1;
+        }
+
+        for(long jj = jjmin; jj <= jjmax; jj++)
+            for(long ii = iimin; ii <= iimax; ii++)
+            {
+                double v = imcenter_pixval(image, jj * xsize + ii);
+                if(v < vmin)
+                {
+                    vmin = v;
+                }
+            }
+
+        for(long jj = jjmin; jj <= jjmax; jj++)
+            for(long ii = iimin; ii <= iimax; ii++)
+            {
+                double v = imcenter_pixval(image, jj * xsize + ii) - vmin;
+                tot += v;
+                xtot += v * ii;
+                ytot += v * jj;
+            }
+
+        if(tot > 0.0)
+        {
+            *xcenter = xtot / tot;
+            *ycenter = ytot / tot;
+        }
+    }
+
+    return RETURN_SUCCESS;
+}
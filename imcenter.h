@@ -0,0 +1,27 @@
+/**
+ * @file    imcenter.h
+ */
+
+#ifndef _INFO_IMCENTER_H
+#define _INFO_IMCENTER_H
+
+#define IMCENTER_MODE_CENTROID 0
+#define IMCENTER_MODE_PEAKFIT  1
+
+errno_t image_peak_find(IMAGE *image,
+                        double xprev,
+                        double yprev,
+                        long   searchradius,
+                        long  *iipeakout,
+                        long  *jjpeakout);
+
+errno_t image_center_find(IMAGE  *image,
+                          int     mode,
+                          long    window,
+                          double  xprev,
+                          double  yprev,
+                          long    searchradius,
+                          double *xcenter,
+                          double *ycenter);
+
+#endif
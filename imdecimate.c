@@ -0,0 +1,242 @@
+/**
+ * @file    imdecimate.c
+ * @brief   block reduction of an image to a smaller size
+ *
+ * Each output pixel is the average, or maximum, of a block of input
+ * pixels. Block edges are spread evenly over the input, so that blocks
+ * differ by at most one pixel along each axis when sizes are not multiple.
+ *
+ * The frame is read once, rows in memory order : each output row
+ * accumulates its input rows, the sum over a block row being a contiguous
+ * vector reduction. Output rows are split between the threads of the
+ * worker pool. This keeps the cost at one streaming pass over the frame,
+ * used for display of multi-megapixel streams at every refresh.
+ */
+
+#include <math.h>
+
+#include "info_core.h"
+
+#include "imdecimate.h"
+#include "info_instr.h"
+#include "info_pool.h"
+#include "info_scratch.h"
+#include "info_simd.h"
+
+// minimum number of pixels per thread
+#define IMDECIMATE_NBPIX_THREAD 65536
+
+/**
+ * @brief Largest output size within maxxsize x maxysize, same aspect ratio
+ */
+void imdecimate_size(IMAGE    *image,
+                     uint32_t  maxxsize,
+                     uint32_t  maxysize,
+                     uint32_t *outxsize,
+                     uint32_t *outysize)
+{
+    uint32_t xsize = image->md[0].size[0];
+    uint64_t ysize = image->md[0].nelement / xsize;
+    double   scale = fmax((double) xsize / maxxsize,
+                          (double) ysize / maxysize);
+
+    scale     = fmax(scale, 1.0);
+    *outxsize = (uint32_t) fmax(1.0, floor(xsize / scale));
+    *outysize = (uint32_t) fmax(1.0, floor(ysize / scale));
+}
+
+#define IMDECIMATE_ROW(arrayptr)                                               \
+    do                                                                         \
+    {                                                                          \
+        const __typeof__((arrayptr)[0]) *row = (arrayptr) + offset;            \
+        if(mode == IMDECIMATE_MAX)                                             \
+        {                                                                      \
+            for(uint32_t io = 0; io < outxsize; io++)                          \
+            {                                                                  \
+                double vmax = acc[io];                                         \
+                _Pragma("omp simd reduction(max:vmax)")                        \
+                for(uint32_t ii = colstart[io]; ii < colstart[io + 1]; ii++)   \
+                {                                                              \
+                    double v = (double) row[ii];                               \
+                    vmax     = (v > vmax) ? v : vmax;                          \
+                }                                                              \
+                acc[io] = vmax;                                                \
+            }                                                                  \
+        }                                                                      \
+        else                                                                   \
+        {                                                                      \
+            for(uint32_t io = 0; io < outxsize; io++)                          \
+            {                                                                  \
+                double sum = 0.0;                                              \
+                _Pragma("omp simd reduction(+:sum)")                           \
+                for(uint32_t ii = colstart[io]; ii < colstart[io + 1]; ii++)   \
+                {                                                              \
+                    sum += (double) row[ii];                                   \
+                }                                                              \
+                acc[io] += sum;                                                \
+            }                                                                  \
+        }                                                                      \
+    } while(0)
+
+// reduce input row offset into acc[outxsize]
+INFO_SIMD_CLONES
+static void imdecimate_row(IMAGE          *image,
+                           uint64_t        offset,
+                           uint32_t        outxsize,
+                           const uint32_t *colstart,
+                           int             mode,
+                           double         *acc)
+{
+    switch(image->md[0].datatype)
+    {
+        case _DATATYPE_FLOAT:
+            IMDECIMATE_ROW(image->array.F);
+            break;
+        case _DATATYPE_DOUBLE:
+            IMDECIMATE_ROW(image->array.D);
+            break;
+        case _DATATYPE_UINT8:
+            IMDECIMATE_ROW(image->array.UI8);
+            break;
+        case _DATATYPE_INT8:
+            IMDECIMATE_ROW(image->array.SI8);
+            break;
+        case _DATATYPE_UINT16:
+            IMDECIMATE_ROW(image->array.UI16);
+            break;
+        case _DATATYPE_INT16:
+            IMDECIMATE_ROW(image->array.SI16);
+            break;
+        case _DATATYPE_UINT32:
+            IMDECIMATE_ROW(image->array.UI32);
+            break;
+        case _DATATYPE_INT32:
+            IMDECIMATE_ROW(image->array.SI32);
+            break;
+        case _DATATYPE_UINT64:
+            IMDECIMATE_ROW(image->array.UI64);
+            break;
+        case _DATATYPE_INT64:
+            IMDECIMATE_ROW(image->array.SI64);
+            break;
+    }
+}
+
+typedef struct
+{
+    IMAGE          *image;
+    uint32_t        outxsize;
+    uint32_t        outysize;
+    const uint32_t *colstart; // [outxsize + 1]
+    int             mode;
+    float          *outarray;
+} IMDECIMATE_JOB;
+
+static void imdecimate_task(void *arg, int task, int nbtask)
+{
+    IMDECIMATE_JOB *job      = (IMDECIMATE_JOB *) arg;
+    uint32_t        xsize    = job->image->md[0].size[0];
+    uint64_t        ysize    = job->image->md[0].nelement / xsize;
+    uint32_t        outxsize = job->outxsize;
+    uint64_t        jostart;
+    uint64_t        joend;
+
+    info_pool_range(job->outysize, task, nbtask, &jostart, &joend);
+
+    size_t  scratchmark = info_scratch_mark();
+    double *acc = (double *) info_scratch_alloc(sizeof(double) * outxsize);
+
+    for(uint64_t jo = jostart; jo < joend; jo++)
+    {
+        uint64_t jstart = jo * ysize / job->outysize;
+        uint64_t jend   = (jo + 1) * ysize / job->outysize;
+
+        for(uint32_t io = 0; io < outxsize; io++)
+        {
+            acc[io] = (job->mode == IMDECIMATE_MAX) ? -INFINITY : 0.0;
+        }
+        for(uint64_t jj = jstart; jj < jend; jj++)
+        {
+            imdecimate_row(job->image,
+                           jj * xsize,
+                           outxsize,
+                           job->colstart,
+                           job->mode,
+                           acc);
+        }
+
+        float *out = job->outarray + jo * outxsize;
+        for(uint32_t io = 0; io < outxsize; io++)
+        {
+            if(job->mode == IMDECIMATE_MAX)
+            {
+                out[io] = (float) acc[io];
+            }
+            else
+            {
+                uint64_t nbpix = (jend - jstart) *
+                                 (job->colstart[io + 1] - job->colstart[io]);
+                out[io] = (float)(acc[io] / nbpix);
+            }
+        }
+    }
+
+    info_scratch_release(scratchmark);
+}
+
+/**
+ * @brief Reduce image to outxsize x outysize, block average or maximum
+ *
+ * Output sizes must not exceed the image size. outarray holds outxsize x
+ * outysize values, row by row. 3D images are reduced over all slices, as
+ * stacked rows. NaN values propagate to their block average, and are
+ * ignored by the block maximum.
+ */
+errno_t image_decimate(IMAGE   *image,
+                       uint32_t outxsize,
+                       uint32_t outysize,
+                       int      mode,
+                       float   *outarray)
+{
+    INFO_INSTR_SCOPE("image_decimate");
+
+    uint32_t xsize = image->md[0].size[0];
+    uint64_t ysize = image->md[0].nelement / xsize;
+
+    if((outxsize == 0) || (outysize == 0) || (outxsize > xsize) ||
+            (outysize > ysize))
+    {
+        PRINT_ERROR("output size %u x %u invalid for image %u x %lu",
+                    outxsize,
+                    outysize,
+                    xsize,
+                    ysize);
+        return RETURN_FAILURE;
+    }
+
+    IMDECIMATE_JOB job;
+    size_t         scratchmark = info_scratch_mark();
+    uint32_t      *colstart    =
+        (uint32_t *) info_scratch_alloc(sizeof(uint32_t) * (outxsize + 1));
+
+    for(uint32_t io = 0; io <= outxsize; io++)
+    {
+        colstart[io] = (uint32_t)((uint64_t) io * xsize / outxsize);
+    }
+
+    job.image    = image;
+    job.outxsize = outxsize;
+    job.outysize = outysize;
+    job.colstart = colstart;
+    job.mode     = mode;
+    job.outarray = outarray;
+
+    int nbtask = info_pool_nbtask(image->md[0].nelement,
+                                  IMDECIMATE_NBPIX_THREAD);
+    nbtask     = (nbtask > (int) outysize) ? (int) outysize : nbtask;
+    info_pool_run(nbtask, imdecimate_task, &job);
+
+    info_scratch_release(scratchmark);
+
+    return RETURN_SUCCESS;
+}
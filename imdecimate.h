@@ -0,0 +1,24 @@
+/**
+ * @file    imdecimate.h
+ * @brief   block reduction of an image to a smaller size
+ */
+
+#ifndef _INFO_IMDECIMATE_H
+#define _INFO_IMDECIMATE_H
+
+#define IMDECIMATE_MEAN 0 // block average
+#define IMDECIMATE_MAX  1 // block maximum
+
+void imdecimate_size(IMAGE    *image,
+                     uint32_t  maxxsize,
+                     uint32_t  maxysize,
+                     uint32_t *outxsize,
+                     uint32_t *outysize);
+
+errno_t image_decimate(IMAGE   *image,
+                       uint32_t outxsize,
+                       uint32_t outysize,
+                       int      mode,
+                       float   *outarray);
+
+#endif
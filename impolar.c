@@ -0,0 +1,670 @@
+/**
+ * @file    impolar.c
+ * @brief   polar (r, theta) resampling of images
+ *
+ * Each input pixel is split into oversamp x oversamp sub-pixels, and each
+ * sub-pixel is assigned to a polar bin. The resulting area weights are
+ * stored as a sparse matrix, computed once per geometry (size, center,
+ * radial step, number of radial and angular bins, mask) and cached.
+ * Resampling a frame is then a sparse matrix-vector product.
+ *
+ * Output image is nr x ntheta : each row is the radial profile of an
+ * azimuthal sector, each column the azimuthal profile of a ring.
+ * Angle is measured from the x axis, counter-clockwise, in [0, 2pi).
+ */
+
+#include <math.h>
+#include <stdatomic.h>
+
+#include "CommandLineInterface/CLIcore.h"
+
+#include "COREMOD_memory/COREMOD_memory.h"
+
+#include "impolar.h"
+#include "info_instr.h"
+#include "info_pool.h"
+#include "info_simd.h"
+
+// number of geometries kept in cache
+#define POLAR_MAP_CACHESIZE 2
+
+// minimum number of output bins per thread
+#define POLAR_NBOUT_THREAD 1024
+
+static POLAR_MAP polarmapcache[POLAR_MAP_CACHESIZE];
+static int       polarmapcache_next = 0;
+
+// Local variables pointers
+static char     *instreamname;
+static char     *outstreamname;
+static char     *maskname;
+static double   *xcenter;
+static double   *ycenter;
+static double   *rstep;
+static uint32_t *nrbin;
+static uint32_t *nthetabin;
+static uint32_t *oversampling;
+
+static CLICMDARGDEF farg[] =
+{
+    {
+        CLIARG_IMG,
+        ".insname",
+        "input stream",
+        "im1",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &instreamname,
+        NULL
+    },
+    {
+        CLIARG_STR,
+        ".outsname",
+        "output polar image",
+        "im1polar",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &outstreamname,
+        NULL
+    },
+    {
+        CLIARG_FLOAT64,
+        ".xcenter",
+        "center x coordinate [pix]",
+        "64.0",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &xcenter,
+        NULL
+    },
+    {
+        CLIARG_FLOAT64,
+        ".ycenter",
+        "center y coordinate [pix]",
+        "64.0",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &ycenter,
+        NULL
+    },
+    {
+        CLIARG_FLOAT64,
+        ".rstep",
+        "radial step [pix]",
+        "1.0",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &rstep,
+        NULL
+    },
+    {
+        CLIARG_UINT32,
+        ".nr",
+        "number of radial bins",
+        "64",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &nrbin,
+        NULL
+    },
+    {
+        CLIARG_UINT32,
+        ".ntheta",
+        "number of angular bins",
+        "180",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &nthetabin,
+        NULL
+    },
+    {
+        CLIARG_UINT32,
+        ".oversamp",
+        "pixel oversampling for area weights",
+        "4",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &oversampling,
+        NULL
+    },
+    {
+        CLIARG_STR,
+        ".maskname",
+        "mask image, ignored if not loaded",
+        "profmask",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &maskname,
+        NULL
+    }
+};
+
+static CLICMDDATA CLIcmddata =
+{
+    "impolar", "polar resampling of image", CLICMD_FIELDS_DEFAULTS
+};
+
+// detailed help
+static errno_t help_function()
+{
+    printf("Resample image to polar coordinates (r, theta)\n");
+    printf("Output image size is nr x ntheta\n");
+    printf("Sub-pixel area weights are computed once per geometry\n");
+
+    return RETURN_SUCCESS;
+}
+
+static void polar_map_free(POLAR_MAP *polarmap)
+{
+    free(polarmap->rowstart);
+    free(polarmap->colindex);
+    free(polarmap->weight);
+    polarmap->rowstart = NULL;
+    polarmap->colindex = NULL;
+    polarmap->weight   = NULL;
+    polarmap->nnz      = 0;
+}
+
+static int polar_map_match(POLAR_MAP *polarmap,
+                           uint32_t   xsize,
+                           uint32_t   ysize,
+                           double     xcenter,
+                           double     ycenter,
+                           double     rstep,
+                           uint32_t   nr,
+                           uint32_t   ntheta,
+                           int        oversamp,
+                           IMAGE     *maskimage)
+{
+    if(polarmap->rowstart == NULL)
+    {
+        return 0;
+    }
+    if((polarmap->xsize != xsize) || (polarmap->ysize != ysize) ||
+            (polarmap->xcenter != xcenter) || (polarmap->ycenter != ycenter) ||
+            (polarmap->rstep != rstep) || (polarmap->nr != nr) ||
+            (polarmap->ntheta != ntheta) || (polarmap->oversamp != oversamp))
+    {
+        return 0;
+    }
+    if(polarmap->maskimage != maskimage)
+    {
+        return 0;
+    }
+    if(maskimage != NULL)
+    {
+        if(polarmap->maskcnt0 != maskimage->md[0].cnt0)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static errno_t polar_map_build(POLAR_MAP *polarmap,
+                               uint32_t   xsize,
+                               uint32_t   ysize,
+                               double     xcenter,
+                               double     ycenter,
+                               double     rstep,
+                               uint32_t   nr,
+                               uint32_t   ntheta,
+                               int        oversamp,
+                               IMAGE     *maskimage)
+{
+    uint64_t nbout = (uint64_t) nr * ntheta;
+    int      nbsub = oversamp * oversamp;
+    double   wsub  = 1.0 / nbsub;
+
+    // (output, input, weight) triplets, in input pixel order
+    uint64_t  NBtriplet    = 0;
+    uint64_t  NBtripletmax = (uint64_t) xsize * ysize;
+    uint32_t *tripletout;
+    uint32_t *tripletin;
+    float    *tripletw;
+
+    // sub-pixel bins of current input pixel
+    uint32_t *pixbin;
+    float    *pixw;
+
+    double *rowsum;
+
+    polar_map_free(polarmap);
+
+    polarmap->xsize     = xsize;
+    polarmap->ysize     = ysize;
+    polarmap->xcenter   = xcenter;
+    polarmap->ycenter   = ycenter;
+    polarmap->rstep     = rstep;
+    polarmap->nr        = nr;
+    polarmap->ntheta    = ntheta;
+    polarmap->oversamp  = oversamp;
+    polarmap->maskimage = maskimage;
+    polarmap->maskcnt0  = 0;
+    if(maskimage != NULL)
+    {
+        polarmap->maskcnt0 = maskimage->md[0].cnt0;
+    }
+
+    tripletout = (uint32_t *) malloc(sizeof(uint32_t) * NBtripletmax);
+    tripletin  = (uint32_t *) malloc(sizeof(uint32_t) * NBtripletmax);
+    tripletw   = (float *) malloc(sizeof(float) * NBtripletmax);
+    pixbin     = (uint32_t *) malloc(sizeof(uint32_t) * nbsub);
+    pixw       = (float *) malloc(sizeof(float) * nbsub);
+    polarmap->rowstart = (uint64_t *) calloc(nbout + 1, sizeof(uint64_t));
+    rowsum             = (double *) calloc(nbout, sizeof(double));
+    if((tripletout == NULL) || (tripletin == NULL) || (tripletw == NULL) ||
+            (pixbin == NULL) || (pixw == NULL) || (polarmap->rowstart == NULL) ||
+            (rowsum == NULL))
+    {
+        PRINT_ERROR("malloc returns NULL pointer");
+        abort();
+    }
+
+    for(uint32_t jj = 0; jj < ysize; jj++)
+        for(uint32_t ii = 0; ii < xsize; ii++)
+        {
+            uint64_t pix    = (uint64_t) jj * xsize + ii;
+            int      npixbin = 0;
+
+            if(maskimage != NULL)
+            {
+                if(!(maskimage->array.F[pix] > 0.5))
+                {
+                    continue;
+                }
+            }
+
+            for(int sj = 0; sj < oversamp; sj++)
+                for(int si = 0; si < oversamp; si++)
+                {
+                    // sub-pixel center, pixel (ii,jj) covers [ii-0.5, ii+0.5]
+                    double dx = ii - 0.5 + (si + 0.5) / oversamp - xcenter;
+                    double dy = jj - 0.5 + (sj + 0.5) / oversamp - ycenter;
+                    double r  = sqrt(dx * dx + dy * dy);
+                    long   ir = (long)(r / rstep);
+                    double theta;
+                    long   it;
+                    uint32_t bin;
+                    int      k;
+
+                    if(ir >= nr)
+                    {
+                        continue;
+                    }
+                    theta = atan2(dy, dx);
+                    if(theta < 0.0)
+                    {
+                        theta += 2.0 * M_PI;
+                    }
+                    it = (long)(theta / (2.0 * M_PI) * ntheta);
+                    if(it >= ntheta)
+                    {
+                        it = ntheta - 1;
+                    }
+                    bin = (uint32_t)(it * nr + ir);
+
+                    for(k = 0; k < npixbin; k++)
+                    {
+                        if(pixbin[k] == bin)
+                        {
+                            break;
+                        }
+                    }
+                    if(k == npixbin)
+                    {
+                        pixbin[npixbin] = bin;
+                        pixw[npixbin]   = 0.0;
+                        npixbin++;
+                    }
+                    pixw[k] += wsub;
+                }
+
+            for(int k = 0; k < npixbin; k++)
+            {
+                if(NBtriplet == NBtripletmax)
+                {
+                    NBtripletmax *= 2;
+                    tripletout = (uint32_t *) realloc(
+                                     tripletout, sizeof(uint32_t) * NBtripletmax);
+                    tripletin = (uint32_t *) realloc(
+                                    tripletin, sizeof(uint32_t) * NBtripletmax);
+                    tripletw = (float *) realloc(
+                                   tripletw, sizeof(float) * NBtripletmax);
+                    if((tripletout == NULL) || (tripletin == NULL) ||
+                            (tripletw == NULL))
+                    {
+                        PRINT_ERROR("realloc returns NULL pointer");
+                        abort();
+                    }
+                }
+                tripletout[NBtriplet] = pixbin[k];
+                tripletin[NBtriplet]  = (uint32_t) pix;
+                tripletw[NBtriplet]   = pixw[k];
+                NBtriplet++;
+
+                polarmap->rowstart[pixbin[k] + 1]++;
+                rowsum[pixbin[k]] += pixw[k];
+            }
+        }
+
+    // counting sort of triplets into CSR rows
+    for(uint64_t k = 0; k < nbout; k++)
+    {
+        polarmap->rowstart[k + 1] += polarmap->rowstart[k];
+    }
+
+    polarmap->nnz      = NBtriplet;
+    polarmap->colindex = (uint32_t *) malloc(sizeof(uint32_t) * NBtriplet);
+    polarmap->weight   = (float *) malloc(sizeof(float) * NBtriplet);
+    if((polarmap->colindex == NULL) || (polarmap->weight == NULL))
+    {
+        PRINT_ERROR("malloc returns NULL pointer");
+        abort();
+    }
+
+    {
+        uint64_t *rowfill = (uint64_t *) malloc(sizeof(uint64_t) * nbout);
+        if(rowfill == NULL)
+        {
+            PRINT_ERROR("malloc returns NULL pointer");
+            abort();
+        }
+        memcpy(rowfill, polarmap->rowstart, sizeof(uint64_t) * nbout);
+
+        for(uint64_t t = 0; t < NBtriplet; t++)
+        {
+            uint64_t k              = rowfill[tripletout[t]]++;
+            polarmap->colindex[k] = tripletin[t];
+            polarmap->weight[k]   = tripletw[t] / rowsum[tripletout[t]];
+        }
+        free(rowfill);
+    }
+
+    free(tripletout);
+    free(tripletin);
+    free(tripletw);
+    free(pixbin);
+    free(pixw);
+    free(rowsum);
+
+    return RETURN_SUCCESS;
+}
+
+/**
+ * @brief Get polar resampling matrix for geometry, building it if needed
+ *
+ * maskimage is a float image of same size as the input image, pixels > 0.5
+ * are included. Use NULL for no mask. Returns NULL if nr, ntheta or rstep
+ * is not positive, or if the mask type or size does not match.
+ */
+POLAR_MAP *polar_map_get(uint32_t xsize,
+                         uint32_t ysize,
+                         double   xcenter,
+                         double   ycenter,
+                         double   rstep,
+                         uint32_t nr,
+                         uint32_t ntheta,
+                         int      oversamp,
+                         IMAGE   *maskimage)
+{
+    POLAR_MAP *polarmap;
+
+    if((nr < 1) || (ntheta < 1) || !(rstep > 0.0))
+    {
+        PRINT_ERROR("invalid polar geometry : nr %u ntheta %u rstep %g",
+                    nr,
+                    ntheta,
+                    rstep);
+        return NULL;
+    }
+    if((maskimage != NULL) &&
+            ((maskimage->md[0].datatype != _DATATYPE_FLOAT) ||
+             (maskimage->md[0].nelement != (uint64_t) xsize * ysize)))
+    {
+        PRINT_ERROR("mask %s : float image of %ux%u pixels required",
+                    maskimage->name,
+                    xsize,
+                    ysize);
+        return NULL;
+    }
+
+    if(oversamp < 1)
+    {
+        oversamp = 1;
+    }
+
+    for(int c = 0; c < POLAR_MAP_CACHESIZE; c++)
+    {
+        if(polar_map_match(&polarmapcache[c],
+                           xsize,
+                           ysize,
+                           xcenter,
+                           ycenter,
+                           rstep,
+                           nr,
+                           ntheta,
+                           oversamp,
+                           maskimage) == 1)
+        {
+            return &polarmapcache[c];
+        }
+    }
+
+    polarmap           = &polarmapcache[polarmapcache_next];
+    polarmapcache_next = (polarmapcache_next + 1) % POLAR_MAP_CACHESIZE;
+
+    polar_map_build(polarmap,
+                    xsize,
+                    ysize,
+                    xcenter,
+                    ycenter,
+                    rstep,
+                    nr,
+                    ntheta,
+                    oversamp,
+                    maskimage);
+
+    return polarmap;
+}
+
+#define POLAR_MAP_SPMV(arrayptr)                                               \
+    do                                                                         \
+    {                                                                          \
+        for(uint64_t k = kstart; k < kend; k++)                                \
+        {                                                                      \
+            float sum = 0.0;                                                   \
+            _Pragma("omp simd reduction(+:sum)")                               \
+            for(uint64_t nz = rowstart[k]; nz < rowstart[k + 1]; nz++)         \
+            {                                                                  \
+                sum += weight[nz] * (float) (arrayptr)[colindex[nz]];          \
+            }                                                                  \
+            outarray[k] = sum;                                                 \
+        }                                                                      \
+    } while(0)
+
+// output elements [kstart, kend)
+INFO_SIMD_CLONES
+static errno_t polar_map_spmv(POLAR_MAP *polarmap,
+                              IMAGE     *image,
+                              uint64_t   kstart,
+                              uint64_t   kend,
+                              float     *outarray)
+{
+    uint64_t *rowstart = polarmap->rowstart;
+    uint32_t *colindex = polarmap->colindex;
+    float    *weight   = polarmap->weight;
+
+    switch(image->md[0].datatype)
+    {
+        case _DATATYPE_FLOAT:
+            POLAR_MAP_SPMV(image->array.F);
+            break;
+        case _DATATYPE_DOUBLE:
+            POLAR_MAP_SPMV(image->array.D);
+            break;
+        case _DATATYPE_UINT8:
+            POLAR_MAP_SPMV(image->array.UI8);
+            break;
+        case _DATATYPE_INT8:
+            POLAR_MAP_SPMV(image->array.SI8);
+            break;
+        case _DATATYPE_UINT16:
+            POLAR_MAP_SPMV(image->array.UI16);
+            break;
+        case _DATATYPE_INT16:
+            POLAR_MAP_SPMV(image->array.SI16);
+            break;
+        case _DATATYPE_UINT32:
+            POLAR_MAP_SPMV(image->array.UI32);
+            break;
+        case _DATATYPE_INT32:
+            POLAR_MAP_SPMV(image->array.SI32);
+            break;
+        case _DATATYPE_UINT64:
+            POLAR_MAP_SPMV(image->array.UI64);
+            break;
+        case _DATATYPE_INT64:
+            POLAR_MAP_SPMV(image->array.SI64);
+            break;
+        default:
+            return RETURN_FAILURE;
+    }
+
+    return RETURN_SUCCESS;
+}
+
+typedef struct
+{
+    POLAR_MAP *polarmap;
+    IMAGE     *image;
+    float     *outarray;
+    atomic_int ret;
+} POLAR_MAP_JOB;
+
+static void polar_map_task(void *arg, int task, int nbtask)
+{
+    POLAR_MAP_JOB *job   = (POLAR_MAP_JOB *) arg;
+    uint64_t       nbout = (uint64_t) job->polarmap->nr * job->polarmap->ntheta;
+    uint64_t       kstart;
+    uint64_t       kend;
+
+    info_pool_range(nbout, task, nbtask, &kstart, &kend);
+    if(polar_map_spmv(job->polarmap, job->image, kstart, kend, job->outarray) !=
+            RETURN_SUCCESS)
+    {
+        atomic_store(&job->ret, RETURN_FAILURE);
+    }
+}
+
+/**
+ * @brief Resample image to polar coordinates
+ *
+ * outarray has nr x ntheta elements. Empty polar bins (near center, or
+ * fully masked) are set to 0.
+ */
+errno_t polar_map_apply(POLAR_MAP *polarmap, IMAGE *image, float *outarray)
+{
+    INFO_INSTR_SCOPE("polar_map_apply");
+
+    uint64_t      nbout = (uint64_t) polarmap->nr * polarmap->ntheta;
+    POLAR_MAP_JOB job   = {polarmap, image, outarray, RETURN_SUCCESS};
+
+    if(image->md[0].nelement < (uint64_t) polarmap->xsize * polarmap->ysize)
+    {
+        PRINT_ERROR("image %s smaller than polar map geometry", image->name);
+        return RETURN_FAILURE;
+    }
+
+    info_pool_run(info_pool_nbtask(nbout, POLAR_NBOUT_THREAD),
+                  polar_map_task,
+                  &job);
+
+    if(atomic_load(&job.ret) != RETURN_SUCCESS)
+    {
+        PRINT_ERROR("datatype not supported");
+        return RETURN_FAILURE;
+    }
+
+    return RETURN_SUCCESS;
+}
+
+static errno_t compute_function()
+{
+    DEBUG_TRACE_FSTART();
+
+    imageID ID = image_ID(instreamname);
+
+    if((*nrbin < 1) || (*nthetabin < 1) || !(*rstep > 0.0))
+    {
+        PRINT_ERROR(".nr and .ntheta must be >= 1, .rstep > 0");
+        DEBUG_TRACE_FEXIT();
+        return RETURN_FAILURE;
+    }
+
+    IMAGE  *maskimage = NULL;
+    imageID IDmask    = image_ID(maskname);
+    if(IDmask != -1)
+    {
+        // mask is read per pixel : float image of stream size required
+        if((data.image[IDmask].md[0].datatype == _DATATYPE_FLOAT) &&
+                (data.image[IDmask].md[0].nelement ==
+                 data.image[ID].md[0].nelement))
+        {
+            maskimage = &data.image[IDmask];
+        }
+        else
+        {
+            PRINT_WARNING("mask %s : float image of stream size required, "
+                          "ignored",
+                          maskname);
+        }
+    }
+
+    // output size fixed at startup
+    uint32_t NRbin     = (uint32_t) *nrbin;
+    uint32_t NTHETAbin = (uint32_t) *nthetabin;
+
+    imageID  IDout;
+    uint32_t sizeout[2];
+    sizeout[0] = NRbin;
+    sizeout[1] = NTHETAbin;
+    create_image_ID(outstreamname,
+                    2,
+                    sizeout,
+                    _DATATYPE_FLOAT,
+                    1,
+                    0,
+                    0,
+                    &IDout);
+
+    INSERT_STD_PROCINFO_COMPUTEFUNC_INIT
+
+    INSERT_STD_PROCINFO_COMPUTEFUNC_LOOPSTART
+    {
+        POLAR_MAP *polarmap = polar_map_get(data.image[ID].md[0].size[0],
+                                            data.image[ID].md[0].size[1],
+                                            *xcenter,
+                                            *ycenter,
+                                            *rstep,
+                                            NRbin,
+                                            NTHETAbin,
+                                            (int) *oversampling,
+                                            maskimage);
+
+        // NULL if .rstep was set invalid at runtime : frame skipped
+        if(polarmap != NULL)
+        {
+            data.image[IDout].md[0].write = 1;
+            polar_map_apply(polarmap,
+                            &data.image[ID],
+                            data.image[IDout].array.F);
+            processinfo_update_output_stream(processinfo, IDout);
+        }
+    }
+    INSERT_STD_PROCINFO_COMPUTEFUNC_END
+
+    DEBUG_TRACE_FEXIT();
+    return RETURN_SUCCESS;
+}
+
+INSERT_STD_FPSCLIfunctions
+
+// Register function in CLI
+errno_t CLIADDCMD_info__impolar()
+{
+    INSERT_STD_CLIREGISTERFUNC
+
+    return RETURN_SUCCESS;
+}
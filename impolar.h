@@ -0,0 +1,46 @@
+/**
+ * @file    impolar.h
+ */
+
+#ifndef _INFO_IMPOLAR_H
+#define _INFO_IMPOLAR_H
+
+// Sparse polar resampling matrix, CSR format
+// Row k = it * nr + ir is output polar pixel (ir, it)
+// Weights are pixel area fractions, normalized so that each non-empty row
+// sums to 1
+typedef struct
+{
+    uint32_t xsize;
+    uint32_t ysize;
+    double   xcenter;
+    double   ycenter;
+    double   rstep;
+    uint32_t nr;
+    uint32_t ntheta;
+    int      oversamp;
+
+    IMAGE   *maskimage; // NULL if no mask
+    uint64_t maskcnt0;
+
+    uint64_t  nnz;
+    uint64_t *rowstart; // [nr * ntheta + 1]
+    uint32_t *colindex; // [nnz] input pixel index
+    float    *weight;   // [nnz]
+} POLAR_MAP;
+
+POLAR_MAP *polar_map_get(uint32_t xsize,
+                         uint32_t ysize,
+                         double   xcenter,
+                         double   ycenter,
+                         double   rstep,
+                         uint32_t nr,
+                         uint32_t ntheta,
+                         int      oversamp,
+                         IMAGE   *maskimage);
+
+errno_t polar_map_apply(POLAR_MAP *polarmap, IMAGE *image, float *outarray);
+
+errno_t CLIADDCMD_info__impolar();
+
+#endif
@@ -8,6 +8,11 @@
 
 #include "COREMOD_memory/COREMOD_memory.h"
 
+#include "imcenter.h"
+#include "improfile.h"
+#include "improfile_binmap.h"
+#include "info_scratch.h"
+
 
 // ==========================================
 // Forward declaration(s)
@@ -20,6 +25,20 @@ errno_t profile(const char *ID_name,
                 double      step,
                 long        nb_step);
 
+errno_t profile_autocenter(const char *ID_name,
+                           const char *outfile,
+                           double      step,
+                           long        nb_step,
+                           long        window,
+                           int         mode);
+
+errno_t profile2im_image(const char   *profim_name,
+                         unsigned long size,
+                         double        xcenter,
+                         double        ycenter,
+                         double        radius,
+                         const char   *out);
+
 // ==========================================
 // Command line interface wrapper function(s)
 // ==========================================
@@ -45,6 +64,49 @@ errno_t info_profile_cli()
     }
 }
 
+errno_t info_profile_autocenter_cli()
+{
+    if(CLI_checkarg(1, CLIARG_IMG) + CLI_checkarg(2, CLIARG_STR_NOT_IMG) +
+            CLI_checkarg(3, CLIARG_FLOAT64) + CLI_checkarg(4, CLIARG_INT64) +
+            CLI_checkarg(5, CLIARG_INT64) + CLI_checkarg(6, CLIARG_INT64) ==
+            0)
+    {
+        profile_autocenter(data.cmdargtoken[1].val.string,
+                           data.cmdargtoken[2].val.string,
+                           data.cmdargtoken[3].val.numf,
+                           data.cmdargtoken[4].val.numl,
+                           data.cmdargtoken[5].val.numl,
+                           (int) data.cmdargtoken[6].val.numl);
+        return CLICMD_SUCCESS;
+    }
+    else
+    {
+        return CLICMD_INVALID_ARG;
+    }
+}
+
+errno_t info_profile2im_cli()
+{
+    if(CLI_checkarg(1, CLIARG_IMG) + CLI_checkarg(2, CLIARG_INT64) +
+            CLI_checkarg(3, CLIARG_FLOAT64) + CLI_checkarg(4, CLIARG_FLOAT64) +
+            CLI_checkarg(5, CLIARG_FLOAT64) +
+            CLI_checkarg(6, CLIARG_STR_NOT_IMG) ==
+            0)
+    {
+        profile2im_image(data.cmdargtoken[1].val.string,
+                         data.cmdargtoken[2].val.numl,
+                         data.cmdargtoken[3].val.numf,
+                         data.cmdargtoken[4].val.numf,
+                         data.cmdargtoken[5].val.numf,
+                         data.cmdargtoken[6].val.string);
+        return CLICMD_SUCCESS;
+    }
+    else
+    {
+        return CLICMD_INVALID_ARG;
+    }
+}
+
 // ==========================================
 // Register CLI command(s)
 // ==========================================
@@ -62,6 +124,63 @@ errno_t improfile_addCLIcmd()
         "double ycenter, double "
         "step, long nb_step)");
 
+    RegisterCLIcommand(
+        "profilec",
+        __FILE__,
+        info_profile_autocenter_cli,
+        "radial profile around brightest spot",
+        "<image> <output file> <step> <Nbstep> <window> <mode 0:centroid "
+        "1:peakfit>",
+        "profilec psf psf.prof 1.0 100 5 0",
+        "errno_t profile_autocenter(const char *ID_name, const char *outfile, "
+        "double step, long nb_step, long window, int mode)");
+
+    RegisterCLIcommand(
+        "profile2im",
+        __FILE__,
+        info_profile2im_cli,
+        "2D image from radial profile image",
+        "<profile image> <size> <xcenter> <ycenter> <radius> <output image>",
+        "profile2im psfprof 512 256 256 100.0 psfmodel",
+        "errno_t profile2im_image(const char *profim_name, unsigned long size, "
+        "double xcenter, double ycenter, double radius, const char *out)");
+
+    return RETURN_SUCCESS;
+}
+
+// columns : distance mean RMS count index min max
+// empty bins are skipped
+static errno_t profile_write_file(const char      *outfile,
+                                  double          *dist,
+                                  PROFILE_BINSTAT *binstat,
+                                  long             nb_step)
+{
+    FILE *fp;
+
+    if((fp = fopen(outfile, "w")) == NULL)
+    {
+        printf("error : can't open file %s\n", outfile);
+        return RETURN_FAILURE;
+    }
+
+    for(long i = 0; i < nb_step; i++)
+    {
+        if(binstat[i].cnt > 0)
+        {
+            fprintf(fp,
+                    "%.18f %.18g %.18g %ld %ld %.18g %.18g\n",
+                    dist[i],
+                    binstat[i].mean,
+                    profile_binstat_rms(&binstat[i]),
+                    binstat[i].cnt,
+                    i,
+                    binstat[i].min,
+                    binstat[i].max);
+        }
+    }
+
+    fclose(fp);
+
     return RETURN_SUCCESS;
 }
 
@@ -72,162 +191,255 @@ errno_t profile(const char *ID_name,
                 double      step,
                 long        nb_step)
 {
-    imageID  ID;
-    uint32_t naxes[2];
-    uint64_t nelements;
-    double   distance;
-    double  *dist;
-    double  *mean;
-    double  *rms;
-    long    *counts;
-    FILE    *fp;
-    long     i;
-
-    int *mask;
-    long IDmask; // if profmask exists
-
-    ID        = image_ID(ID_name);
-    naxes[0]  = data.image[ID].md[0].size[0];
-    naxes[1]  = data.image[ID].md[0].size[1];
-    nelements = naxes[0] * naxes[1];
-
-    dist = (double *) malloc(nb_step * sizeof(double));
-    if(dist == NULL)
-    {
-        PRINT_ERROR("malloc returns NULL pointer");
-        abort();
-    }
+    imageID          ID;
+    PROFILE_BINSTAT *binstat;
+    PROFILE_BINMAP  *binmap;
+    size_t           scratchmark = info_scratch_mark();
+
+    IMAGE *maskimage = NULL;
+    long   IDmask; // if profmask exists
+
+    ID = image_ID(ID_name);
 
-    mean = (double *) malloc(nb_step * sizeof(double));
-    if(mean == NULL)
+    binstat = (PROFILE_BINSTAT *) info_scratch_alloc(nb_step *
+              sizeof(PROFILE_BINSTAT));
+
+    IDmask = image_ID("profmask");
+    if(IDmask != -1)
     {
-        PRINT_ERROR("malloc returns NULL pointer");
-        abort();
+        maskimage = &data.image[IDmask];
     }
 
-    rms = (double *) malloc(nb_step * sizeof(double));
-    if(rms == NULL)
+    //  if( Debug )
+    // printf("Function profile. center = %f %f, step = %f, NBstep =
+    // %ld\n",xcenter,ycenter,step,nb_step);
+
+    binmap = profile_binmap_get(data.image[ID].md[0].size[0],
+                                data.image[ID].md[0].size[1],
+                                xcenter,
+                                ycenter,
+                                step,
+                                nb_step,
+                                maskimage);
+    if(binmap == NULL)
     {
-        PRINT_ERROR("malloc returns NULL pointer");
-        abort();
+        info_scratch_release(scratchmark);
+        return RETURN_FAILURE;
     }
 
-    counts = (long *) malloc(nb_step * sizeof(long));
-    if(counts == NULL)
+    // single pass : mean, RMS, min, max and count per bin
+    profile_binmap_accumulate(binmap, &data.image[ID], binstat);
+
+    profile_write_file(outfile, binmap->dist, binstat, nb_step);
+
+    info_scratch_release(scratchmark);
+
+    return RETURN_SUCCESS;
+}
+
+/**
+ * @brief Radial profile centered on brightest spot
+ *
+ * Center is found with image_center_find() (window centroid or peak fit),
+ * then the profile is computed with distances evaluated on the fly. Two
+ * passes : binning needs the center first. The peak search is a compare
+ * only pass over the frame, and the profile pass only reads pixels within
+ * step * nb_step of the center. Center is stored in variables profxc and
+ * profyc.
+ */
+errno_t profile_autocenter(const char *ID_name,
+                           const char *outfile,
+                           double      step,
+                           long        nb_step,
+                           long        window,
+                           int         mode)
+{
+    imageID          ID;
+    PROFILE_BINSTAT *binstat;
+    double          *dist;
+    double           xcenter;
+    double           ycenter;
+
+    IMAGE *maskimage = NULL;
+    long   IDmask; // if profmask exists
+
+    ID = image_ID(ID_name);
+
+    IDmask = image_ID("profmask");
+    if(IDmask != -1)
     {
-        PRINT_ERROR("malloc returns NULL pointer");
-        abort();
+        maskimage = &data.image[IDmask];
     }
 
-    mask = (int *) malloc(sizeof(int) * nelements);
-    if(mask == NULL)
+    FUNC_CHECK_RETURN(image_center_find(&data.image[ID],
+                                        mode,
+                                        window,
+                                        0.0,
+                                        0.0,
+                                        0,
+                                        &xcenter,
+                                        &ycenter));
+
+    printf("profile center = %f %f\n", xcenter, ycenter);
+    create_variable_ID("profxc", xcenter);
+    create_variable_ID("profyc", ycenter);
+
+    size_t scratchmark = info_scratch_mark();
+    binstat            = (PROFILE_BINSTAT *) info_scratch_alloc(nb_step *
+                         sizeof(PROFILE_BINSTAT));
+    dist = (double *) info_scratch_alloc(nb_step * sizeof(double));
+
+    if(profile_accumulate_direct(&data.image[ID],
+                                 xcenter,
+                                 ycenter,
+                                 step,
+                                 nb_step,
+                                 maskimage,
+                                 dist,
+                                 binstat) != RETURN_SUCCESS)
     {
-        PRINT_ERROR("malloc returns NULL pointer");
-        abort();
+        info_scratch_release(scratchmark);
+        return RETURN_FAILURE;
     }
 
-    IDmask = image_ID("profmask");
-    if(IDmask != -1)
+    profile_write_file(outfile, dist, binstat, nb_step);
+
+    info_scratch_release(scratchmark);
+
+    return RETURN_SUCCESS;
+}
+
+// compute pixels [iistart, iiend) of output row
+static inline void profile2im_row(const double *profile_array,
+                                  long          nbpoints,
+                                  const double *dx2,
+                                  double        dy2,
+                                  double        scale,
+                                  unsigned long iistart,
+                                  unsigned long iiend,
+                                  float        *outrow)
+{
+    #pragma omp simd
+    for(unsigned long ii = iistart; ii < iiend; ii++)
     {
-        for(unsigned long ii = 0; ii < nelements; ii++)
-        {
-            if(data.image[IDmask].array.F[ii] > 0.5)
-            {
-                mask[ii] = 1;
-            }
-            else
-            {
-                mask[ii] = 0;
-            }
-        }
+        double u  = sqrt(dx2[ii] + dy2) * scale;
+        long   i  = (long) u;
+        double x  = u - i; // 0<x<1
+        long   i0 = (i < nbpoints) ? i : nbpoints - 1;
+        long   i1 = (i + 1 < nbpoints) ? i + 1 : nbpoints - 1;
+        double v  = (1.0 - x) * profile_array[i0] + x * profile_array[i1];
+
+        outrow[ii] = (i < nbpoints) ? (float) v : 0.0f;
     }
-    else
-        for(unsigned long ii = 0; ii < nelements; ii++)
-        {
-            mask[ii] = 1;
-        }
+}
 
-    //  if( Debug )
-    // printf("Function profile. center = %f %f, step = %f, NBstep =
-    // %ld\n",xcenter,ycenter,step,nb_step);
+/**
+ * @brief Build 2D image from radial profile array
+ *
+ * profile_array[i] is the value at distance i * radius / nbpoints from
+ * center, linearly interpolated between points. Pixels beyond radius are
+ * set to 0. outarray is size x size, row-major.
+ *
+ * If the center falls on a pixel or half-pixel, mirror symmetry is used :
+ * only one quadrant is computed, the rest is copied.
+ */
+errno_t profile2im_array(const double *profile_array,
+                         long          nbpoints,
+                         unsigned long size,
+                         double        xcenter,
+                         double        ycenter,
+                         double        radius,
+                         float        *outarray)
+{
+    double *dx2;
+    double  scale = nbpoints / radius;
+
+    // mirror index is (cx2 - ii) if 2 * center is integer, -1 otherwise
+    long cx2 = -1;
+    long cy2 = -1;
 
-    for(i = 0; i < nb_step; i++)
+    // last index computed before mirroring, see profile2im_row()
+    unsigned long iimirror0 = size;
+    unsigned long iimirror1 = size;
+
+    if(nbpoints < 1)
     {
-        dist[i]   = 0.0;
-        mean[i]   = 0.0;
-        rms[i]    = 0.0;
-        counts[i] = 0;
+        memset(outarray, 0, sizeof(float) * size * size);
+        return RETURN_SUCCESS;
     }
 
-    if((fp = fopen(outfile, "w")) == NULL)
+    if(fabs(2.0 * xcenter - floor(2.0 * xcenter + 0.5)) < 1.0e-9)
     {
-        printf("error : can't open file %s\n", outfile);
+        cx2 = (long) floor(2.0 * xcenter + 0.5);
+    }
+    if(fabs(2.0 * ycenter - floor(2.0 * ycenter + 0.5)) < 1.0e-9)
+    {
+        cy2 = (long) floor(2.0 * ycenter + 0.5);
     }
 
-    for(unsigned long jj = 0; jj < naxes[1]; jj++)
-        for(unsigned long ii = 0; ii < naxes[0]; ii++)
+    if(cx2 >= 0)
+    {
+        // pixels (cx2/2, cx2] are mirrors of [cx2 - ii]
+        iimirror0 = cx2 / 2 + 1;
+        iimirror1 = cx2 + 1;
+        if(iimirror0 > size)
+        {
+            iimirror0 = size;
+        }
+        if(iimirror1 > size)
         {
-            distance = sqrt((1.0 * ii - xcenter) * (1.0 * ii - xcenter) +
-                            (1.0 * jj - ycenter) * (1.0 * jj - ycenter));
-            i        = (long)(distance / step);
-            if((i < nb_step) && (mask[jj * naxes[0] + ii] == 1))
-            {
-                dist[i] += distance;
-                mean[i] += data.image[ID].array.F[jj * naxes[0] + ii];
-                rms[i] += data.image[ID].array.F[jj * naxes[0] + ii] *
-                          data.image[ID].array.F[jj * naxes[0] + ii];
-                counts[i] += 1;
-            }
+            iimirror1 = size;
         }
+    }
 
-    for(i = 0; i < nb_step; i++)
+    dx2 = (double *) malloc(sizeof(double) * size);
+    if(dx2 == NULL)
+    {
+        PRINT_ERROR("malloc returns NULL pointer");
+        abort();
+    }
+    for(unsigned long ii = 0; ii < size; ii++)
     {
-        dist[i] /= counts[i];
-        mean[i] /= counts[i];
-        rms[i] = 0.0;
+        dx2[ii] = (1.0 * ii - xcenter) * (1.0 * ii - xcenter);
     }
 
-    for(unsigned long jj = 0; jj < naxes[1]; jj++)
-        for(unsigned long ii = 0; ii < naxes[0]; ii++)
+    for(unsigned long jj = 0; jj < size; jj++)
+    {
+        float *outrow = outarray + jj * size;
+        long   jjm    = (cy2 >= 0) ? cy2 - (long) jj : -1;
+
+        if((jjm >= 0) && (jjm < (long) jj))
         {
-            distance = sqrt((1.0 * ii - xcenter) * (1.0 * ii - xcenter) +
-                            (1.0 * jj - ycenter) * (1.0 * jj - ycenter));
-            i        = (long) distance / step;
-            if((i < nb_step) && (mask[jj * naxes[0] + ii] == 1))
-            {
-                rms[i] +=
-                    (data.image[ID].array.F[jj * naxes[0] + ii] - mean[i]) *
-                    (data.image[ID].array.F[jj * naxes[0] + ii] - mean[i]);
-                //	  counts[i] += 1;
-            }
+            // mirror row already computed
+            memcpy(outrow, outarray + jjm * size, sizeof(float) * size);
+            continue;
         }
 
-    for(i = 0; i < nb_step; i++)
-    {
-        if(counts[i] > 0)
+        double dy2 = (1.0 * jj - ycenter) * (1.0 * jj - ycenter);
+
+        profile2im_row(profile_array,
+                       nbpoints,
+                       dx2,
+                       dy2,
+                       scale,
+                       0,
+                       iimirror0,
+                       outrow);
+        for(unsigned long ii = iimirror0; ii < iimirror1; ii++)
         {
-            //     dist[i] /= counts[i];
-            // mean[i] /= counts[i];
-            // rms[i] =
-            // sqrt(rms[i]-1.0*counts[i]*mean[i]*mean[i])/sqrt(counts[i]);
-            rms[i] = sqrt(rms[i] / counts[i]);
-            fprintf(fp,
-                    "%.18f %.18g %.18g %ld %ld\n",
-                    dist[i],
-                    mean[i],
-                    rms[i],
-                    counts[i],
-                    i);
+            outrow[ii] = outrow[cx2 - ii];
         }
+        profile2im_row(profile_array,
+                       nbpoints,
+                       dx2,
+                       dy2,
+                       scale,
+                       iimirror1,
+                       size,
+                       outrow);
     }
 
-    fclose(fp);
-    free(mask);
-
-    free(counts);
-    free(dist);
-    free(mean);
-    free(rms);
+    free(dx2);
 
     return RETURN_SUCCESS;
 }
@@ -248,7 +460,6 @@ errno_t profile2im(const char   *profile_name,
     long    i;
     long    index;
     double  tmp;
-    double  r, x;
 
     FUNC_CHECK_RETURN(create_2Dimage_ID(out, size, size, &ID));
 
@@ -275,25 +486,143 @@ errno_t profile2im(const char   *profile_name,
     }
     fclose(fp);
 
-    for(unsigned long ii = 0; ii < size; ii++)
-        for(unsigned long jj = 0; jj < size; jj++)
+    profile2im_array(profile_array,
+                     nbpoints,
+                     size,
+                     xcenter,
+                     ycenter,
+                     radius,
+                     data.image[ID].array.F);
+
+    free(profile_array);
+
+    DEBUG_TRACE_FEXIT();
+    return RETURN_SUCCESS;
+}
+
+/**
+ * @brief Copy one row of in-memory profile image to double array
+ *
+ * Profile image can be any real datatype. With row < 0, the row is the mean
+ * of an improfstream output (IMPROFSTREAM_NBROW rows), otherwise row 0.
+ * Returns number of points copied, -1 if row is out of range.
+ */
+long profile2im_readimage(IMAGE  *profimage,
+                          long    row,
+                          double *profile_array,
+                          long    nbpointsmax)
+{
+    long nbpoints = profimage->md[0].size[0];
+    long nbrow    = (profimage->md[0].naxis > 1) ? profimage->md[0].size[1] : 1;
+
+    if(row < 0)
+    {
+        row = (nbrow == IMPROFSTREAM_NBROW) ? IMPROFSTREAM_ROWMEAN : 0;
+    }
+    if(row >= nbrow)
+    {
+        PRINT_ERROR("profile row %ld out of range, image has %ld rows",
+                    row,
+                    nbrow);
+        return -1;
+    }
+
+    if(nbpoints > nbpointsmax)
+    {
+        nbpoints = nbpointsmax;
+    }
+
+    uint64_t offset = (uint64_t) row * profimage->md[0].size[0];
+
+    for(long i = 0; i < nbpoints; i++)
+    {
+        switch(profimage->md[0].datatype)
         {
-            r = sqrt((1.0 * ii - xcenter) * (1.0 * ii - xcenter) +
-                     (1.0 * jj - ycenter) * (1.0 * jj - ycenter)) /
-                radius;
-            i = (long)(r * nbpoints);
-            x = r * nbpoints - i; // 0<x<1
-
-            if(i + 1 < nbpoints)
-            {
-                data.image[ID].array.F[jj * size + ii] =
-                    (1.0 - x) * profile_array[i] + x * profile_array[i + 1];
-            }
-            else if(i < nbpoints)
-            {
-                data.image[ID].array.F[jj * size + ii] = profile_array[i];
-            }
+            case _DATATYPE_FLOAT:
+                profile_array[i] = profimage->array.F[offset + i];
+                break;
+            case _DATATYPE_DOUBLE:
+                profile_array[i] = profimage->array.D[offset + i];
+                break;
+            case _DATATYPE_UINT8:
+                profile_array[i] = profimage->array.UI8[offset + i];
+                break;
+            case _DATATYPE_INT8:
+                profile_array[i] = profimage->array.SI8[offset + i];
+                break;
+            case _DATATYPE_UINT16:
+                profile_array[i] = profimage->array.UI16[offset + i];
+                break;
+            case _DATATYPE_INT16:
+                profile_array[i] = profimage->array.SI16[offset + i];
+                break;
+            case _DATATYPE_UINT32:
+                profile_array[i] = profimage->array.UI32[offset + i];
+                break;
+            case _DATATYPE_INT32:
+                profile_array[i] = profimage->array.SI32[offset + i];
+                break;
+            case _DATATYPE_UINT64:
+                profile_array[i] = profimage->array.UI64[offset + i];
+                break;
+            case _DATATYPE_INT64:
+                profile_array[i] = profimage->array.SI64[offset + i];
+                break;
+            default:
+                profile_array[i] = 0.0;
+                break;
         }
+    }
+
+    return nbpoints;
+}
+
+/**
+ * @brief Build 2D image from radial profile stored in an image
+ *
+ * Profile is the mean row of image profim_name if it is an improfstream
+ * output, otherwise its first row. Number of points is the image x size.
+ */
+errno_t profile2im_image(const char   *profim_name,
+                         unsigned long size,
+                         double        xcenter,
+                         double        ycenter,
+                         double        radius,
+                         const char   *out)
+{
+    DEBUG_TRACE_FSTART();
+
+    imageID IDprof;
+    imageID ID;
+    double *profile_array;
+    long    nbpoints;
+
+    IDprof = image_ID(profim_name);
+    if(IDprof == -1)
+    {
+        PRINT_ERROR("profile image %s not found", profim_name);
+        return RETURN_FAILURE;
+    }
+    nbpoints = data.image[IDprof].md[0].size[0];
+
+    FUNC_CHECK_RETURN(create_2Dimage_ID(out, size, size, &ID));
+
+    profile_array = (double *) malloc(sizeof(double) * nbpoints);
+    if(profile_array == NULL)
+    {
+        PRINT_ERROR("malloc returns NULL pointer");
+        abort();
+    }
+
+    profile2im_readimage(&data.image[IDprof], -1, profile_array, nbpoints);
+
+    profile2im_array(profile_array,
+                     nbpoints,
+                     size,
+                     xcenter,
+                     ycenter,
+                     radius,
+                     data.image[ID].array.F);
 
     free(profile_array);
 
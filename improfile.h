@@ -2,6 +2,10 @@
  * @file    improfile.h
  */
 
+// improfstream output layout : nbstep x IMPROFSTREAM_NBROW, mean in row 1
+#define IMPROFSTREAM_NBROW   6
+#define IMPROFSTREAM_ROWMEAN 1
+
 errno_t improfile_addCLIcmd();
 
 errno_t profile(const char *ID_name,
@@ -11,6 +15,21 @@ errno_t profile(const char *ID_name,
                 double      step,
                 long        nb_step);
 
+errno_t profile_autocenter(const char *ID_name,
+                           const char *outfile,
+                           double      step,
+                           long        nb_step,
+                           long        window,
+                           int         mode);
+
+errno_t profile2im_array(const double *profile_array,
+                         long          nbpoints,
+                         unsigned long size,
+                         double        xcenter,
+                         double        ycenter,
+                         double        radius,
+                         float        *outarray);
+
 errno_t profile2im(const char   *profile_name,
                    long          nbpoints,
                    unsigned long size,
@@ -18,3 +37,15 @@ errno_t profile2im(const char   *profile_name,
                    double        ycenter,
                    double        radius,
                    const char   *out);
+
+long profile2im_readimage(IMAGE  *profimage,
+                          long    row,
+                          double *profile_array,
+                          long    nbpointsmax);
+
+errno_t profile2im_image(const char   *profim_name,
+                         unsigned long size,
+                         double        xcenter,
+                         double        ycenter,
+                         double        radius,
+                         const char   *out);
@@ -0,0 +1,657 @@
+/**
+ * @file    improfile_binmap.c
+ * @brief   cached radial bin index map for radial profiles
+ *
+ * The distance of each pixel to the profile center only depends on the
+ * geometry (image size, center, step, mask), not on pixel values.
+ * Bin indices are computed once per geometry and cached, so that a profile
+ * of a new frame costs one accumulate pass over the pixels.
+ */
+
+#include <math.h>
+#include <stdatomic.h>
+
+#include "info_core.h"
+
+#include "improfile_binmap.h"
+#include "info_instr.h"
+#include "info_pool.h"
+#include "info_scratch.h"
+#include "info_simd.h"
+
+// number of geometries kept in cache
+#define PROFILE_BINMAP_CACHESIZE 4
+
+// minimum number of pixels per thread
+#define PROFILE_NBPIX_THREAD 65536
+
+static PROFILE_BINMAP binmapcache[PROFILE_BINMAP_CACHESIZE];
+static int            binmapcache_next = 0;
+
+// mask must be a float image of nelements pixels
+static errno_t profile_mask_check(IMAGE *maskimage, uint64_t nelements)
+{
+    if(maskimage == NULL)
+    {
+        return RETURN_SUCCESS;
+    }
+    if((maskimage->md[0].datatype != _DATATYPE_FLOAT) ||
+            (maskimage->md[0].nelement != nelements))
+    {
+        PRINT_ERROR("mask %s : float image of %lu pixels required",
+                    maskimage->name,
+                    (unsigned long) nelements);
+        return RETURN_FAILURE;
+    }
+    return RETURN_SUCCESS;
+}
+
+static int profile_binmap_match(PROFILE_BINMAP *binmap,
+                                uint32_t        xsize,
+                                uint32_t        ysize,
+                                double          xcenter,
+                                double          ycenter,
+                                double          step,
+                                long            nb_step,
+                                IMAGE          *maskimage)
+{
+    if(binmap->binindex == NULL)
+    {
+        return 0;
+    }
+    if((binmap->xsize != xsize) || (binmap->ysize != ysize) ||
+            (binmap->xcenter != xcenter) || (binmap->ycenter != ycenter) ||
+            (binmap->step != step) || (binmap->nb_step != nb_step))
+    {
+        return 0;
+    }
+    if(binmap->maskimage != maskimage)
+    {
+        return 0;
+    }
+    if(maskimage != NULL)
+    {
+        if(binmap->maskcnt0 != maskimage->md[0].cnt0)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void profile_binmap_free(PROFILE_BINMAP *binmap)
+{
+    free(binmap->binindex);
+    free(binmap->dist);
+    free(binmap->counts);
+    binmap->binindex = NULL;
+    binmap->dist     = NULL;
+    binmap->counts   = NULL;
+}
+
+static errno_t profile_binmap_build(PROFILE_BINMAP *binmap,
+                                    uint32_t        xsize,
+                                    uint32_t        ysize,
+                                    double          xcenter,
+                                    double          ycenter,
+                                    double          step,
+                                    long            nb_step,
+                                    IMAGE          *maskimage)
+{
+    uint64_t nelements = (uint64_t) xsize * ysize;
+
+    profile_binmap_free(binmap);
+
+    binmap->xsize     = xsize;
+    binmap->ysize     = ysize;
+    binmap->xcenter   = xcenter;
+    binmap->ycenter   = ycenter;
+    binmap->step      = step;
+    binmap->nb_step   = nb_step;
+    binmap->maskimage = maskimage;
+    binmap->maskcnt0  = 0;
+
+    binmap->binindex = (int32_t *) malloc(sizeof(int32_t) * nelements);
+    if(binmap->binindex == NULL)
+    {
+        PRINT_ERROR("malloc returns NULL pointer");
+        abort();
+    }
+
+    binmap->dist = (double *) calloc(nb_step, sizeof(double));
+    if(binmap->dist == NULL)
+    {
+        PRINT_ERROR("malloc returns NULL pointer");
+        abort();
+    }
+
+    binmap->counts = (long *) calloc(nb_step, sizeof(long));
+    if(binmap->counts == NULL)
+    {
+        PRINT_ERROR("malloc returns NULL pointer");
+        abort();
+    }
+
+    if(maskimage != NULL)
+    {
+        binmap->maskcnt0 = maskimage->md[0].cnt0;
+    }
+
+    for(uint32_t jj = 0; jj < ysize; jj++)
+    {
+        double dy2 = (1.0 * jj - ycenter) * (1.0 * jj - ycenter);
+        for(uint32_t ii = 0; ii < xsize; ii++)
+        {
+            uint64_t pix = (uint64_t) jj * xsize + ii;
+            double   distance =
+                sqrt((1.0 * ii - xcenter) * (1.0 * ii - xcenter) + dy2);
+            long i = (long)(distance / step);
+
+            binmap->binindex[pix] = -1;
+            if(i < nb_step)
+            {
+                if((maskimage == NULL) ||
+                        (maskimage->array.F[pix] > 0.5))
+                {
+                    binmap->binindex[pix] = (int32_t) i;
+                    binmap->dist[i] += distance;
+                    binmap->counts[i]++;
+                }
+            }
+        }
+    }
+
+    for(long i = 0; i < nb_step; i++)
+    {
+        if(binmap->counts[i] > 0)
+        {
+            binmap->dist[i] /= binmap->counts[i];
+        }
+    }
+
+    return RETURN_SUCCESS;
+}
+
+/**
+ * @brief Get bin index map for geometry, building it if not in cache
+ *
+ * maskimage is a float image of same size as the input image, pixels > 0.5
+ * are included. Use NULL for no mask. The map is rebuilt if the mask cnt0
+ * changes. Returns NULL if the mask type or size does not match.
+ */
+PROFILE_BINMAP *profile_binmap_get(uint32_t xsize,
+                                   uint32_t ysize,
+                                   double   xcenter,
+                                   double   ycenter,
+                                   double   step,
+                                   long     nb_step,
+                                   IMAGE   *maskimage)
+{
+    PROFILE_BINMAP *binmap;
+
+    if(profile_mask_check(maskimage, (uint64_t) xsize * ysize) !=
+            RETURN_SUCCESS)
+    {
+        return NULL;
+    }
+
+    for(int c = 0; c < PROFILE_BINMAP_CACHESIZE; c++)
+    {
+        if(profile_binmap_match(&binmapcache[c],
+                                xsize,
+                                ysize,
+                                xcenter,
+                                ycenter,
+                                step,
+                                nb_step,
+                                maskimage) == 1)
+        {
+            return &binmapcache[c];
+        }
+    }
+
+    binmap           = &binmapcache[binmapcache_next];
+    binmapcache_next = (binmapcache_next + 1) % PROFILE_BINMAP_CACHESIZE;
+
+    profile_binmap_build(binmap,
+                         xsize,
+                         ysize,
+                         xcenter,
+                         ycenter,
+                         step,
+                         nb_step,
+                         maskimage);
+
+    return binmap;
+}
+
+/**
+ * @brief Initialize array of nb_step bin statistics
+ */
+void profile_binstat_init(PROFILE_BINSTAT *binstat, long nb_step)
+{
+    for(long i = 0; i < nb_step; i++)
+    {
+        binstat[i].cnt  = 0;
+        binstat[i].mean = 0.0;
+        binstat[i].M2   = 0.0;
+        binstat[i].min  = 0.0;
+        binstat[i].max  = 0.0;
+    }
+}
+
+static inline void profile_binstat_add(PROFILE_BINSTAT *binstat, double v)
+{
+    double delta;
+
+    if(binstat->cnt == 0)
+    {
+        binstat->min = v;
+        binstat->max = v;
+    }
+    else
+    {
+        if(v < binstat->min)
+        {
+            binstat->min = v;
+        }
+        if(v > binstat->max)
+        {
+            binstat->max = v;
+        }
+    }
+
+    binstat->cnt++;
+    delta = v - binstat->mean;
+    binstat->mean += delta / binstat->cnt;
+    binstat->M2 += delta * (v - binstat->mean);
+}
+
+/**
+ * @brief Merge partial bin statistics into binstat (Chan et al.)
+ */
+void profile_binstat_merge(PROFILE_BINSTAT *binstat,
+                           PROFILE_BINSTAT *binstatpart)
+{
+    long   cnt;
+    double delta;
+
+    if(binstatpart->cnt == 0)
+    {
+        return;
+    }
+    if(binstat->cnt == 0)
+    {
+        *binstat = *binstatpart;
+        return;
+    }
+
+    cnt   = binstat->cnt + binstatpart->cnt;
+    delta = binstatpart->mean - binstat->mean;
+
+    binstat->mean += delta * binstatpart->cnt / cnt;
+    binstat->M2 += binstatpart->M2 +
+                   delta * delta * binstat->cnt * binstatpart->cnt / cnt;
+    binstat->cnt = cnt;
+
+    if(binstatpart->min < binstat->min)
+    {
+        binstat->min = binstatpart->min;
+    }
+    if(binstatpart->max > binstat->max)
+    {
+        binstat->max = binstatpart->max;
+    }
+}
+
+/**
+ * @brief RMS of pixel values around bin mean, 0 for empty bin
+ */
+double profile_binstat_rms(PROFILE_BINSTAT *binstat)
+{
+    if(binstat->cnt == 0)
+    {
+        return 0.0;
+    }
+    return sqrt(binstat->M2 / binstat->cnt);
+}
+
+#define PROFILE_BINMAP_ACCUMULATE(arrayptr)                                    \
+    do                                                                         \
+    {                                                                          \
+        for(uint32_t jj = jjstart; jj < jjend; jj++)                           \
+        {                                                                      \
+            uint64_t pix0 = (uint64_t) jj * binmap->xsize;                     \
+            for(uint64_t pix = pix0; pix < pix0 + binmap->xsize; pix++)        \
+            {                                                                  \
+                int32_t b = binmap->binindex[pix];                             \
+                if(b >= 0)                                                     \
+                {                                                              \
+                    profile_binstat_add(&binstatpart[b],                       \
+                                        (double) (arrayptr)[pix]);             \
+                }                                                              \
+            }                                                                  \
+        }                                                                      \
+    } while(0)
+
+// accumulate rows [jjstart, jjend) into binstatpart
+INFO_SIMD_CLONES
+static errno_t profile_binmap_accumulate_rows(PROFILE_BINMAP  *binmap,
+        IMAGE           *image,
+        uint32_t         jjstart,
+        uint32_t         jjend,
+        PROFILE_BINSTAT *binstatpart)
+{
+    switch(image->md[0].datatype)
+    {
+        case _DATATYPE_FLOAT:
+            PROFILE_BINMAP_ACCUMULATE(image->array.F);
+            break;
+        case _DATATYPE_DOUBLE:
+            PROFILE_BINMAP_ACCUMULATE(image->array.D);
+            break;
+        case _DATATYPE_UINT8:
+            PROFILE_BINMAP_ACCUMULATE(image->array.UI8);
+            break;
+        case _DATATYPE_INT8:
+            PROFILE_BINMAP_ACCUMULATE(image->array.SI8);
+            break;
+        case _DATATYPE_UINT16:
+            PROFILE_BINMAP_ACCUMULATE(image->array.UI16);
+            break;
+        case _DATATYPE_INT16:
+            PROFILE_BINMAP_ACCUMULATE(image->array.SI16);
+            break;
+        case _DATATYPE_UINT32:
+            PROFILE_BINMAP_ACCUMULATE(image->array.UI32);
+            break;
+        case _DATATYPE_INT32:
+            PROFILE_BINMAP_ACCUMULATE(image->array.SI32);
+            break;
+        case _DATATYPE_UINT64:
+            PROFILE_BINMAP_ACCUMULATE(image->array.UI64);
+            break;
+        case _DATATYPE_INT64:
+            PROFILE_BINMAP_ACCUMULATE(image->array.SI64);
+            break;
+        default:
+            return RETURN_FAILURE;
+    }
+
+    return RETURN_SUCCESS;
+}
+
+// shared by profile_binmap_accumulate() and profile_accumulate_direct()
+typedef struct
+{
+    PROFILE_BINMAP  *binmap; // NULL for direct
+    IMAGE           *image;
+    double           xcenter;
+    double           ycenter;
+    double           step;
+    long             nb_step;
+    IMAGE           *maskimage;
+    PROFILE_BINSTAT *binstatpart; // nb_step bins per task
+    double          *distpart;    // nb_step distances per task, direct only
+    atomic_int       ret;
+} PROFILE_JOB;
+
+static void profile_binmap_task(void *arg, int task, int nbtask)
+{
+    PROFILE_JOB     *job         = (PROFILE_JOB *) arg;
+    PROFILE_BINSTAT *binstatpart = job->binstatpart + task * job->nb_step;
+    uint64_t         jjstart;
+    uint64_t         jjend;
+
+    info_pool_range(job->binmap->ysize, task, nbtask, &jjstart, &jjend);
+    profile_binstat_init(binstatpart, job->nb_step);
+    if(profile_binmap_accumulate_rows(job->binmap,
+                                      job->image,
+                                      (uint32_t) jjstart,
+                                      (uint32_t) jjend,
+                                      binstatpart) != RETURN_SUCCESS)
+    {
+        atomic_store(&job->ret, RETURN_FAILURE);
+    }
+}
+
+/**
+ * @brief Accumulate radial profile of image using bin index map
+ *
+ * Single read of the frame: mean, RMS, min, max and count of each bin are
+ * obtained with a running (Welford) update. Rows are split between the
+ * threads of the worker pool, each task accumulating into private bins that
+ * are merged at the end, in task order.
+ *
+ * binstat is an array of size binmap->nb_step.
+ */
+errno_t profile_binmap_accumulate(PROFILE_BINMAP  *binmap,
+                                  IMAGE           *image,
+                                  PROFILE_BINSTAT *binstat)
+{
+    INFO_INSTR_SCOPE("profile_binmap_accumulate");
+
+    uint64_t    nelements = (uint64_t) binmap->xsize * binmap->ysize;
+    int         nbtask = info_pool_nbtask(nelements, PROFILE_NBPIX_THREAD);
+    PROFILE_JOB job;
+
+    if(image->md[0].nelement < nelements)
+    {
+        PRINT_ERROR("image %s smaller than profile geometry", image->name);
+        return RETURN_FAILURE;
+    }
+
+    job.binmap      = binmap;
+    job.image       = image;
+    job.nb_step     = binmap->nb_step;
+    size_t scratchmark = info_scratch_mark();
+    job.binstatpart    = (PROFILE_BINSTAT *) info_scratch_alloc(
+                          sizeof(PROFILE_BINSTAT) * nbtask * binmap->nb_step);
+    atomic_init(&job.ret, RETURN_SUCCESS);
+
+    info_pool_run(nbtask, profile_binmap_task, &job);
+
+    profile_binstat_init(binstat, binmap->nb_step);
+    for(int task = 0; task < nbtask; task++)
+    {
+        for(long i = 0; i < binmap->nb_step; i++)
+        {
+            profile_binstat_merge(&binstat[i],
+                                  &job.binstatpart[task * binmap->nb_step + i]);
+        }
+    }
+
+    info_scratch_release(scratchmark);
+
+    if(atomic_load(&job.ret) != RETURN_SUCCESS)
+    {
+        PRINT_ERROR("datatype not supported");
+        return RETURN_FAILURE;
+    }
+
+    return RETURN_SUCCESS;
+}
+
+#define PROFILE_DIRECT_ACCUMULATE(arrayptr)                                    \
+    do                                                                         \
+    {                                                                          \
+        for(uint32_t jj = jjstart; jj < jjend; jj++)                           \
+        {                                                                      \
+            double dy2 = (1.0 * jj - ycenter) * (1.0 * jj - ycenter);          \
+            if(dy2 > rmax2)                                                    \
+            {                                                                  \
+                continue;                                                      \
+            }                                                                  \
+            double   dxmax   = sqrt(rmax2 - dy2);                              \
+            double   iistart = ceil(xcenter - dxmax);                          \
+            double   iiend   = floor(xcenter + dxmax) + 1.0;                   \
+            iistart = (iistart < 0.0) ? 0.0 : iistart;                         \
+            iiend   = (iiend > (double) xsize) ? (double) xsize : iiend;       \
+            if(iiend <= iistart)                                               \
+            {                                                                  \
+                continue;                                                      \
+            }                                                                  \
+            for(uint32_t ii = (uint32_t) iistart; ii < (uint32_t) iiend; ii++) \
+            {                                                                  \
+                uint64_t pix = (uint64_t) jj * xsize + ii;                     \
+                double   distance =                                            \
+                    sqrt((1.0 * ii - xcenter) * (1.0 * ii - xcenter) + dy2);   \
+                long b = (long)(distance / step);                              \
+                if(b < nb_step)                                                \
+                {                                                              \
+                    if((maskimage == NULL) ||                                  \
+                            (maskimage->array.F[pix] > 0.5))                   \
+                    {                                                          \
+                        distpart[b] += distance;                               \
+                        profile_binstat_add(&binstatpart[b],                   \
+                                            (double) (arrayptr)[pix]);         \
+                    }                                                          \
+                }                                                              \
+            }                                                                  \
+        }                                                                      \
+    } while(0)
+
+static void profile_direct_task(void *arg, int task, int nbtask)
+{
+    PROFILE_JOB     *job         = (PROFILE_JOB *) arg;
+    IMAGE           *image       = job->image;
+    IMAGE           *maskimage   = job->maskimage;
+    uint32_t         xsize       = image->md[0].size[0];
+    double           xcenter     = job->xcenter;
+    double           ycenter     = job->ycenter;
+    double           step        = job->step;
+    long             nb_step     = job->nb_step;
+    PROFILE_BINSTAT *binstatpart = job->binstatpart + task * nb_step;
+    double          *distpart    = job->distpart + task * nb_step;
+    double           rmax2       = (step * nb_step) * (step * nb_step);
+    uint64_t         jjstart;
+    uint64_t         jjend;
+
+    info_pool_range(image->md[0].size[1], task, nbtask, &jjstart, &jjend);
+    profile_binstat_init(binstatpart, nb_step);
+
+    switch(image->md[0].datatype)
+    {
+        case _DATATYPE_FLOAT:
+            PROFILE_DIRECT_ACCUMULATE(image->array.F);
+            break;
+        case _DATATYPE_DOUBLE:
+            PROFILE_DIRECT_ACCUMULATE(image->array.D);
+            break;
+        case _DATATYPE_UINT8:
+            PROFILE_DIRECT_ACCUMULATE(image->array.UI8);
+            break;
+        case _DATATYPE_INT8:
+            PROFILE_DIRECT_ACCUMULATE(image->array.SI8);
+            break;
+        case _DATATYPE_UINT16:
+            PROFILE_DIRECT_ACCUMULATE(image->array.UI16);
+            break;
+        case _DATATYPE_INT16:
+            PROFILE_DIRECT_ACCUMULATE(image->array.SI16);
+            break;
+        case _DATATYPE_UINT32:
+            PROFILE_DIRECT_ACCUMULATE(image->array.UI32);
+            break;
+        case _DATATYPE_INT32:
+            PROFILE_DIRECT_ACCUMULATE(image->array.SI32);
+            break;
+        case _DATATYPE_UINT64:
+            PROFILE_DIRECT_ACCUMULATE(image->array.UI64);
+            break;
+        case _DATATYPE_INT64:
+            PROFILE_DIRECT_ACCUMULATE(image->array.SI64);
+            break;
+        default:
+            atomic_store(&job->ret, RETURN_FAILURE);
+            break;
+    }
+}
+
+/**
+ * @brief Radial profile without bin index map
+ *
+ * Distances are computed on the fly. Used when the center changes every
+ * frame (auto-centering), where a cached map would be rebuilt each time.
+ * Each row is clipped to the disk of radius step * nb_step around the
+ * center : pixels beyond the last bin are not read.
+ * dist and binstat are arrays of size nb_step. dist is the average distance
+ * of pixels in each bin.
+ */
+errno_t profile_accumulate_direct(IMAGE           *image,
+                                  double           xcenter,
+                                  double           ycenter,
+                                  double           step,
+                                  long             nb_step,
+                                  IMAGE           *maskimage,
+                                  double          *dist,
+                                  PROFILE_BINSTAT *binstat)
+{
+    INFO_INSTR_SCOPE("profile_accumulate_direct");
+
+    uint64_t nelements = (uint64_t) image->md[0].size[0] * image->md[0].size[1];
+    int      nbtask    = info_pool_nbtask(nelements, PROFILE_NBPIX_THREAD);
+    PROFILE_JOB job;
+
+    if(profile_mask_check(maskimage, nelements) != RETURN_SUCCESS)
+    {
+        return RETURN_FAILURE;
+    }
+
+    job.binmap      = NULL;
+    job.image       = image;
+    job.xcenter     = xcenter;
+    job.ycenter     = ycenter;
+    job.step        = step;
+    job.nb_step     = nb_step;
+    job.maskimage   = maskimage;
+    size_t scratchmark = info_scratch_mark();
+    job.binstatpart    = (PROFILE_BINSTAT *) info_scratch_alloc(
+                          sizeof(PROFILE_BINSTAT) * nbtask * nb_step);
+    job.distpart = (double *) info_scratch_calloc(nbtask * nb_step,
+                                                  sizeof(double));
+    atomic_init(&job.ret, RETURN_SUCCESS);
+
+    info_pool_run(nbtask, profile_direct_task, &job);
+
+    profile_binstat_init(binstat, nb_step);
+    for(long i = 0; i < nb_step; i++)
+    {
+        dist[i] = 0.0;
+    }
+    for(int task = 0; task < nbtask; task++)
+    {
+        for(long i = 0; i < nb_step; i++)
+        {
+            dist[i] += job.distpart[task * nb_step + i];
+            profile_binstat_merge(&binstat[i],
+                                  &job.binstatpart[task * nb_step + i]);
+        }
+    }
+    for(long i = 0; i < nb_step; i++)
+    {
+        if(binstat[i].cnt > 0)
+        {
+            dist[i] /= binstat[i].cnt;
+        }
+    }
+
+    info_scratch_release(scratchmark);
+
+    if(atomic_load(&job.ret) != RETURN_SUCCESS)
+    {
+        PRINT_ERROR("datatype not supported");
+        return RETURN_FAILURE;
+    }
+
+    return RETURN_SUCCESS;
+}
+
+void profile_binmap_cache_free()
+{
+    for(int c = 0; c < PROFILE_BINMAP_CACHESIZE; c++)
+    {
+        profile_binmap_free(&binmapcache[c]);
+    }
+    binmapcache_next = 0;
+}
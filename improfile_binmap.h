@@ -0,0 +1,70 @@
+/**
+ * @file    improfile_binmap.h
+ */
+
+#ifndef _INFO_IMPROFILE_BINMAP_H
+#define _INFO_IMPROFILE_BINMAP_H
+
+// Precomputed radial bin index map
+// binindex[jj * xsize + ii] is the radial bin of pixel (ii,jj), or -1 if the
+// pixel is masked or beyond the last bin
+typedef struct
+{
+    uint32_t xsize;
+    uint32_t ysize;
+    double   xcenter;
+    double   ycenter;
+    double   step;
+    long     nb_step;
+
+    IMAGE   *maskimage; // NULL if no mask
+    uint64_t maskcnt0;  // mask cnt0 when map was built
+
+    int32_t *binindex;
+    double  *dist;   // average distance of pixels in bin
+    long    *counts; // number of pixels in bin
+} PROFILE_BINMAP;
+
+// Per-bin running statistics (Welford)
+// Partial results from separate pixel subsets are combined with
+// profile_binstat_merge()
+typedef struct
+{
+    long   cnt;
+    double mean;
+    double M2; // sum of squared deviations from mean
+    double min;
+    double max;
+} PROFILE_BINSTAT;
+
+PROFILE_BINMAP *profile_binmap_get(uint32_t xsize,
+                                   uint32_t ysize,
+                                   double   xcenter,
+                                   double   ycenter,
+                                   double   step,
+                                   long     nb_step,
+                                   IMAGE   *maskimage);
+
+void profile_binstat_init(PROFILE_BINSTAT *binstat, long nb_step);
+
+void profile_binstat_merge(PROFILE_BINSTAT *binstat,
+                           PROFILE_BINSTAT *binstatpart);
+
+double profile_binstat_rms(PROFILE_BINSTAT *binstat);
+
+errno_t profile_binmap_accumulate(PROFILE_BINMAP  *binmap,
+                                  IMAGE           *image,
+                                  PROFILE_BINSTAT *binstat);
+
+errno_t profile_accumulate_direct(IMAGE           *image,
+                                  double           xcenter,
+                                  double           ycenter,
+                                  double           step,
+                                  long             nb_step,
+                                  IMAGE           *maskimage,
+                                  double          *dist,
+                                  PROFILE_BINSTAT *binstat);
+
+void profile_binmap_cache_free();
+
+#endif
@@ -0,0 +1,301 @@
+/**
+ * @file    improfile_stream.c
+ * @brief   radial profile of image stream
+ *
+ * Computes radial profile of each new frame and writes it to an output
+ * stream. Output stream is 2D, size nbstep x 6 :
+ *     row 0 : average distance
+ *     row 1 : mean
+ *     row 2 : RMS
+ *     row 3 : number of pixels
+ *     row 4 : min
+ *     row 5 : max
+ *
+ * With .autocenter.enable, the center is located on each frame around the
+ * brightest spot, searching near the previous center, and written back to
+ * .xcenter and .ycenter.
+ */
+
+#include <math.h>
+
+#include "CommandLineInterface/CLIcore.h"
+
+#include "COREMOD_memory/COREMOD_memory.h"
+
+#include "imcenter.h"
+#include "improfile.h"
+#include "improfile_binmap.h"
+
+// Local variables pointers
+static char    *instreamname;
+static char    *outstreamname;
+static char    *maskname;
+static double  *xcenter;
+static double  *ycenter;
+static double  *step;
+static int64_t *nbstep;
+static int64_t *autocenter;
+static int64_t *acmode;
+static int64_t *acwindow;
+static int64_t *acsearch;
+
+static CLICMDARGDEF farg[] =
+{
+    {
+        CLIARG_IMG,
+        ".insname",
+        "input stream",
+        "im1",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &instreamname,
+        NULL
+    },
+    {
+        CLIARG_STR,
+        ".outsname",
+        "output profile stream",
+        "im1prof",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &outstreamname,
+        NULL
+    },
+    {
+        CLIARG_FLOAT64,
+        ".xcenter",
+        "center x coordinate [pix]",
+        "64.0",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &xcenter,
+        NULL
+    },
+    {
+        CLIARG_FLOAT64,
+        ".ycenter",
+        "center y coordinate [pix]",
+        "64.0",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &ycenter,
+        NULL
+    },
+    {
+        CLIARG_FLOAT64,
+        ".step",
+        "radial step [pix]",
+        "1.0",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &step,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".nbstep",
+        "number of radial steps",
+        "64",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &nbstep,
+        NULL
+    },
+    {
+        CLIARG_STR,
+        ".maskname",
+        "mask image, ignored if not loaded",
+        "profmask",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &maskname,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".autocenter.enable",
+        "find center on each frame (0/1)",
+        "0",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &autocenter,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".autocenter.mode",
+        "0: window centroid, 1: peak fit",
+        "0",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &acmode,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".autocenter.window",
+        "centroid window half-width [pix]",
+        "5",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &acwindow,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".autocenter.search",
+        "peak search half-width around previous center, 0 for full frame",
+        "20",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &acsearch,
+        NULL
+    }
+};
+
+static CLICMDDATA CLIcmddata =
+{
+    "improfstream", "radial profile of stream", CLICMD_FIELDS_DEFAULTS
+};
+
+// detailed help
+static errno_t help_function()
+{
+    printf("Compute radial profile of each new frame of input stream\n");
+    printf("Output stream rows: distance, mean, RMS, pixel count, min, "
+           "max\n");
+    printf("Bin index map is cached, and rebuilt only if geometry or mask "
+           "changes\n");
+    printf("With autocenter, distances are computed on the fly and the center "
+           "is written to .xcenter .ycenter\n");
+
+    return RETURN_SUCCESS;
+}
+
+static errno_t compute_function()
+{
+    DEBUG_TRACE_FSTART();
+
+    imageID ID = image_ID(instreamname);
+
+    IMAGE  *maskimage = NULL;
+    imageID IDmask    = image_ID(maskname);
+    if(IDmask != -1)
+    {
+        // mask is read per pixel : float image of stream size required
+        if((data.image[IDmask].md[0].datatype == _DATATYPE_FLOAT) &&
+                (data.image[IDmask].md[0].nelement ==
+                 data.image[ID].md[0].nelement))
+        {
+            maskimage = &data.image[IDmask];
+        }
+        else
+        {
+            PRINT_WARNING("mask %s : float image of stream size required, "
+                          "ignored",
+                          maskname);
+        }
+    }
+
+    long NBstep = *nbstep;
+
+    imageID  IDout;
+    uint32_t sizeout[2];
+    sizeout[0] = NBstep;
+    sizeout[1] = IMPROFSTREAM_NBROW;
+    create_image_ID(outstreamname,
+                    2,
+                    sizeout,
+                    _DATATYPE_FLOAT,
+                    1,
+                    0,
+                    0,
+                    &IDout);
+
+    PROFILE_BINSTAT *binstat =
+        (PROFILE_BINSTAT *) calloc(NBstep, sizeof(PROFILE_BINSTAT));
+    double *dist = (double *) calloc(NBstep, sizeof(double));
+    if((binstat == NULL) || (dist == NULL))
+    {
+        PRINT_ERROR("malloc returns NULL pointer");
+        abort();
+    }
+
+    // first frame : search peak over full frame
+    int centerinit = 0;
+
+    INSERT_STD_PROCINFO_COMPUTEFUNC_INIT
+
+    INSERT_STD_PROCINFO_COMPUTEFUNC_LOOPSTART
+    {
+        if(*autocenter == 1)
+        {
+            double xc;
+            double yc;
+            long   searchradius = (centerinit == 1) ? *acsearch : 0;
+
+            if(image_center_find(&data.image[ID],
+                                 (int) *acmode,
+                                 *acwindow,
+                                 *xcenter,
+                                 *ycenter,
+                                 searchradius,
+                                 &xc,
+                                 &yc) == RETURN_SUCCESS)
+            {
+                *xcenter   = xc;
+                *ycenter   = yc;
+                centerinit = 1;
+            }
+
+            profile_accumulate_direct(&data.image[ID],
+                                      *xcenter,
+                                      *ycenter,
+                                      *step,
+                                      NBstep,
+                                      maskimage,
+                                      dist,
+                                      binstat);
+        }
+        else
+        {
+            // cache lookup is cheap, map only rebuilt if geometry or mask
+            // changed
+            PROFILE_BINMAP *binmap =
+                profile_binmap_get(data.image[ID].md[0].size[0],
+                                   data.image[ID].md[0].size[1],
+                                   *xcenter,
+                                   *ycenter,
+                                   *step,
+                                   NBstep,
+                                   maskimage);
+
+            if(binmap != NULL)
+            {
+                profile_binmap_accumulate(binmap, &data.image[ID], binstat);
+                memcpy(dist, binmap->dist, sizeof(double) * NBstep);
+            }
+            centerinit = 0;
+        }
+
+        float *outarray = data.image[IDout].array.F;
+
+        data.image[IDout].md[0].write = 1;
+        for(long i = 0; i < NBstep; i++)
+        {
+            outarray[i]              = (float) dist[i];
+            outarray[NBstep + i]     = (float) binstat[i].mean;
+            outarray[2 * NBstep + i] = (float) profile_binstat_rms(&binstat[i]);
+            outarray[3 * NBstep + i] = (float) binstat[i].cnt;
+            outarray[4 * NBstep + i] = (float) binstat[i].min;
+            outarray[5 * NBstep + i] = (float) binstat[i].max;
+        }
+        processinfo_update_output_stream(processinfo, IDout);
+    }
+    INSERT_STD_PROCINFO_COMPUTEFUNC_END
+
+    free(binstat);
+    free(dist);
+
+    DEBUG_TRACE_FEXIT();
+    return RETURN_SUCCESS;
+}
+
+INSERT_STD_FPSCLIfunctions
+
+// Register function in CLI
+errno_t CLIADDCMD_info__improfile_stream()
+{
+    INSERT_STD_CLIREGISTERFUNC
+
+    return RETURN_SUCCESS;
+}
@@ -0,0 +1,10 @@
+/**
+ * @file    improfile_stream.h
+ */
+
+#ifndef _INFO_IMPROFILE_STREAM_H
+#define _INFO_IMPROFILE_STREAM_H
+
+errno_t CLIADDCMD_info__improfile_stream();
+
+#endif
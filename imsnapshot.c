@@ -0,0 +1,137 @@
+/**
+ * @file    imsnapshot.c
+ * @brief   consistent frame reads on live streams
+ *
+ * Kernels read the frame in shared memory while the writer may update it.
+ * A snapshot runs a function on the frame and checks, as a sequence lock
+ * reader would, that the write flag was off and cnt0 unchanged before and
+ * after : otherwise the result may mix two frames.
+ *
+ * The function first runs in place, no copy, which succeeds when frames
+ * arrive slower than the function runs. After IMSNAPSHOT_NBTRY_INPLACE
+ * failures the frame is copied to a buffer kept in the snapshot, with the
+ * same check around the copy only, and the function runs on the copy. If
+ * no copy is consistent either, the function runs on the last one and the
+ * snapshot is counted as torn.
+ */
+
+#include <sched.h>
+#include <string.h>
+
+#include "info_core.h"
+
+#include "imsnapshot.h"
+#include "info_instr.h"
+
+// frame counter, write flag into writing
+static uint64_t imsnapshot_begin(IMAGE_METADATA *md, int *writing)
+{
+    *writing = __atomic_load_n(&md->write, __ATOMIC_ACQUIRE);
+
+    return __atomic_load_n(&md->cnt0, __ATOMIC_ACQUIRE);
+}
+
+// frame unchanged since imsnapshot_begin()
+static int imsnapshot_valid(IMAGE_METADATA *md, uint64_t cnt0)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    return (__atomic_load_n(&md->write, __ATOMIC_ACQUIRE) == 0) &&
+           (__atomic_load_n(&md->cnt0, __ATOMIC_ACQUIRE) == cnt0);
+}
+
+static void imsnapshot_copy(IMSNAPSHOT *snap, IMAGE *image)
+{
+    size_t framesize = image->md[0].nelement *
+                       ImageStreamIO_typesize(image->md[0].datatype);
+
+    if(framesize > snap->bufsize)
+    {
+        free(snap->buf);
+        snap->buf = malloc(framesize);
+        if(snap->buf == NULL)
+        {
+            PRINT_ERROR("malloc returns NULL pointer");
+            abort();
+        }
+        snap->bufsize = framesize;
+    }
+    memcpy(snap->buf, image->array.raw, framesize);
+}
+
+/**
+ * @brief Run func on a consistent frame of image
+ *
+ * func(image, arg) may run several times, its outputs must be overwritten
+ * by each run. It receives image itself, or a view of a copy of the frame
+ * with the same metadata. snap must be zero-initialized before the first
+ * snapshot, and released by imsnapshot_free().
+ *
+ * Returns the status of func. snap->torn is set if the frame changed
+ * during every attempt.
+ */
+errno_t imsnapshot_run(IMSNAPSHOT     *snap,
+                       IMAGE          *image,
+                       IMSNAPSHOT_FUNC func,
+                       void           *arg)
+{
+    INFO_INSTR_SCOPE("imsnapshot_run");
+
+    IMAGE_METADATA *md = image->md;
+    uint64_t        cnt0;
+    int             writing;
+    errno_t         ret;
+
+    snap->nbsnap++;
+    snap->torn = 0;
+
+    for(int i = 0; i < IMSNAPSHOT_NBTRY_INPLACE; i++)
+    {
+        cnt0 = imsnapshot_begin(md, &writing);
+        if(writing)
+        {
+            sched_yield();
+            cnt0 = imsnapshot_begin(md, &writing);
+        }
+        ret = func(image, arg);
+        if((writing == 0) && imsnapshot_valid(md, cnt0))
+        {
+            snap->cnt0 = cnt0;
+            return ret;
+        }
+        snap->nbretry++;
+    }
+
+    int consistent = 0;
+    for(int i = 0; (i < IMSNAPSHOT_NBTRY_COPY) && (consistent == 0); i++)
+    {
+        cnt0 = imsnapshot_begin(md, &writing);
+        if(writing)
+        {
+            sched_yield();
+            cnt0 = imsnapshot_begin(md, &writing);
+        }
+        imsnapshot_copy(snap, image);
+        consistent = (writing == 0) && imsnapshot_valid(md, cnt0);
+    }
+
+    snap->md              = md[0];
+    snap->image           = *image;
+    snap->image.md        = &snap->md;
+    snap->image.array.raw = snap->buf;
+    snap->cnt0            = cnt0;
+    snap->nbcopy++;
+    if(consistent == 0)
+    {
+        snap->torn = 1;
+        snap->nbtorn++;
+    }
+
+    return func(&snap->image, arg);
+}
+
+void imsnapshot_free(IMSNAPSHOT *snap)
+{
+    free(snap->buf);
+    memset(snap, 0, sizeof(IMSNAPSHOT));
+}
@@ -0,0 +1,42 @@
+/**
+ * @file    imsnapshot.h
+ * @brief   consistent frame reads on live streams
+ */
+
+#ifndef _INFO_IMSNAPSHOT_H
+#define _INFO_IMSNAPSHOT_H
+
+// in-place attempts before copying the frame
+#define IMSNAPSHOT_NBTRY_INPLACE 2
+
+// copy attempts before giving up
+#define IMSNAPSHOT_NBTRY_COPY 4
+
+// function run on a consistent frame, must only depend on its inputs
+typedef errno_t (*IMSNAPSHOT_FUNC)(IMAGE *image, void *arg);
+
+typedef struct
+{
+    // copy of frame, kept between snapshots
+    void          *buf;
+    size_t         bufsize;
+    IMAGE          image; // view of copy
+    IMAGE_METADATA md;
+
+    uint64_t cnt0; // frame counter of last snapshot
+    int      torn; // last snapshot not consistent
+
+    uint64_t nbsnap;  // snapshots
+    uint64_t nbretry; // in-place reads repeated
+    uint64_t nbcopy;  // snapshots run on a copy
+    uint64_t nbtorn;  // snapshots run on an inconsistent frame
+} IMSNAPSHOT;
+
+errno_t imsnapshot_run(IMSNAPSHOT     *snap,
+                       IMAGE          *image,
+                       IMSNAPSHOT_FUNC func,
+                       void           *arg);
+
+void imsnapshot_free(IMSNAPSHOT *snap);
+
+#endif
@@ -0,0 +1,1107 @@
+/**
+ * @file    imstats.c
+ * @brief   pixel statistics kernels, CLIcore-independent
+ *
+ * Min, max, total, sum of squares and barycenter are obtained in a single
+ * read of the frame, rows split between the threads of the worker pool.
+ * Percentiles use a partial selection on a copy of the values, kept in the
+ * scratch arena of the calling thread, one selection per requested
+ * percentile, each restricted to the part of the array above the previous
+ * one.
+ *
+ * Sampled statistics copy a subset of the frame (box, mask and stride) to
+ * a buffer, on which the array kernels run : the cost is set by the sample
+ * size, not by the frame size. Stride 1 subsets are read in place.
+ *
+ * Cube functions operate on slices of a 3D image : per-slice statistics,
+ * slice-to-slice correlation and squared difference matrix.
+ *
+ * These kernels do not access the CLI image table, and are the compute
+ * layer of commands imstats, cubestats, cubeslmatch, of the image monitor
+ * and of percentile and timing statistics.
+ */
+
+#include <math.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#include "info_core.h"
+
+#include "imstats.h"
+#include "info_instr.h"
+#include "info_pool.h"
+#include "info_scratch.h"
+#include "info_simd.h"
+
+// minimum number of pixels per thread
+#define IMSTATS_NBPIX_THREAD 65536
+
+// masked rows
+#define IMSTATS_ROWS_MASK(arrayptr, checknan)                                  \
+    do                                                                         \
+    {                                                                          \
+        for(uint32_t jj = jjstart; jj < jjend; jj++)                           \
+        {                                                                      \
+            uint64_t offset  = (uint64_t) jj * pitch;                          \
+            double   rowtot  = 0.0;                                            \
+            double   rowtot2 = 0.0;                                            \
+            double   rowxtot = 0.0;                                            \
+            for(uint32_t ii = 0; ii < xsize; ii++)                             \
+            {                                                                  \
+                double v = (double) (arrayptr)[offset + ii];                   \
+                if(!(mask[offset + ii] > 0.5))                                 \
+                {                                                              \
+                    continue;                                                  \
+                }                                                              \
+                if((checknan) && isnan(v))                                     \
+                {                                                              \
+                    part->nbnan++;                                             \
+                    continue;                                                  \
+                }                                                              \
+                if(v < part->min)                                              \
+                {                                                              \
+                    part->min   = v;                                           \
+                    part->iimin = offset + ii;                                 \
+                }                                                              \
+                if(v > part->max)                                              \
+                {                                                              \
+                    part->max   = v;                                           \
+                    part->iimax = offset + ii;                                 \
+                }                                                              \
+                rowtot += v;                                                   \
+                rowtot2 += v * v;                                              \
+                rowxtot += v * ii;                                             \
+                part->nelement++;                                              \
+            }                                                                  \
+            part->total += rowtot;                                             \
+            part->total2 += rowtot2;                                           \
+            part->xbary += rowxtot;                                            \
+            part->ybary += rowtot * jj;                                        \
+        }                                                                      \
+    } while(0)
+
+// unmasked rows : branch-free reductions, vectorized
+// NaN fails min / max comparisons and is replaced by 0 in sums
+// positions of min and max are searched only in rows that improve them
+#define IMSTATS_ROWS(arrayptr, checknan)                                       \
+    do                                                                         \
+    {                                                                          \
+        for(uint32_t jj = jjstart; jj < jjend; jj++)                           \
+        {                                                                      \
+            uint64_t offset  = (uint64_t) jj * pitch;                          \
+            double   rowmin  = INFINITY;                                       \
+            double   rowmax  = -INFINITY;                                      \
+            double   rowtot  = 0.0;                                            \
+            double   rowtot2 = 0.0;                                            \
+            double   rowxtot = 0.0;                                            \
+            uint64_t rownan  = 0;                                              \
+            _Pragma("omp simd reduction(min:rowmin) reduction(max:rowmax) reduction(+:rowtot,rowtot2,rowxtot,rownan)") \
+            for(uint32_t ii = 0; ii < xsize; ii++)                             \
+            {                                                                  \
+                double v  = (double) (arrayptr)[offset + ii];                  \
+                double vs = v;                                                 \
+                if(checknan)                                                   \
+                {                                                              \
+                    int isn = (v != v);                                        \
+                    rownan += isn;                                             \
+                    vs = isn ? 0.0 : v;                                        \
+                }                                                              \
+                rowmin = (v < rowmin) ? v : rowmin;                            \
+                rowmax = (v > rowmax) ? v : rowmax;                            \
+                rowtot += vs;                                                  \
+                rowtot2 += vs * vs;                                            \
+                rowxtot += vs * ii;                                            \
+            }                                                                  \
+            if(rowmin < part->min)                                             \
+            {                                                                  \
+                part->min = rowmin;                                            \
+                for(uint32_t ii = 0; ii < xsize; ii++)                         \
+                {                                                              \
+                    if((double) (arrayptr)[offset + ii] == rowmin)             \
+                    {                                                          \
+                        part->iimin = offset + ii;                             \
+                        break;                                                 \
+                    }                                                          \
+                }                                                              \
+            }                                                                  \
+            if(rowmax > part->max)                                             \
+            {                                                                  \
+                part->max = rowmax;                                            \
+                for(uint32_t ii = 0; ii < xsize; ii++)                         \
+                {                                                              \
+                    if((double) (arrayptr)[offset + ii] == rowmax)             \
+                    {                                                          \
+                        part->iimax = offset + ii;                             \
+                        break;                                                 \
+                    }                                                          \
+                }                                                              \
+            }                                                                  \
+            part->nelement += xsize - rownan;                                  \
+            part->nbnan += rownan;                                             \
+            part->total += rowtot;                                             \
+            part->total2 += rowtot2;                                           \
+            part->xbary += rowxtot;                                            \
+            part->ybary += rowtot * jj;                                        \
+        }                                                                      \
+    } while(0)
+
+#define IMSTATS_DATATYPE_SWITCH(ROWS)                                          \
+    do                                                                         \
+    {                                                                          \
+        switch(datatype)                                                       \
+        {                                                                      \
+            case _DATATYPE_FLOAT:                                              \
+                ROWS((const float *) array, 1);                                \
+                break;                                                         \
+            case _DATATYPE_DOUBLE:                                             \
+                ROWS((const double *) array, 1);                               \
+                break;                                                         \
+            case _DATATYPE_UINT8:                                              \
+                ROWS((const uint8_t *) array, 0);                              \
+                break;                                                         \
+            case _DATATYPE_INT8:                                               \
+                ROWS((const int8_t *) array, 0);                               \
+                break;                                                         \
+            case _DATATYPE_UINT16:                                             \
+                ROWS((const uint16_t *) array, 0);                             \
+                break;                                                         \
+            case _DATATYPE_INT16:                                              \
+                ROWS((const int16_t *) array, 0);                              \
+                break;                                                         \
+            case _DATATYPE_UINT32:                                             \
+                ROWS((const uint32_t *) array, 0);                             \
+                break;                                                         \
+            case _DATATYPE_INT32:                                              \
+                ROWS((const int32_t *) array, 0);                              \
+                break;                                                         \
+            case _DATATYPE_UINT64:                                             \
+                ROWS((const uint64_t *) array, 0);                             \
+                break;                                                         \
+            case _DATATYPE_INT64:                                              \
+                ROWS((const int64_t *) array, 0);                              \
+                break;                                                         \
+            default:                                                           \
+                return RETURN_FAILURE;                                         \
+        }                                                                      \
+    } while(0)
+
+// accumulate rows [jjstart, jjend) into part, rows pitch values apart
+INFO_SIMD_CLONES
+static errno_t imstats_rows(const void  *array,
+                            uint8_t      datatype,
+                            uint32_t     xsize,
+                            uint64_t     pitch,
+                            uint32_t     jjstart,
+                            uint32_t     jjend,
+                            const float *mask,
+                            IMSTATS     *part)
+{
+    if(mask == NULL)
+    {
+        IMSTATS_DATATYPE_SWITCH(IMSTATS_ROWS);
+    }
+    else
+    {
+        IMSTATS_DATATYPE_SWITCH(IMSTATS_ROWS_MASK);
+    }
+
+    return RETURN_SUCCESS;
+}
+
+static void imstats_init(IMSTATS *imstats)
+{
+    memset(imstats, 0, sizeof(IMSTATS));
+    imstats->min = INFINITY;
+    imstats->max = -INFINITY;
+}
+
+static void imstats_merge(void *dst, const void *src)
+{
+    IMSTATS       *imstats = (IMSTATS *) dst;
+    const IMSTATS *part    = (const IMSTATS *) src;
+
+    if((part->min < imstats->min) ||
+            ((part->min == imstats->min) && (part->iimin < imstats->iimin)))
+    {
+        imstats->min   = part->min;
+        imstats->iimin = part->iimin;
+    }
+    if((part->max > imstats->max) ||
+            ((part->max == imstats->max) && (part->iimax < imstats->iimax)))
+    {
+        imstats->max   = part->max;
+        imstats->iimax = part->iimax;
+    }
+    imstats->nelement += part->nelement;
+    imstats->nbnan += part->nbnan;
+    imstats->total += part->total;
+    imstats->total2 += part->total2;
+    imstats->xbary += part->xbary;
+    imstats->ybary += part->ybary;
+}
+
+typedef struct
+{
+    const void  *array;
+    uint8_t      datatype;
+    uint32_t     xsize;
+    uint32_t     ysize;
+    uint64_t     pitch;
+    const float *mask;
+    atomic_int   ret;
+    IMSTATS      part[INFO_POOL_MAXTHREAD];
+} IMSTATS_JOB;
+
+static void imstats_task(void *arg, int task, int nbtask)
+{
+    IMSTATS_JOB *job = (IMSTATS_JOB *) arg;
+    uint64_t     jjstart;
+    uint64_t     jjend;
+
+    info_pool_range(job->ysize, task, nbtask, &jjstart, &jjend);
+    imstats_init(&job->part[task]);
+    if(imstats_rows(job->array,
+                    job->datatype,
+                    job->xsize,
+                    job->pitch,
+                    (uint32_t) jjstart,
+                    (uint32_t) jjend,
+                    job->mask,
+                    &job->part[task]) != RETURN_SUCCESS)
+    {
+        atomic_store(&job->ret, RETURN_FAILURE);
+    }
+}
+
+// imstats_array() on rows pitch values apart, mask with the same layout
+static errno_t imstats_array_pitch(const void  *array,
+                                   uint8_t      datatype,
+                                   uint32_t     xsize,
+                                   uint32_t     ysize,
+                                   uint64_t     pitch,
+                                   const float *mask,
+                                   IMSTATS     *imstats)
+{
+    IMSTATS_JOB job;
+    int         nbtask =
+        info_pool_nbtask((uint64_t) xsize * ysize, IMSTATS_NBPIX_THREAD);
+
+    job.array    = array;
+    job.datatype = datatype;
+    job.xsize    = xsize;
+    job.ysize    = ysize;
+    job.pitch    = pitch;
+    job.mask     = mask;
+    atomic_init(&job.ret, RETURN_SUCCESS);
+
+    info_pool_reduce(nbtask,
+                     imstats_task,
+                     &job,
+                     job.part,
+                     sizeof(IMSTATS),
+                     imstats_merge);
+    *imstats    = job.part[0];
+    errno_t ret = atomic_load(&job.ret);
+
+    if(ret != RETURN_SUCCESS)
+    {
+        PRINT_ERROR("datatype %d not supported", (int) datatype);
+        return ret;
+    }
+
+    if(imstats->nelement == 0)
+    {
+        imstats->min    = NAN;
+        imstats->max    = NAN;
+        imstats->mean   = NAN;
+        imstats->rmsdev = NAN;
+        imstats->xbary  = NAN;
+        imstats->ybary  = NAN;
+        return RETURN_SUCCESS;
+    }
+
+    double n        = (double) imstats->nelement;
+    double variance = imstats->total2 / n -
+                      (imstats->total / n) * (imstats->total / n);
+
+    imstats->mean   = imstats->total / n;
+    imstats->rmsdev = (variance > 0.0) ? sqrt(variance) : 0.0;
+    if(imstats->total != 0.0)
+    {
+        imstats->xbary /= imstats->total;
+        imstats->ybary /= imstats->total;
+    }
+    else
+    {
+        imstats->xbary = NAN;
+        imstats->ybary = NAN;
+    }
+
+    return RETURN_SUCCESS;
+}
+
+/**
+ * @brief Statistics of raw pixel array
+ *
+ * array is xsize x ysize values of type datatype. Pixels where mask is not
+ * above 0.5 are ignored. mask may be NULL.
+ * Barycenter coordinates are in pixels, ii along xsize, jj along ysize.
+ */
+errno_t imstats_array(const void  *array,
+                      uint8_t      datatype,
+                      uint32_t     xsize,
+                      uint32_t     ysize,
+                      const float *mask,
+                      IMSTATS     *imstats)
+{
+    return imstats_array_pitch(array,
+                               datatype,
+                               xsize,
+                               ysize,
+                               xsize,
+                               mask,
+                               imstats);
+}
+
+/**
+ * @brief Statistics of image
+ *
+ * All elements are used. Barycenter is only meaningful for 2D images.
+ */
+errno_t imstats_compute(IMAGE *image, IMSTATS *imstats)
+{
+    INFO_INSTR_SCOPE("imstats_compute");
+
+    uint32_t xsize = image->md[0].size[0];
+    uint32_t ysize = (uint32_t)(image->md[0].nelement / xsize);
+
+    return imstats_array(image->array.raw,
+                         image->md[0].datatype,
+                         xsize,
+                         ysize,
+                         NULL,
+                         imstats);
+}
+
+/**
+ * @brief Clip sample box to image, number of pixels sampled at most
+ *
+ * A box of xsize 0 is the whole frame. stride 0 is stride 1.
+ */
+uint64_t imstats_sample_maxsize(IMAGE *image, IMSTATS_SAMPLE *sample)
+{
+    uint32_t xsize = image->md[0].size[0];
+    uint32_t ysize = (uint32_t)(image->md[0].nelement / xsize);
+
+    if((sample->xsize == 0) || (sample->ysize == 0))
+    {
+        sample->x0    = 0;
+        sample->y0    = 0;
+        sample->xsize = xsize;
+        sample->ysize = ysize;
+    }
+    sample->x0    = (sample->x0 < xsize) ? sample->x0 : xsize - 1;
+    sample->y0    = (sample->y0 < ysize) ? sample->y0 : ysize - 1;
+    // 64-bit sums : x0 + xsize may not fit in uint32
+    sample->xsize = ((uint64_t) sample->x0 + sample->xsize <= xsize)
+                    ? sample->xsize : xsize - sample->x0;
+    sample->ysize = ((uint64_t) sample->y0 + sample->ysize <= ysize)
+                    ? sample->ysize : ysize - sample->y0;
+    sample->stride = (sample->stride == 0) ? 1 : sample->stride;
+
+    return (((uint64_t) sample->xsize + sample->stride - 1) / sample->stride) *
+           (((uint64_t) sample->ysize + sample->stride - 1) / sample->stride);
+}
+
+/**
+ * @brief Set sample stride so that at most nbpix pixels of the box are read
+ */
+void imstats_sample_budget(IMAGE          *image,
+                           IMSTATS_SAMPLE *sample,
+                           uint64_t        nbpix)
+{
+    sample->stride = 1;
+    imstats_sample_maxsize(image, sample);
+    if(nbpix == 0)
+    {
+        return;
+    }
+
+    double boxpix = (double) sample->xsize * sample->ysize;
+    sample->stride = (uint32_t) ceil(sqrt(boxpix / nbpix));
+    while(imstats_sample_maxsize(image, sample) > nbpix)
+    {
+        sample->stride++;
+    }
+}
+
+/**
+ * @brief Statistics of a stride 1 sample, read in place
+ *
+ * Box and mask are read directly in the frame, with the threads of the
+ * worker pool : no copy. Positions of min, max and barycenter are in frame
+ * coordinates. sample must have been clipped by imstats_sample_maxsize().
+ */
+errno_t imstats_sample_compute(IMAGE                *image,
+                               const IMSTATS_SAMPLE *sample,
+                               IMSTATS              *imstats)
+{
+    INFO_INSTR_SCOPE("imstats_sample_compute");
+
+    uint64_t    pitch    = image->md[0].size[0];
+    uint64_t    offset   = (uint64_t) sample->y0 * pitch + sample->x0;
+    size_t      typesize = ImageStreamIO_typesize(image->md[0].datatype);
+    const char *array    = (const char *) image->array.raw + offset * typesize;
+
+    if(sample->stride != 1)
+    {
+        PRINT_ERROR("stride %u : sample must be gathered", sample->stride);
+        return RETURN_FAILURE;
+    }
+
+    if(imstats_array_pitch(array,
+                           image->md[0].datatype,
+                           sample->xsize,
+                           sample->ysize,
+                           pitch,
+                           (sample->mask == NULL) ? NULL
+                           : sample->mask + offset,
+                           imstats) != RETURN_SUCCESS)
+    {
+        return RETURN_FAILURE;
+    }
+
+    if(imstats->nelement > 0)
+    {
+        imstats->iimin += offset;
+        imstats->iimax += offset;
+        imstats->xbary += sample->x0;
+        imstats->ybary += sample->y0;
+    }
+
+    return RETURN_SUCCESS;
+}
+
+#define IMSTATS_SAMPLE_GATHER(arrayptr)                                        \
+    do                                                                         \
+    {                                                                          \
+        for(uint32_t jj = sample->y0; jj < jjend; jj += stride)                \
+        {                                                                      \
+            uint64_t offset = (uint64_t) jj * xsize;                           \
+            for(uint32_t ii = sample->x0; ii < iiend; ii += stride)            \
+            {                                                                  \
+                if((mask == NULL) || (mask[offset + ii] > 0.5))                \
+                {                                                              \
+                    buf[nbpix++] = (double) (arrayptr)[offset + ii];           \
+                }                                                              \
+            }                                                                  \
+        }                                                                      \
+    } while(0)
+
+/**
+ * @brief Copy sampled pixel values of image into buf, returns their number
+ *
+ * sample must have been clipped by imstats_sample_maxsize(), which gives
+ * the size of buf. The sample is small by construction : one serial pass,
+ * reading only sampled pixels.
+ */
+uint64_t imstats_sample_gather(IMAGE                *image,
+                               const IMSTATS_SAMPLE *sample,
+                               double               *buf)
+{
+    INFO_INSTR_SCOPE("imstats_sample_gather");
+
+    uint64_t     xsize  = image->md[0].size[0];
+    uint32_t     stride = sample->stride;
+    uint32_t     iiend  = sample->x0 + sample->xsize;
+    uint32_t     jjend  = sample->y0 + sample->ysize;
+    const float *mask   = sample->mask;
+    uint64_t     nbpix  = 0;
+
+    switch(image->md[0].datatype)
+    {
+        case _DATATYPE_FLOAT:
+            IMSTATS_SAMPLE_GATHER(image->array.F);
+            break;
+        case _DATATYPE_DOUBLE:
+            IMSTATS_SAMPLE_GATHER(image->array.D);
+            break;
+        case _DATATYPE_UINT8:
+            IMSTATS_SAMPLE_GATHER(image->array.UI8);
+            break;
+        case _DATATYPE_INT8:
+            IMSTATS_SAMPLE_GATHER(image->array.SI8);
+            break;
+        case _DATATYPE_UINT16:
+            IMSTATS_SAMPLE_GATHER(image->array.UI16);
+            break;
+        case _DATATYPE_INT16:
+            IMSTATS_SAMPLE_GATHER(image->array.SI16);
+            break;
+        case _DATATYPE_UINT32:
+            IMSTATS_SAMPLE_GATHER(image->array.UI32);
+            break;
+        case _DATATYPE_INT32:
+            IMSTATS_SAMPLE_GATHER(image->array.SI32);
+            break;
+        case _DATATYPE_UINT64:
+            IMSTATS_SAMPLE_GATHER(image->array.UI64);
+            break;
+        case _DATATYPE_INT64:
+            IMSTATS_SAMPLE_GATHER(image->array.SI64);
+            break;
+    }
+
+    return nbpix;
+}
+
+/**
+ * @brief Standard error of the mean of imstats, sampled out of nbtotal
+ *
+ * Finite population correction included : 0 when all values are used.
+ * Exact for random sampling, an estimate for regular strides, which miss
+ * structure at the stride period.
+ */
+double imstats_sample_meanerr(const IMSTATS *imstats, uint64_t nbtotal)
+{
+    double n = (double) imstats->nelement;
+
+    if((imstats->nelement == 0) || (nbtotal <= imstats->nelement))
+    {
+        return 0.0;
+    }
+    return imstats->rmsdev / sqrt(n) * sqrt(1.0 - n / nbtotal);
+}
+
+/**
+ * @brief Reorders a[lo..hi] so that a[k] is in sorted position
+ */
+static void percentile_select(double *a, int64_t lo, int64_t hi, int64_t k)
+{
+    while(hi > lo)
+    {
+        int64_t mid = lo + (hi - lo) / 2;
+        double  tmp;
+
+        // median of 3 pivot, also sentinels for the partition loops
+        if(a[mid] < a[lo])
+        {
+            tmp    = a[mid];
+            a[mid] = a[lo];
+            a[lo]  = tmp;
+        }
+        if(a[hi] < a[lo])
+        {
+            tmp   = a[hi];
+            a[hi] = a[lo];
+            a[lo] = tmp;
+        }
+        if(a[hi] < a[mid])
+        {
+            tmp    = a[hi];
+            a[hi]  = a[mid];
+            a[mid] = tmp;
+        }
+        double pivot = a[mid];
+
+        int64_t i = lo;
+        int64_t j = hi;
+        while(i <= j)
+        {
+            while(a[i] < pivot)
+            {
+                i++;
+            }
+            while(a[j] > pivot)
+            {
+                j--;
+            }
+            if(i <= j)
+            {
+                tmp  = a[i];
+                a[i] = a[j];
+                a[j] = tmp;
+                i++;
+                j--;
+            }
+        }
+
+        if(k <= j)
+        {
+            hi = j;
+        }
+        else if(k >= i)
+        {
+            lo = i;
+        }
+        else
+        {
+            return;
+        }
+    }
+}
+
+#define PERCENTILE_COPY(arrayptr, checknan)                                    \
+    do                                                                         \
+    {                                                                          \
+        for(uint64_t ii = 0; ii < nelement; ii++)                              \
+        {                                                                      \
+            double v = (double) (arrayptr)[ii];                                \
+            if(!(checknan) || !isnan(v))                                       \
+            {                                                                  \
+                a[n++] = v;                                                    \
+            }                                                                  \
+        }                                                                      \
+    } while(0)
+
+/**
+ * @brief Percentiles of raw array
+ *
+ * Percentile p is the value at position (long) (p * n) of the sorted
+ * values, n excluding NaN. percarray need not be sorted.
+ * valarray receives NaN if all values are NaN.
+ */
+errno_t percentile_array(const void   *array,
+                         uint8_t       datatype,
+                         uint64_t      nelement,
+                         long          nbperc,
+                         const double *percarray,
+                         double       *valarray)
+{
+    size_t  scratchmark = info_scratch_mark();
+    double *a = (double *) info_scratch_alloc(sizeof(double) * (nelement + 1));
+    long   *order = (long *) info_scratch_alloc(sizeof(long) * (nbperc + 1));
+
+    uint64_t n = 0;
+    switch(datatype)
+    {
+        case _DATATYPE_FLOAT:
+            PERCENTILE_COPY((const float *) array, 1);
+            break;
+        case _DATATYPE_DOUBLE:
+            PERCENTILE_COPY((const double *) array, 1);
+            break;
+        case _DATATYPE_UINT8:
+            PERCENTILE_COPY((const uint8_t *) array, 0);
+            break;
+        case _DATATYPE_INT8:
+            PERCENTILE_COPY((const int8_t *) array, 0);
+            break;
+        case _DATATYPE_UINT16:
+            PERCENTILE_COPY((const uint16_t *) array, 0);
+            break;
+        case _DATATYPE_INT16:
+            PERCENTILE_COPY((const int16_t *) array, 0);
+            break;
+        case _DATATYPE_UINT32:
+            PERCENTILE_COPY((const uint32_t *) array, 0);
+            break;
+        case _DATATYPE_INT32:
+            PERCENTILE_COPY((const int32_t *) array, 0);
+            break;
+        case _DATATYPE_UINT64:
+            PERCENTILE_COPY((const uint64_t *) array, 0);
+            break;
+        case _DATATYPE_INT64:
+            PERCENTILE_COPY((const int64_t *) array, 0);
+            break;
+        default:
+            PRINT_ERROR("datatype %d not supported", (int) datatype);
+            info_scratch_release(scratchmark);
+            return RETURN_FAILURE;
+    }
+
+    // process percentiles in increasing order
+    for(long i = 0; i < nbperc; i++)
+    {
+        long j = i;
+        while((j > 0) && (percarray[order[j - 1]] > percarray[i]))
+        {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    int64_t lo = 0;
+    for(long i = 0; i < nbperc; i++)
+    {
+        long pi = order[i];
+        if(n == 0)
+        {
+            valarray[pi] = NAN;
+            continue;
+        }
+
+        int64_t k = 0;
+        if(percarray[pi] > 0.0)
+        {
+            k = (int64_t)(percarray[pi] * n);
+        }
+        if(k > (int64_t) n - 1)
+        {
+            k = (int64_t) n - 1;
+        }
+
+        percentile_select(a, lo, (int64_t) n - 1, k);
+        valarray[pi] = a[k];
+        lo           = k;
+    }
+
+    info_scratch_release(scratchmark);
+
+    return RETURN_SUCCESS;
+}
+
+/**
+ * @brief Percentiles of image, all elements
+ */
+errno_t image_percentiles(IMAGE        *image,
+                          long          nbperc,
+                          const double *percarray,
+                          double       *valarray)
+{
+    INFO_INSTR_SCOPE("image_percentiles");
+
+    return percentile_array(image->array.raw,
+                            image->md[0].datatype,
+                            image->md[0].nelement,
+                            nbperc,
+                            percarray,
+                            valarray);
+}
+
+// one task per slice, or per slice pair, each reading nbpix pixels
+// serial if the whole cube is below the multi-thread threshold
+static void cube_slices_run(long           nbtask,
+                            uint64_t       nbpix,
+                            INFO_POOL_TASK func,
+                            void          *arg)
+{
+    if(nbpix * nbtask > IMSTATS_NBPIX_THREAD)
+    {
+        info_pool_run((int) nbtask, func, arg);
+    }
+    else
+    {
+        for(long task = 0; task < nbtask; task++)
+        {
+            func(arg, (int) task, (int) nbtask);
+        }
+    }
+}
+
+typedef struct
+{
+    IMAGE       *image;
+    const float *mask;
+    IMSTATS     *slicestats;
+    atomic_int   ret;
+} CUBE_SLICE_STATS_JOB;
+
+// task kk : slice kk
+static void cube_slice_stats_task(void *arg, int kk, int nbtask)
+{
+    CUBE_SLICE_STATS_JOB *job   = (CUBE_SLICE_STATS_JOB *) arg;
+    IMAGE                *image = job->image;
+    uint64_t              xysize =
+        (uint64_t) image->md[0].size[0] * image->md[0].size[1];
+    size_t      typesize = ImageStreamIO_typesize(image->md[0].datatype);
+    const char *slice    = (const char *) image->array.raw +
+                           (size_t) kk * xysize * typesize;
+
+    (void) nbtask;
+
+    if(imstats_array(slice,
+                     image->md[0].datatype,
+                     image->md[0].size[0],
+                     image->md[0].size[1],
+                     job->mask,
+                     &job->slicestats[kk]) != RETURN_SUCCESS)
+    {
+        atomic_store(&job->ret, RETURN_FAILURE);
+    }
+}
+
+/**
+ * @brief Statistics of each slice of 3D image
+ *
+ * slicestats is an array of size[2] elements. maskimage, float, size[0] x
+ * size[1], may be NULL.
+ */
+errno_t cube_slice_stats(IMAGE *image, IMAGE *maskimage, IMSTATS *slicestats)
+{
+    INFO_INSTR_SCOPE("cube_slice_stats");
+
+    uint32_t             zsize  = image->md[0].size[2];
+    uint64_t             xysize =
+        (uint64_t) image->md[0].size[0] * image->md[0].size[1];
+    CUBE_SLICE_STATS_JOB job;
+
+    job.image      = image;
+    job.mask       = (maskimage == NULL) ? NULL : maskimage->array.F;
+    job.slicestats = slicestats;
+    atomic_init(&job.ret, RETURN_SUCCESS);
+
+    if(xysize <= IMSTATS_NBPIX_THREAD)
+    {
+        // small slices : one task per slice
+        cube_slices_run(zsize, xysize, cube_slice_stats_task, &job);
+    }
+    else
+    {
+        // each slice is split between threads
+        for(uint32_t kk = 0; kk < zsize; kk++)
+        {
+            cube_slice_stats_task(&job, (int) kk, (int) zsize);
+        }
+    }
+
+    return atomic_load(&job.ret);
+}
+
+#define CUBE_SLICE_DOT(arrayptr)                                               \
+    do                                                                         \
+    {                                                                          \
+        const __typeof__((arrayptr)[0]) *s1 = (arrayptr) + k1 * xysize;       \
+        const __typeof__((arrayptr)[0]) *s2 = (arrayptr) + k2 * xysize;       \
+        if(mask == NULL)                                                       \
+        {                                                                      \
+            _Pragma("omp simd reduction(+:dot)")                               \
+            for(uint64_t ii = 0; ii < xysize; ii++)                            \
+            {                                                                  \
+                dot += (double) s1[ii] * (double) s2[ii];                      \
+            }                                                                  \
+        }                                                                      \
+        else                                                                   \
+        {                                                                      \
+            _Pragma("omp simd reduction(+:dot)")                               \
+            for(uint64_t ii = 0; ii < xysize; ii++)                            \
+            {                                                                  \
+                double v = (double) s1[ii] * (double) s2[ii];                  \
+                dot += (mask[ii] > 0.5) ? v : 0.0;                             \
+            }                                                                  \
+        }                                                                      \
+    } while(0)
+
+INFO_SIMD_CLONES
+static double cube_slice_dot(IMAGE *image, const float *mask, long k1, long k2)
+{
+    uint64_t xysize = (uint64_t) image->md[0].size[0] * image->md[0].size[1];
+    double   dot    = 0.0;
+
+    switch(image->md[0].datatype)
+    {
+        case _DATATYPE_FLOAT:
+            CUBE_SLICE_DOT(image->array.F);
+            break;
+        case _DATATYPE_DOUBLE:
+            CUBE_SLICE_DOT(image->array.D);
+            break;
+        case _DATATYPE_UINT8:
+            CUBE_SLICE_DOT(image->array.UI8);
+            break;
+        case _DATATYPE_INT8:
+            CUBE_SLICE_DOT(image->array.SI8);
+            break;
+        case _DATATYPE_UINT16:
+            CUBE_SLICE_DOT(image->array.UI16);
+            break;
+        case _DATATYPE_INT16:
+            CUBE_SLICE_DOT(image->array.SI16);
+            break;
+        case _DATATYPE_UINT32:
+            CUBE_SLICE_DOT(image->array.UI32);
+            break;
+        case _DATATYPE_INT32:
+            CUBE_SLICE_DOT(image->array.SI32);
+            break;
+        case _DATATYPE_UINT64:
+            CUBE_SLICE_DOT(image->array.UI64);
+            break;
+        case _DATATYPE_INT64:
+            CUBE_SLICE_DOT(image->array.SI64);
+            break;
+    }
+
+    return dot;
+}
+
+typedef struct
+{
+    IMAGE       *image;
+    const float *mask;
+    long         kc;
+    double      *norm;
+    double      *vcorr; // correlation of slices kk and kk + kc
+} CUBE_SLICE_CORR_JOB;
+
+// task kk : norm of slice kk
+static void cube_slice_norm_task(void *arg, int kk, int nbtask)
+{
+    CUBE_SLICE_CORR_JOB *job = (CUBE_SLICE_CORR_JOB *) arg;
+
+    (void) nbtask;
+    job->norm[kk] = cube_slice_dot(job->image, job->mask, kk, kk);
+}
+
+// task kk : normalized correlation of slices kk and kk + kc
+static void cube_slice_corr_task(void *arg, int kk, int nbtask)
+{
+    CUBE_SLICE_CORR_JOB *job = (CUBE_SLICE_CORR_JOB *) arg;
+    long                 kc  = job->kc;
+
+    (void) nbtask;
+    job->vcorr[kk] = cube_slice_dot(job->image, job->mask, kk, kk + kc) /
+                     sqrt(job->norm[kk] * job->norm[kk + kc]);
+}
+
+/**
+ * @brief Average normalized correlation between slices k and k + kc
+ *
+ * corrarray[kc] for kc = 0 to kcmax - 1. Entries for kc >= size[2] are NaN.
+ * Slice norms are computed once, then one dot product per slice pair.
+ */
+errno_t cube_slice_corr(IMAGE  *image,
+                        IMAGE  *maskimage,
+                        long    kcmax,
+                        double *corrarray)
+{
+    INFO_INSTR_SCOPE("cube_slice_corr");
+
+    long                zsize  = image->md[0].size[2];
+    uint64_t            xysize =
+        (uint64_t) image->md[0].size[0] * image->md[0].size[1];
+    CUBE_SLICE_CORR_JOB job;
+
+    job.image = image;
+    job.mask  = (maskimage == NULL) ? NULL : maskimage->array.F;
+    size_t scratchmark = info_scratch_mark();
+    job.norm  = (double *) info_scratch_alloc(sizeof(double) * 2 * zsize);
+    job.vcorr = job.norm + zsize;
+
+    cube_slices_run(zsize, xysize, cube_slice_norm_task, &job);
+
+    for(long kc = 0; kc < kcmax; kc++)
+    {
+        if(kc >= zsize)
+        {
+            corrarray[kc] = NAN;
+            continue;
+        }
+
+        job.kc = kc;
+        cube_slices_run(zsize - kc, xysize, cube_slice_corr_task, &job);
+
+        double vcorr = 0.0;
+        for(long kk = 0; kk < zsize - kc; kk++)
+        {
+            vcorr += job.vcorr[kk];
+        }
+        corrarray[kc] = vcorr / (zsize - kc);
+    }
+
+    info_scratch_release(scratchmark);
+
+    return RETURN_SUCCESS;
+}
+
+#define CUBE_SLICE_SQDIFF(arrayptr)                                            \
+    do                                                                         \
+    {                                                                          \
+        const __typeof__((arrayptr)[0]) *s1 = (arrayptr) + k1 * xysize;       \
+        const __typeof__((arrayptr)[0]) *s2 = (arrayptr) + k2 * xysize;       \
+        _Pragma("omp simd reduction(+:sqdiff)")                                \
+        for(uint64_t ii = 0; ii < xysize; ii++)                                \
+        {                                                                      \
+            double v = (double) s1[ii] - (double) s2[ii];                      \
+            sqdiff += v * v;                                                   \
+        }                                                                      \
+    } while(0)
+
+INFO_SIMD_CLONES
+static double cube_slice_sqdiff(IMAGE *image, long k1, long k2)
+{
+    uint64_t xysize = (uint64_t) image->md[0].size[0] * image->md[0].size[1];
+    double   sqdiff = 0.0;
+
+    switch(image->md[0].datatype)
+    {
+        case _DATATYPE_FLOAT:
+            CUBE_SLICE_SQDIFF(image->array.F);
+            break;
+        case _DATATYPE_DOUBLE:
+            CUBE_SLICE_SQDIFF(image->array.D);
+            break;
+        case _DATATYPE_UINT8:
+            CUBE_SLICE_SQDIFF(image->array.UI8);
+            break;
+        case _DATATYPE_INT8:
+            CUBE_SLICE_SQDIFF(image->array.SI8);
+            break;
+        case _DATATYPE_UINT16:
+            CUBE_SLICE_SQDIFF(image->array.UI16);
+            break;
+        case _DATATYPE_INT16:
+            CUBE_SLICE_SQDIFF(image->array.SI16);
+            break;
+        case _DATATYPE_UINT32:
+            CUBE_SLICE_SQDIFF(image->array.UI32);
+            break;
+        case _DATATYPE_INT32:
+            CUBE_SLICE_SQDIFF(image->array.SI32);
+            break;
+        case _DATATYPE_UINT64:
+            CUBE_SLICE_SQDIFF(image->array.UI64);
+            break;
+        case _DATATYPE_INT64:
+            CUBE_SLICE_SQDIFF(image->array.SI64);
+            break;
+    }
+
+    return sqdiff;
+}
+
+typedef struct
+{
+    IMAGE *image;
+    float *matcharray;
+} CUBE_SLICE_MATCH_JOB;
+
+// task kk1 : pairs (kk1, kk2 > kk1)
+static void cube_slice_match_task(void *arg, int kk1, int zsize)
+{
+    CUBE_SLICE_MATCH_JOB *job = (CUBE_SLICE_MATCH_JOB *) arg;
+
+    for(long kk2 = kk1 + 1; kk2 < zsize; kk2++)
+    {
+        job->matcharray[kk2 * zsize + kk1] =
+            (float) cube_slice_sqdiff(job->image, kk1, kk2);
+    }
+}
+
+/**
+ * @brief Sum of squared differences between all slice pairs
+ *
+ * matcharray is size[2] x size[2]. Element [k2 * size[2] + k1], k2 > k1,
+ * receives the sum over pixels of (slice k1 - slice k2)^2. Other elements
+ * are set to 0.
+ */
+errno_t cube_slice_matchmatrix(IMAGE *image, float *matcharray)
+{
+    INFO_INSTR_SCOPE("cube_slice_matchmatrix");
+
+    long                 zsize  = image->md[0].size[2];
+    uint64_t             xysize =
+        (uint64_t) image->md[0].size[0] * image->md[0].size[1];
+    CUBE_SLICE_MATCH_JOB job = {image, matcharray};
+
+    memset(matcharray, 0, sizeof(float) * zsize * zsize);
+
+    cube_slices_run(zsize,
+                    xysize * (zsize - 1) / 2,
+                    cube_slice_match_task,
+                    &job);
+
+    return RETURN_SUCCESS;
+}
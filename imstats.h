@@ -0,0 +1,83 @@
+/**
+ * @file    imstats.h
+ */
+
+#ifndef _INFO_IMSTATS_H
+#define _INFO_IMSTATS_H
+
+// Pixel value statistics
+// NaN values are counted in nbnan and otherwise ignored
+typedef struct
+{
+    uint64_t nelement; // number of values used, NaN excluded
+    uint64_t nbnan;
+    double   min;
+    double   max;
+    uint64_t iimin; // index of first minimum
+    uint64_t iimax; // index of first maximum
+    double   total;
+    double   total2; // sum of squares
+    double   mean;
+    double   rmsdev; // standard deviation around mean
+    double   xbary;  // barycenter, NaN if total is 0
+    double   ybary;
+} IMSTATS;
+
+// pixel subset of a frame : box, mask and stride
+typedef struct
+{
+    uint32_t     x0; // box, xsize 0 for whole frame
+    uint32_t     y0;
+    uint32_t     xsize;
+    uint32_t     ysize;
+    const float *mask;   // frame size, pixels above 0.5 kept, may be NULL
+    uint32_t     stride; // step along both axes of box
+} IMSTATS_SAMPLE;
+
+errno_t imstats_array(const void *array,
+                      uint8_t     datatype,
+                      uint32_t    xsize,
+                      uint32_t    ysize,
+                      const float *mask,
+                      IMSTATS    *imstats);
+
+errno_t imstats_compute(IMAGE *image, IMSTATS *imstats);
+
+uint64_t imstats_sample_maxsize(IMAGE *image, IMSTATS_SAMPLE *sample);
+
+void imstats_sample_budget(IMAGE          *image,
+                           IMSTATS_SAMPLE *sample,
+                           uint64_t        nbpix);
+
+errno_t imstats_sample_compute(IMAGE                *image,
+                               const IMSTATS_SAMPLE *sample,
+                               IMSTATS              *imstats);
+
+uint64_t imstats_sample_gather(IMAGE                *image,
+                               const IMSTATS_SAMPLE *sample,
+                               double               *buf);
+
+double imstats_sample_meanerr(const IMSTATS *imstats, uint64_t nbtotal);
+
+errno_t percentile_array(const void   *array,
+                         uint8_t       datatype,
+                         uint64_t      nelement,
+                         long          nbperc,
+                         const double *percarray,
+                         double       *valarray);
+
+errno_t image_percentiles(IMAGE        *image,
+                          long          nbperc,
+                          const double *percarray,
+                          double       *valarray);
+
+errno_t cube_slice_stats(IMAGE *image, IMAGE *maskimage, IMSTATS *slicestats);
+
+errno_t cube_slice_corr(IMAGE  *image,
+                        IMAGE  *maskimage,
+                        long    kcmax,
+                        double *corrarray);
+
+errno_t cube_slice_matchmatrix(IMAGE *image, float *matcharray);
+
+#endif
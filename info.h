@@ -5,40 +5,29 @@
 
 void __attribute__((constructor)) libinit_info();
 
+#include "info/brightpix.h"
 #include "info/cubeMatchMatrix.h"
 #include "info/cubestats.h"
+#include "info/histogram.h"
+#include "info/histogram_stream.h"
 #include "info/image_stats.h"
 #include "info/imagemon.h"
+#include "info/imbackground.h"
+#include "info/imcenter.h"
+#include "info/impolar.h"
 #include "info/improfile.h"
+#include "info/improfile_binmap.h"
+#include "info/improfile_stream.h"
+#include "info/imstats.h"
 #include "info/kbdhit.h"
 #include "info/percentile.h"
 #include "info/print_header.h"
-
-/*
-long brighter(
-    const char *ID_name,
-    double      value
-);
-*/
-
-/*
-errno_t img_nbpix_flux(
-    const char *ID_name
-);
-*/
+#include "info/printpix.h"
+#include "info/profile2im_stream.h"
+#include "info/structfunc.h"
 
 // int img_histoc(const char *ID_name, const char *fname);
 
-/*
-errno_t make_histogram(
-    const char *ID_name,
-    const char *ID_out_name,
-    double      min,
-    double      max,
-    long        nbsteps
-);
-*/
-
 // double ssquare(const char *ID_name);
 
 // double rms_dev(const char *ID_name);
@@ -49,30 +38,6 @@ double img_min(const char *ID_name);
 double img_max(const char *ID_name);
 */
 
-/*
-errno_t printpix(
-    const char *ID_name,
-    const char *filename
-);
-*/
-
-/*
-double background_photon_noise(
-    const char *ID_name
-);
-*/
-
-/*
-int test_structure_function(const char *ID_name, long NBpoints,
-                            const char *fname);
-
-imageID full_structure_function(
-    const char *ID_name,
-    long        NBpoints,
-    const char *ID_out
-);
-*/
-
 imageID info_cubeMatchMatrix(const char *IDin_name, const char *IDout_name);
 
 #endif
@@ -0,0 +1,45 @@
+/**
+ * @file    info_core.h
+ * @brief   definitions for CLIcore-independent kernels
+ *
+ * Kernel sources built into the milkinfocore library include this header
+ * instead of CLIcore.h. They only depend on ImageStreamIO and the C library,
+ * and operate on IMAGE pointers or raw buffers : no image name lookup, no
+ * access to the global data table.
+ *
+ * Processes that do not run the milk CLI include this header before the
+ * kernel headers, and link against milkinfocore.
+ */
+
+#ifndef _INFO_CORE_H
+#define _INFO_CORE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ImageStreamIO/ImageStreamIO.h"
+
+#ifndef RETURN_SUCCESS
+#define RETURN_SUCCESS 0
+#endif
+
+#ifndef RETURN_FAILURE
+#define RETURN_FAILURE 1
+#endif
+
+#ifndef PRINT_ERROR
+#define PRINT_ERROR(...)                                                       \
+    do                                                                         \
+    {                                                                          \
+        fprintf(stderr,                                                        \
+                "ERROR %s %s line %d: ",                                       \
+                __FILE__,                                                      \
+                __func__,                                                      \
+                __LINE__);                                                     \
+        fprintf(stderr, __VA_ARGS__);                                          \
+        fprintf(stderr, "\n");                                                 \
+    } while(0)
+#endif
+
+#endif
@@ -0,0 +1,337 @@
+/**
+ * @file    info_instr.c
+ * @brief   phase timers with duration histograms, in a shared memory block
+ *
+ * Kernels and monitor loops time their phases with INFO_INSTR_SCOPE(name).
+ * Each phase accumulates a count, total and maximum duration, and a
+ * histogram of durations with power-of-two bins, in a block that other
+ * processes may map read-only (see info_instr_open()).
+ *
+ * Timers cost one clock_gettime() call (vDSO, no system call) at each end
+ * when instrumentation is on, and one pointer test when it is off.
+ * Instrumentation is off until info_instr_init() creates the block.
+ *
+ * Phases may nest : a monitor screen update phase includes the time of the
+ * kernels it calls. Counters are updated with relaxed atomic operations, so
+ * a reader may see fields of a phase updated at slightly different times.
+ */
+
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "info_core.h"
+
+#include "info_instr.h"
+
+INFO_INSTR_BLOCK *info_instr_block = NULL;
+
+// phase names, kept when the block is replaced so that indices stay valid
+static pthread_mutex_t instr_lock = PTHREAD_MUTEX_INITIALIZER;
+static char            instr_name[INFO_INSTR_NBPHASE][INFO_INSTR_NAMESIZE];
+static int             instr_nbphase = 0;
+
+/**
+ * @brief Create shared memory block fname and start timing
+ *
+ * Counters start at zero. Replaces the current block, if any : the old
+ * block stays mapped, as timers started before the call may still write to
+ * it. fname NULL stops timing.
+ */
+errno_t info_instr_init(const char *fname)
+{
+    INFO_INSTR_BLOCK *block = NULL;
+
+    if(fname != NULL)
+    {
+        int fd = open(fname, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if(fd == -1)
+        {
+            PRINT_ERROR("cannot create file %s", fname);
+            return RETURN_FAILURE;
+        }
+        if(ftruncate(fd, sizeof(INFO_INSTR_BLOCK)) == -1)
+        {
+            PRINT_ERROR("ftruncate %s failed", fname);
+            close(fd);
+            return RETURN_FAILURE;
+        }
+        block = (INFO_INSTR_BLOCK *) mmap(NULL,
+                                          sizeof(INFO_INSTR_BLOCK),
+                                          PROT_READ | PROT_WRITE,
+                                          MAP_SHARED,
+                                          fd,
+                                          0);
+        close(fd);
+        if(block == MAP_FAILED)
+        {
+            PRINT_ERROR("mmap %s failed", fname);
+            return RETURN_FAILURE;
+        }
+
+        struct timespec t;
+        clock_gettime(CLOCK_REALTIME, &t);
+
+        block->version = INFO_INSTR_VERSION;
+        block->pid     = (int32_t) getpid();
+        block->tstart  = (int64_t) t.tv_sec * 1000000000 + t.tv_nsec;
+    }
+
+    pthread_mutex_lock(&instr_lock);
+    if(block != NULL)
+    {
+        for(int phase = 0; phase < instr_nbphase; phase++)
+        {
+            memcpy(block->phase[phase].name,
+                   instr_name[phase],
+                   INFO_INSTR_NAMESIZE);
+        }
+        block->nbphase = instr_nbphase;
+        // magic written last : readers ignore a block being set up
+        __atomic_store_n(&block->magic, INFO_INSTR_MAGIC, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&info_instr_block, block, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&instr_lock);
+
+    return RETURN_SUCCESS;
+}
+
+/**
+ * @brief Index of phase name, added if not registered yet
+ *
+ * Returns -1 if the phase table is full.
+ */
+int info_instr_register(const char *name)
+{
+    int phase;
+
+    pthread_mutex_lock(&instr_lock);
+    for(phase = 0; phase < instr_nbphase; phase++)
+    {
+        if(strncmp(instr_name[phase], name, INFO_INSTR_NAMESIZE - 1) == 0)
+        {
+            break;
+        }
+    }
+    if(phase == instr_nbphase)
+    {
+        if(instr_nbphase == INFO_INSTR_NBPHASE)
+        {
+            phase = -1;
+        }
+        else
+        {
+            strncpy(instr_name[phase], name, INFO_INSTR_NAMESIZE - 1);
+            instr_nbphase++;
+            if(info_instr_block != NULL)
+            {
+                memcpy(info_instr_block->phase[phase].name,
+                       instr_name[phase],
+                       INFO_INSTR_NAMESIZE);
+                __atomic_store_n(&info_instr_block->nbphase,
+                                 instr_nbphase,
+                                 __ATOMIC_RELEASE);
+            }
+        }
+    }
+    pthread_mutex_unlock(&instr_lock);
+
+    return phase;
+}
+
+/**
+ * @brief Add duration ns to phase
+ */
+void info_instr_record(int phase, uint64_t ns)
+{
+    INFO_INSTR_BLOCK *block =
+        __atomic_load_n(&info_instr_block, __ATOMIC_ACQUIRE);
+
+    if((block == NULL) || (phase < 0))
+    {
+        return;
+    }
+
+    INFO_INSTR_PHASE *ph  = &block->phase[phase];
+    int               bin = 63 - __builtin_clzll(ns | 1);
+    if(bin > INFO_INSTR_NBBIN - 1)
+    {
+        bin = INFO_INSTR_NBBIN - 1;
+    }
+
+    __atomic_fetch_add(&ph->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&ph->totalns, ns, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&ph->hist[bin], 1, __ATOMIC_RELAXED);
+
+    uint64_t maxns = __atomic_load_n(&ph->maxns, __ATOMIC_RELAXED);
+    while((ns > maxns) &&
+            !__atomic_compare_exchange_n(&ph->maxns,
+                                         &maxns,
+                                         ns,
+                                         1,
+                                         __ATOMIC_RELAXED,
+                                         __ATOMIC_RELAXED))
+        ;
+}
+
+/**
+ * @brief Count and total duration of phase name in current block
+ *
+ * Returns RETURN_FAILURE if timing is off or the phase is unknown.
+ */
+errno_t info_instr_phase_get(const char *name,
+                             uint64_t   *count,
+                             uint64_t   *totalns)
+{
+    errno_t ret = RETURN_FAILURE;
+
+    pthread_mutex_lock(&instr_lock);
+    if(info_instr_block != NULL)
+    {
+        for(int phase = 0; phase < instr_nbphase; phase++)
+        {
+            if(strncmp(instr_name[phase], name, INFO_INSTR_NAMESIZE - 1) == 0)
+            {
+                INFO_INSTR_PHASE *ph = &info_instr_block->phase[phase];
+
+                *count   = __atomic_load_n(&ph->count, __ATOMIC_RELAXED);
+                *totalns = __atomic_load_n(&ph->totalns, __ATOMIC_RELAXED);
+                ret      = RETURN_SUCCESS;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&instr_lock);
+
+    return ret;
+}
+
+/**
+ * @brief End of INFO_INSTR_SCOPE, called when the timer goes out of scope
+ */
+void info_instr_timer_end(INFO_INSTR_TIMER *timer)
+{
+    if(timer->t0 == 0)
+    {
+        return;
+    }
+
+    uint64_t ns = info_instr_now() - timer->t0;
+
+    if(*timer->phase == -1)
+    {
+        *timer->phase = info_instr_register(timer->name);
+    }
+    info_instr_record(*timer->phase, ns);
+}
+
+/**
+ * @brief Map block fname read-only, for example of another process
+ *
+ * Returns NULL if the file is missing or is not an instrumentation block.
+ */
+INFO_INSTR_BLOCK *info_instr_open(const char *fname)
+{
+    INFO_INSTR_BLOCK *block;
+    int               fd = open(fname, O_RDONLY);
+
+    if(fd == -1)
+    {
+        return NULL;
+    }
+    if(lseek(fd, 0, SEEK_END) < (off_t) sizeof(INFO_INSTR_BLOCK))
+    {
+        close(fd);
+        return NULL;
+    }
+    block = (INFO_INSTR_BLOCK *) mmap(NULL,
+                                      sizeof(INFO_INSTR_BLOCK),
+                                      PROT_READ,
+                                      MAP_SHARED,
+                                      fd,
+                                      0);
+    close(fd);
+    if(block == MAP_FAILED)
+    {
+        return NULL;
+    }
+    if((__atomic_load_n(&block->magic, __ATOMIC_ACQUIRE) != INFO_INSTR_MAGIC) ||
+            (block->version != INFO_INSTR_VERSION))
+    {
+        munmap(block, sizeof(INFO_INSTR_BLOCK));
+        return NULL;
+    }
+
+    return block;
+}
+
+void info_instr_close(INFO_INSTR_BLOCK *block)
+{
+    munmap(block, sizeof(INFO_INSTR_BLOCK));
+}
+
+// upper edge of histogram bin holding fraction p of counts [us]
+static double instr_hist_percentile(const INFO_INSTR_PHASE *ph,
+                                    uint64_t                count,
+                                    double                  p)
+{
+    uint64_t k   = (uint64_t)(p * count);
+    uint64_t cum = 0;
+
+    for(int bin = 0; bin < INFO_INSTR_NBBIN; bin++)
+    {
+        cum += ph->hist[bin];
+        if(cum > k)
+        {
+            return ldexp(1.0, bin + 1) * 1.0e-3;
+        }
+    }
+
+    return ldexp(1.0, INFO_INSTR_NBBIN) * 1.0e-3;
+}
+
+/**
+ * @brief Print phase table
+ *
+ * Percentiles are upper edges of histogram bins, within a factor 2.
+ */
+void info_instr_print(const INFO_INSTR_BLOCK *block, FILE *fp)
+{
+    uint32_t nbphase = __atomic_load_n(&block->nbphase, __ATOMIC_ACQUIRE);
+
+    fprintf(fp, "# pid %d\n", (int) block->pid);
+    fprintf(fp,
+            "# %-30s %10s %12s %10s %10s %10s %10s\n",
+            "phase",
+            "count",
+            "total[s]",
+            "mean[us]",
+            "p50[us]",
+            "p99[us]",
+            "max[us]");
+
+    for(uint32_t phase = 0; (phase < nbphase) && (phase < INFO_INSTR_NBPHASE);
+            phase++)
+    {
+        const INFO_INSTR_PHASE *ph    = &block->phase[phase];
+        uint64_t                count = ph->count;
+
+        if(count == 0)
+        {
+            continue;
+        }
+        fprintf(fp,
+                "  %-30.*s %10lu %12.6f %10.1f %10.1f %10.1f %10.1f\n",
+                INFO_INSTR_NAMESIZE,
+                ph->name,
+                (unsigned long) count,
+                1.0e-9 * ph->totalns,
+                1.0e-3 * ph->totalns / count,
+                instr_hist_percentile(ph, count, 0.5),
+                instr_hist_percentile(ph, count, 0.99),
+                1.0e-3 * ph->maxns);
+    }
+}
@@ -0,0 +1,104 @@
+/**
+ * @file    info_instr.h
+ * @brief   phase timers with duration histograms, in a shared memory block
+ */
+
+#ifndef _INFO_INSTR_H
+#define _INFO_INSTR_H
+
+#include <time.h>
+
+#define INFO_INSTR_MAGIC     0x52534e49 // "INSR"
+#define INFO_INSTR_VERSION   1
+#define INFO_INSTR_NBPHASE   48
+#define INFO_INSTR_NAMESIZE  32
+#define INFO_INSTR_NBBIN     32 // bin b : duration in [2^b, 2^(b+1)) ns
+
+// shared memory block suffix, after process or stream name
+#define INFO_INSTR_SHMSUFFIX ".instr.shm"
+
+typedef struct
+{
+    char     name[INFO_INSTR_NAMESIZE];
+    uint64_t count;
+    uint64_t totalns;
+    uint64_t maxns;
+    uint64_t hist[INFO_INSTR_NBBIN]; // last bin also counts longer durations
+} INFO_INSTR_PHASE;
+
+// layout of the shared memory block, read by external tools
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t  pid;
+    uint32_t nbphase;
+    int64_t  tstart; // CLOCK_REALTIME at creation [ns]
+
+    INFO_INSTR_PHASE phase[INFO_INSTR_NBPHASE];
+} INFO_INSTR_BLOCK;
+
+// scoped timer, see INFO_INSTR_SCOPE
+typedef struct
+{
+    int        *phase;
+    const char *name;
+    uint64_t    t0;
+} INFO_INSTR_TIMER;
+
+extern INFO_INSTR_BLOCK *info_instr_block;
+
+errno_t info_instr_init(const char *fname);
+
+int info_instr_register(const char *name);
+
+void info_instr_record(int phase, uint64_t ns);
+
+errno_t info_instr_phase_get(const char *name,
+                             uint64_t   *count,
+                             uint64_t   *totalns);
+
+void info_instr_timer_end(INFO_INSTR_TIMER *timer);
+
+INFO_INSTR_BLOCK *info_instr_open(const char *fname);
+
+void info_instr_close(INFO_INSTR_BLOCK *block);
+
+void info_instr_print(const INFO_INSTR_BLOCK *block, FILE *fp);
+
+// CLOCK_MONOTONIC [ns]
+static inline uint64_t info_instr_now()
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return (uint64_t) t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+// start time, 0 if instrumentation is off
+static inline INFO_INSTR_TIMER info_instr_timer_start(int        *phase,
+        const char *name)
+{
+    INFO_INSTR_TIMER timer = {phase, name, 0};
+
+    if(__atomic_load_n(&info_instr_block, __ATOMIC_RELAXED) != NULL)
+    {
+        timer.t0 = info_instr_now();
+    }
+
+    return timer;
+}
+
+#define INFO_INSTR_CAT_(a, b) a##b
+#define INFO_INSTR_CAT(a, b)  INFO_INSTR_CAT_(a, b)
+
+// time from this statement to the end of the enclosing block
+// phase is registered on first use, then found through a static index
+#define INFO_INSTR_SCOPE(name)                                                 \
+    static int INFO_INSTR_CAT(instrphase, __LINE__) = -1;                      \
+    INFO_INSTR_TIMER INFO_INSTR_CAT(instrtimer, __LINE__)                      \
+    __attribute__((cleanup(info_instr_timer_end))) =                           \
+        info_instr_timer_start(&INFO_INSTR_CAT(instrphase, __LINE__), name)
+
+#endif
@@ -0,0 +1,475 @@
+/**
+ * @file    info_pool.c
+ * @brief   persistent worker thread pool for info kernels
+ *
+ * Worker threads are created once, at module load, and sleep on a
+ * condition variable between calls. A parallel call splits the work into
+ * tasks, picked in any order by the workers and by the calling thread,
+ * which also computes. Partial results are merged by the caller in task
+ * order, so results do not depend on the number of threads that actually
+ * took part.
+ *
+ * Configuration, read when the pool is created :
+ * - INFO_NBTHREAD : number of threads, calling thread included. 1 disables
+ *   worker threads.
+ * - INFO_CPUSET   : CPU list, for example "2-5,8". Each worker is pinned to
+ *   one CPU of the list, the first CPU is left for the calling thread.
+ *   Real-time cores are kept free by leaving them out of the list.
+ *
+ * Without INFO_CPUSET, workers may run on any CPU of the process affinity
+ * mask that belongs to the NUMA node of the calling thread, so that a
+ * frame is read by cores close to the memory it was written to. The whole
+ * affinity mask is used if node information is not available.
+ *
+ * Only one parallel call runs at a time. A call issued while the pool is
+ * busy, from another thread or from within a task, runs its tasks serially
+ * in the calling thread instead of waiting.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#include "info_core.h"
+
+#include "info_pool.h"
+
+// iterations of busy-wait for task completion before blocking
+#define INFO_POOL_SPIN 4000
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  condstart; // new job, or stop request
+    pthread_cond_t  conddone;  // a worker left the job
+    pthread_mutex_t runlock;   // held by caller for the duration of a job
+
+    int       nbthread; // calling thread included
+    pthread_t thread[INFO_POOL_MAXTHREAD];
+
+    // current job, written under lock
+    INFO_POOL_TASK func;
+    void          *arg;
+    int            nbtask;
+    uint64_t       jobindex;
+    int            stop;
+
+    atomic_int nexttask;
+    atomic_int nbtaskdone;
+    atomic_int nbactive; // workers between job start and job exit
+} INFO_POOL;
+
+static INFO_POOL pool = {.lock      = PTHREAD_MUTEX_INITIALIZER,
+                         .condstart = PTHREAD_COND_INITIALIZER,
+                         .conddone  = PTHREAD_COND_INITIALIZER,
+                         .runlock   = PTHREAD_MUTEX_INITIALIZER,
+                         .nbthread  = 0};
+
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Parse CPU list "0-3,8,10-11" into cpuset
+ *
+ * Returns number of CPUs in list, -1 if list is malformed.
+ */
+static int pool_parse_cpulist(const char *cpulist, cpu_set_t *cpuset)
+{
+    const char *p = cpulist;
+
+    CPU_ZERO(cpuset);
+    while(*p != '\0')
+    {
+        char *pend;
+        long  cpu0 = strtol(p, &pend, 10);
+        long  cpu1 = cpu0;
+
+        if(pend == p)
+        {
+            return -1;
+        }
+        p = pend;
+        if(*p == '-')
+        {
+            p++;
+            cpu1 = strtol(p, &pend, 10);
+            if(pend == p)
+            {
+                return -1;
+            }
+            p = pend;
+        }
+        if((cpu0 < 0) || (cpu1 < cpu0) || (cpu1 >= CPU_SETSIZE))
+        {
+            return -1;
+        }
+        for(long cpu = cpu0; cpu <= cpu1; cpu++)
+        {
+            CPU_SET(cpu, cpuset);
+        }
+        while((*p == ',') || (*p == ' ') || (*p == '\n'))
+        {
+            p++;
+        }
+    }
+
+    return CPU_COUNT(cpuset);
+}
+
+/**
+ * @brief CPUs of the NUMA node of CPU cpu
+ *
+ * Returns number of CPUs, 0 if node information is not available.
+ */
+static int pool_numa_cpuset(int cpu, cpu_set_t *nodeset)
+{
+    for(int node = 0; node < CPU_SETSIZE; node++)
+    {
+        char  fname[128];
+        char  cpulist[4096];
+        FILE *fp;
+
+        snprintf(fname,
+                 sizeof(fname),
+                 "/sys/devices/system/node/node%d/cpulist",
+                 node);
+        fp = fopen(fname, "r");
+        if(fp == NULL)
+        {
+            return 0;
+        }
+        if(fgets(cpulist, sizeof(cpulist), fp) == NULL)
+        {
+            cpulist[0] = '\0';
+        }
+        fclose(fp);
+
+        if((pool_parse_cpulist(cpulist, nodeset) > 0) &&
+                CPU_ISSET(cpu, nodeset))
+        {
+            return CPU_COUNT(nodeset);
+        }
+    }
+
+    return 0;
+}
+
+// run tasks of current job until none is left
+static void pool_runtasks(INFO_POOL_TASK func, void *arg, int nbtask)
+{
+    int task;
+
+    while((task = atomic_fetch_add(&pool.nexttask, 1)) < nbtask)
+    {
+        func(arg, task, nbtask);
+        atomic_fetch_add(&pool.nbtaskdone, 1);
+    }
+}
+
+static void *pool_worker(void *ptr)
+{
+    uint64_t jobindex;
+
+    (void) ptr;
+
+    pthread_mutex_lock(&pool.lock);
+    jobindex = pool.jobindex;
+    for(;;)
+    {
+        while((!pool.stop) && (pool.jobindex == jobindex))
+        {
+            pthread_cond_wait(&pool.condstart, &pool.lock);
+        }
+        if(pool.stop)
+        {
+            break;
+        }
+
+        // job fields are only rewritten once nbactive is back to 0
+        jobindex              = pool.jobindex;
+        INFO_POOL_TASK func   = pool.func;
+        void          *arg    = pool.arg;
+        int            nbtask = pool.nbtask;
+        atomic_fetch_add(&pool.nbactive, 1);
+        pthread_mutex_unlock(&pool.lock);
+
+        pool_runtasks(func, arg, nbtask);
+
+        pthread_mutex_lock(&pool.lock);
+        if(atomic_fetch_sub(&pool.nbactive, 1) == 1)
+        {
+            pthread_cond_broadcast(&pool.conddone);
+        }
+    }
+    pthread_mutex_unlock(&pool.lock);
+
+    return NULL;
+}
+
+// stop and join workers, runlock held
+static void pool_stop()
+{
+    pthread_mutex_lock(&pool.lock);
+    pool.stop = 1;
+    pthread_cond_broadcast(&pool.condstart);
+    pthread_mutex_unlock(&pool.lock);
+
+    for(int w = 0; w < pool.nbthread - 1; w++)
+    {
+        pthread_join(pool.thread[w], NULL);
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    pool.stop     = 0;
+    pool.nbthread = (pool.nbthread > 0) ? 1 : 0;
+    pthread_mutex_unlock(&pool.lock);
+}
+
+static void pool_init_default()
+{
+    if(pool.nbthread == 0)
+    {
+        info_pool_init(0, NULL);
+    }
+}
+
+/**
+ * @brief Create worker threads
+ *
+ * nbthread counts the calling thread. If 0, INFO_NBTHREAD is used, or the
+ * number of CPUs available. cpulist as in INFO_CPUSET, NULL to read
+ * INFO_CPUSET, empty string for default placement.
+ * An existing pool is stopped and replaced.
+ */
+errno_t info_pool_init(int nbthread, const char *cpulist)
+{
+    cpu_set_t cpuset;
+    int       nbcpu  = 0;
+    int       pinned = 0; // one CPU per worker
+
+    if(cpulist == NULL)
+    {
+        cpulist = getenv("INFO_CPUSET");
+    }
+    if((cpulist != NULL) && (cpulist[0] != '\0'))
+    {
+        nbcpu = pool_parse_cpulist(cpulist, &cpuset);
+        if(nbcpu < 1)
+        {
+            PRINT_ERROR("invalid CPU list \"%s\"", cpulist);
+            return RETURN_FAILURE;
+        }
+        pinned = 1;
+    }
+    else
+    {
+        cpu_set_t nodeset;
+
+        CPU_ZERO(&cpuset);
+        sched_getaffinity(0, sizeof(cpu_set_t), &cpuset);
+        int       cpu = sched_getcpu();
+        if((cpu >= 0) && (pool_numa_cpuset(cpu, &nodeset) > 0))
+        {
+            CPU_AND(&nodeset, &nodeset, &cpuset);
+            if(CPU_COUNT(&nodeset) > 0)
+            {
+                cpuset = nodeset;
+            }
+        }
+        nbcpu = CPU_COUNT(&cpuset);
+    }
+
+    if((nbthread < 1) && (getenv("INFO_NBTHREAD") != NULL))
+    {
+        nbthread = atoi(getenv("INFO_NBTHREAD"));
+    }
+    if(nbthread < 1)
+    {
+        nbthread = nbcpu;
+    }
+    if(nbthread < 1)
+    {
+        nbthread = 1;
+    }
+    if(nbthread > INFO_POOL_MAXTHREAD)
+    {
+        nbthread = INFO_POOL_MAXTHREAD;
+    }
+
+    // CPUs of list, in increasing order
+    int cpuarray[CPU_SETSIZE];
+    int ncpu = 0;
+    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if(CPU_ISSET(cpu, &cpuset))
+        {
+            cpuarray[ncpu++] = cpu;
+        }
+    }
+
+    pthread_mutex_lock(&pool.runlock);
+    pool_stop();
+
+    int nbworker = 0;
+    for(int w = 0; w < nbthread - 1; w++)
+    {
+        cpu_set_t workerset = cpuset;
+        if(pinned)
+        {
+            // first CPU of list kept for calling thread
+            CPU_ZERO(&workerset);
+            CPU_SET(cpuarray[(w + 1) % ncpu], &workerset);
+        }
+
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &workerset);
+        int err = pthread_create(&pool.thread[w], &attr, pool_worker, NULL);
+        pthread_attr_destroy(&attr);
+        if(err != 0)
+        {
+            PRINT_ERROR("pthread_create error %d", err);
+            break;
+        }
+
+        char tname[16];
+        snprintf(tname, sizeof(tname), "infopool%02d", w);
+        pthread_setname_np(pool.thread[w], tname);
+        nbworker++;
+    }
+    pool.nbthread = nbworker + 1;
+    pthread_mutex_unlock(&pool.runlock);
+
+    return RETURN_SUCCESS;
+}
+
+/**
+ * @brief Stop and join worker threads
+ *
+ * Parallel calls run serially until the pool is created again.
+ */
+void info_pool_free()
+{
+    pthread_mutex_lock(&pool.runlock);
+    pool_stop();
+    pthread_mutex_unlock(&pool.runlock);
+}
+
+/**
+ * @brief Number of threads, calling thread included
+ */
+int info_pool_nbthread()
+{
+    pthread_once(&pool_once, pool_init_default);
+
+    return (pool.nbthread > 1) ? pool.nbthread : 1;
+}
+
+/**
+ * @brief Number of tasks for nelement items
+ *
+ * At least nbmin items per task, at most one task per thread.
+ */
+int info_pool_nbtask(uint64_t nelement, uint64_t nbmin)
+{
+    int      nbthread = info_pool_nbthread();
+    uint64_t nbtask   = (nbmin > 0) ? nelement / nbmin : nelement;
+
+    if(nbtask < 1)
+    {
+        return 1;
+    }
+    if(nbtask > (uint64_t) nbthread)
+    {
+        return nbthread;
+    }
+
+    return (int) nbtask;
+}
+
+/**
+ * @brief Run func(arg, task, nbtask) for task = 0 to nbtask - 1
+ *
+ * Returns when all tasks are complete. Tasks may run in any order, in any
+ * thread.
+ */
+errno_t info_pool_run(int nbtask, INFO_POOL_TASK func, void *arg)
+{
+    pthread_once(&pool_once, pool_init_default);
+
+    if((nbtask < 2) || (pool.nbthread < 2) ||
+            (pthread_mutex_trylock(&pool.runlock) != 0))
+    {
+        for(int task = 0; task < nbtask; task++)
+        {
+            func(arg, task, nbtask);
+        }
+        return RETURN_SUCCESS;
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    // workers still leaving the previous job read its fields
+    while(atomic_load(&pool.nbactive) > 0)
+    {
+        pthread_cond_wait(&pool.conddone, &pool.lock);
+    }
+    pool.func   = func;
+    pool.arg    = arg;
+    pool.nbtask = nbtask;
+    atomic_store(&pool.nexttask, 0);
+    atomic_store(&pool.nbtaskdone, 0);
+    pool.jobindex++;
+    pthread_cond_broadcast(&pool.condstart);
+    pthread_mutex_unlock(&pool.lock);
+
+    pool_runtasks(func, arg, nbtask);
+
+    for(int spin = 0;
+            (spin < INFO_POOL_SPIN) &&
+            (atomic_load(&pool.nbtaskdone) < nbtask);
+            spin++)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    while((atomic_load(&pool.nbtaskdone) < nbtask) ||
+            (atomic_load(&pool.nbactive) > 0))
+    {
+        pthread_cond_wait(&pool.conddone, &pool.lock);
+    }
+    pthread_mutex_unlock(&pool.lock);
+
+    pthread_mutex_unlock(&pool.runlock);
+
+    return RETURN_SUCCESS;
+}
+
+/**
+ * @brief Run tasks, then merge partial results
+ *
+ * partarray holds nbtask elements of partsize bytes, element task is
+ * written by task. Elements 1 to nbtask - 1 are merged into element 0, in
+ * task order.
+ */
+errno_t info_pool_reduce(int             nbtask,
+                         INFO_POOL_TASK  func,
+                         void           *arg,
+                         void           *partarray,
+                         size_t          partsize,
+                         INFO_POOL_MERGE merge)
+{
+    errno_t ret = info_pool_run(nbtask, func, arg);
+
+    for(int task = 1; task < nbtask; task++)
+    {
+        merge(partarray, (char *) partarray + (size_t) task * partsize);
+    }
+
+    return ret;
+}
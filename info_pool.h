@@ -0,0 +1,46 @@
+/**
+ * @file    info_pool.h
+ * @brief   persistent worker thread pool for info kernels
+ */
+
+#ifndef _INFO_POOL_H
+#define _INFO_POOL_H
+
+// maximum number of threads, calling thread included
+#define INFO_POOL_MAXTHREAD 64
+
+// task function : process task number task out of nbtask
+typedef void (*INFO_POOL_TASK)(void *arg, int task, int nbtask);
+
+// merge partial result src into dst
+typedef void (*INFO_POOL_MERGE)(void *dst, const void *src);
+
+errno_t info_pool_init(int nbthread, const char *cpulist);
+
+void info_pool_free();
+
+int info_pool_nbthread();
+
+int info_pool_nbtask(uint64_t nelement, uint64_t nbmin);
+
+errno_t info_pool_run(int nbtask, INFO_POOL_TASK func, void *arg);
+
+errno_t info_pool_reduce(int             nbtask,
+                         INFO_POOL_TASK  func,
+                         void           *arg,
+                         void           *partarray,
+                         size_t          partsize,
+                         INFO_POOL_MERGE merge);
+
+// range [*start, *end) of task out of nbtask, for nelement items
+static inline void info_pool_range(uint64_t  nelement,
+                                   int       task,
+                                   int       nbtask,
+                                   uint64_t *start,
+                                   uint64_t *end)
+{
+    *start = nelement * task / nbtask;
+    *end   = nelement * (task + 1) / nbtask;
+}
+
+#endif
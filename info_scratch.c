@@ -0,0 +1,250 @@
+/**
+ * @file    info_scratch.c
+ * @brief   per-thread scratch arena for temporary kernel buffers
+ *
+ * Kernels take their temporary arrays (value copies, per-task partial
+ * results, heaps, text buffers) from the arena of the calling thread
+ * instead of calling malloc and free on every frame :
+ *
+ *     size_t  mark = info_scratch_mark();
+ *     double *a    = (double *) info_scratch_alloc(sizeof(double) * n);
+ *     ...
+ *     info_scratch_release(mark);
+ *
+ * Buffers are stacked : release frees everything allocated since mark, so
+ * a kernel may call another kernel that also uses the arena. A request that
+ * does not fit is served by a separately mapped block. When the arena is
+ * empty again, it is remapped at its high-water mark, so that after the
+ * first frame, repeated calls on frames of the same size make no heap
+ * allocation. The arena is pre-faulted when mapped, and kept until the
+ * thread exits or calls info_scratch_free().
+ *
+ * Arenas of 2 MB or more are advised for transparent huge pages. With
+ * environment variable INFO_SCRATCH_HUGEPAGE=1, explicit huge pages
+ * (/proc/sys/vm/nr_hugepages) are used instead when available.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "info_core.h"
+
+#include "info_scratch.h"
+
+// huge page size, smaller arenas use regular pages
+#define INFO_SCRATCH_HUGEPAGE (2UL * 1024 * 1024)
+
+// header of a block mapped for a request that did not fit in the arena
+// buffer starts INFO_SCRATCH_ALIGN bytes after the header
+typedef struct INFO_SCRATCH_BLOCK
+{
+    struct INFO_SCRATCH_BLOCK *prev;
+    size_t                     mapsize;
+    size_t                     offset; // arena offset of the request
+} INFO_SCRATCH_BLOCK;
+
+typedef struct
+{
+    char  *base;
+    size_t size;      // mapped size
+    size_t used;      // offset of next buffer, blocks included
+    size_t highwater; // maximum of used
+
+    INFO_SCRATCH_BLOCK *block; // most recent block first
+} INFO_SCRATCH;
+
+static __thread INFO_SCRATCH scratch;
+
+static pthread_once_t scratch_once = PTHREAD_ONCE_INIT;
+static pthread_key_t  scratch_key; // frees arena at thread exit
+static int            scratch_hugetlb = 0;
+
+static void scratch_destroy(void *ptr)
+{
+    (void) ptr;
+    info_scratch_free();
+}
+
+static void scratch_init()
+{
+    const char *envstr = getenv("INFO_SCRATCH_HUGEPAGE");
+
+    scratch_hugetlb = ((envstr != NULL) && (atoi(envstr) > 0));
+    pthread_key_create(&scratch_key, scratch_destroy);
+}
+
+/**
+ * @brief Map and pre-fault at least size bytes
+ *
+ * *mapsize receives the mapped size.
+ */
+static void *scratch_map(size_t size, size_t *mapsize)
+{
+    size_t pagesize = (size_t) sysconf(_SC_PAGESIZE);
+    void  *ptr;
+
+    if(size >= INFO_SCRATCH_HUGEPAGE)
+    {
+        *mapsize = (size + INFO_SCRATCH_HUGEPAGE - 1) &
+                   ~(INFO_SCRATCH_HUGEPAGE - 1);
+        if(scratch_hugetlb)
+        {
+            ptr = mmap(NULL,
+                       *mapsize,
+                       PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                       MAP_POPULATE,
+                       -1,
+                       0);
+            if(ptr != MAP_FAILED)
+            {
+                return ptr;
+            }
+        }
+    }
+    else
+    {
+        *mapsize = (size + pagesize - 1) & ~(pagesize - 1);
+    }
+
+    ptr = mmap(NULL,
+               *mapsize,
+               PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS,
+               -1,
+               0);
+    if(ptr == MAP_FAILED)
+    {
+        PRINT_ERROR("mmap returns MAP_FAILED");
+        abort();
+    }
+
+#ifdef MADV_HUGEPAGE
+    if(*mapsize >= INFO_SCRATCH_HUGEPAGE)
+    {
+        madvise(ptr, *mapsize, MADV_HUGEPAGE);
+    }
+#endif
+
+    // fault pages in now rather than in the kernels
+    for(size_t offset = 0; offset < *mapsize; offset += pagesize)
+    {
+        ((volatile char *) ptr)[offset] = 0;
+    }
+
+    return ptr;
+}
+
+/**
+ * @brief Current position in the arena of the calling thread
+ */
+size_t info_scratch_mark()
+{
+    return scratch.used;
+}
+
+/**
+ * @brief Scratch buffer of size bytes, INFO_SCRATCH_ALIGN-aligned
+ *
+ * Content is undefined. Valid until info_scratch_release() is called with
+ * a mark taken before this call.
+ */
+void *info_scratch_alloc(size_t size)
+{
+    void *ptr;
+
+    size = (size + INFO_SCRATCH_ALIGN - 1) & ~(size_t)(INFO_SCRATCH_ALIGN - 1);
+    if(size == 0)
+    {
+        size = INFO_SCRATCH_ALIGN;
+    }
+
+    if((scratch.block == NULL) && (scratch.used + size <= scratch.size))
+    {
+        ptr = scratch.base + scratch.used;
+    }
+    else
+    {
+        INFO_SCRATCH_BLOCK *block;
+        size_t              mapsize;
+
+        pthread_once(&scratch_once, scratch_init);
+        pthread_setspecific(scratch_key, &scratch);
+
+        block          = scratch_map(size + INFO_SCRATCH_ALIGN, &mapsize);
+        block->prev    = scratch.block;
+        block->mapsize = mapsize;
+        block->offset  = scratch.used;
+        scratch.block  = block;
+
+        ptr = (char *) block + INFO_SCRATCH_ALIGN;
+    }
+
+    scratch.used += size;
+    if(scratch.used > scratch.highwater)
+    {
+        scratch.highwater = scratch.used;
+    }
+
+    return ptr;
+}
+
+/**
+ * @brief Zero-initialized scratch buffer of nmemb elements
+ */
+void *info_scratch_calloc(size_t nmemb, size_t size)
+{
+    void *ptr = info_scratch_alloc(nmemb * size);
+
+    memset(ptr, 0, nmemb * size);
+
+    return ptr;
+}
+
+/**
+ * @brief Release buffers allocated since mark
+ */
+void info_scratch_release(size_t mark)
+{
+    while((scratch.block != NULL) && (scratch.block->offset >= mark))
+    {
+        INFO_SCRATCH_BLOCK *block = scratch.block;
+
+        scratch.block = block->prev;
+        munmap(block, block->mapsize);
+    }
+    scratch.used = mark;
+
+    // grow arena to high-water mark once it is empty
+    if((scratch.used == 0) && (scratch.highwater > scratch.size))
+    {
+        if(scratch.base != NULL)
+        {
+            munmap(scratch.base, scratch.size);
+        }
+        scratch.base = (char *) scratch_map(scratch.highwater, &scratch.size);
+    }
+}
+
+/**
+ * @brief Unmap arena of the calling thread
+ *
+ * No scratch buffer of the calling thread may be in use.
+ */
+void info_scratch_free()
+{
+    scratch.highwater = 0;
+    info_scratch_release(0);
+    if(scratch.base != NULL)
+    {
+        munmap(scratch.base, scratch.size);
+    }
+    scratch.base = NULL;
+    scratch.size = 0;
+}
@@ -0,0 +1,22 @@
+/**
+ * @file    info_scratch.h
+ * @brief   per-thread scratch arena for temporary kernel buffers
+ */
+
+#ifndef _INFO_SCRATCH_H
+#define _INFO_SCRATCH_H
+
+// alignment of scratch buffers
+#define INFO_SCRATCH_ALIGN 64
+
+size_t info_scratch_mark();
+
+void *info_scratch_alloc(size_t size);
+
+void *info_scratch_calloc(size_t nmemb, size_t size);
+
+void info_scratch_release(size_t mark);
+
+void info_scratch_free();
+
+#endif
@@ -0,0 +1,34 @@
+/**
+ * @file    info_simd.h
+ * @brief   runtime instruction set dispatch for hot kernels
+ *
+ * Functions declared with INFO_SIMD_CLONES are compiled once per
+ * instruction set listed below. The dynamic loader selects the widest
+ * version supported by the CPU when the library is loaded (GNU ifunc), so a
+ * single build runs at full vector width on AVX2 and AVX-512 hosts, and
+ * still runs on older x86_64 CPUs.
+ *
+ * Hot loops must be inside the cloned function, and OpenMP parallel
+ * regions outside of it : the parallel region calls the cloned function on
+ * its share of the data.
+ *
+ * Define INFO_NO_SIMD_CLONES (cmake -DINFO_SIMD_DISPATCH=OFF) to compile a
+ * single version, for example when building with -march=native.
+ */
+
+#ifndef _INFO_SIMD_H
+#define _INFO_SIMD_H
+
+#if defined(__x86_64__) && defined(__has_attribute) &&                         \
+    !defined(INFO_NO_SIMD_CLONES)
+#if __has_attribute(target_clones)
+#define INFO_SIMD_CLONES                                                       \
+    __attribute__((target_clones("avx512f", "avx2", "default")))
+#endif
+#endif
+
+#ifndef INFO_SIMD_CLONES
+#define INFO_SIMD_CLONES
+#endif
+
+#endif
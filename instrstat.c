@@ -0,0 +1,101 @@
+/**
+ * @file    instrstat.c
+ * @brief   phase timer tables of running processes
+ *
+ * Phase timers (info_instr.c) are written to shared memory block
+ * <shmdir>/<name>.instr.shm. The image monitor uses its process name.
+ * Other processes loading the module enable timers by setting environment
+ * variable INFO_INSTR to the block name.
+ *
+ * The block layout is INFO_INSTR_BLOCK, so that scripts can also map the
+ * file directly.
+ */
+
+#include "CommandLineInterface/CLIcore.h"
+
+#include "info_instr.h"
+#include "instrstat.h"
+
+// ==========================================
+// Command line interface wrapper function(s)
+// ==========================================
+
+static errno_t info_instrstat_cli()
+{
+    if(CLI_checkarg(1, CLIARG_STR_NOT_IMG) == 0)
+    {
+        info_instrstat(data.cmdargtoken[1].val.string);
+        return CLICMD_SUCCESS;
+    }
+    else
+    {
+        return CLICMD_INVALID_ARG;
+    }
+}
+
+// ==========================================
+// Register CLI command(s)
+// ==========================================
+
+errno_t instrstat_addCLIcmd()
+{
+    RegisterCLIcommand(
+        "instrstat",
+        __FILE__,
+        info_instrstat_cli,
+        "print phase timers of process",
+        "<block name, process name for image monitor>",
+        "instrstat imgmon-im1",
+        "errno_t info_instrstat(const char *name)");
+
+    return RETURN_SUCCESS;
+}
+
+/**
+ * @brief Enable phase timers if INFO_INSTR is set
+ */
+errno_t info_instr_env_init()
+{
+    const char *name = getenv("INFO_INSTR");
+    char        fname[STRINGMAXLEN_FULLFILENAME];
+
+    if((name == NULL) || (name[0] == '\0'))
+    {
+        return RETURN_SUCCESS;
+    }
+
+    WRITE_FULLFILENAME(fname,
+                       "%s/%s%s",
+                       data.shmdir,
+                       name,
+                       INFO_INSTR_SHMSUFFIX);
+
+    return info_instr_init(fname);
+}
+
+/**
+ * @brief Print phase timers of block name
+ */
+errno_t info_instrstat(const char *name)
+{
+    char              fname[STRINGMAXLEN_FULLFILENAME];
+    INFO_INSTR_BLOCK *block;
+
+    WRITE_FULLFILENAME(fname,
+                       "%s/%s%s",
+                       data.shmdir,
+                       name,
+                       INFO_INSTR_SHMSUFFIX);
+
+    block = info_instr_open(fname);
+    if(block == NULL)
+    {
+        PRINT_ERROR("no phase timers in %s", fname);
+        return RETURN_FAILURE;
+    }
+
+    info_instr_print(block, stdout);
+    info_instr_close(block);
+
+    return RETURN_SUCCESS;
+}
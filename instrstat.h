@@ -0,0 +1,14 @@
+/**
+ * @file    instrstat.h
+ */
+
+#ifndef _INFO_INSTRSTAT_H
+#define _INFO_INSTRSTAT_H
+
+errno_t info_instr_env_init();
+
+errno_t info_instrstat(const char *name);
+
+errno_t instrstat_addCLIcmd();
+
+#endif
@@ -1,95 +1,102 @@
 /** @file percentile.c
  */
 
+#include <math.h>
+
 #include "CommandLineInterface/CLIcore.h"
 
 #include "COREMOD_memory/COREMOD_memory.h"
-#include "COREMOD_tools/COREMOD_tools.h"
 
+#include "imsnapshot.h"
+#include "imstats.h"
+
+typedef struct
+{
+    double *p;
+    double *value;
+} PERCENTILE_ARG;
+
+// run by imsnapshot_run()
+static errno_t img_percentile_compute(IMAGE *image, void *arg)
+{
+    PERCENTILE_ARG *parg = (PERCENTILE_ARG *) arg;
+
+    return image_percentiles(image, 1, parg->p, parg->value);
+}
+
+// percentile p of image, on a consistent frame if the stream is written
+// while read
+static errno_t img_percentile_snapshot(IMAGE *image, double p, double *value)
+{
+    IMSNAPSHOT     snap = {0};
+    PERCENTILE_ARG parg = {&p, value};
+    errno_t        ret;
+
+    ret = imsnapshot_run(&snap, image, img_percentile_compute, &parg);
+    if(snap.torn)
+    {
+        PRINT_WARNING("image %s changed during every read (%lu torn), "
+                      "percentile may mix frames",
+                      image->name,
+                      snap.nbtorn);
+    }
+    imsnapshot_free(&snap);
+
+    return ret;
+}
 
 float img_percentile_float(const char *ID_name, float p)
 {
     imageID  ID;
-    uint32_t naxes[2];
-    float    value = 0;
-    float   *array;
     uint64_t nelements;
-    uint64_t n;
+    uint64_t n = 0;
+    double   value;
+    double   pd = p;
 
-    ID        = image_ID(ID_name);
-    naxes[0]  = data.image[ID].md[0].size[0];
-    naxes[1]  = data.image[ID].md[0].size[1];
-    nelements = naxes[0] * naxes[1];
-
-    array = (float *) malloc(nelements * sizeof(float));
-    if(array == NULL)
+    ID = image_ID(ID_name);
+    if(ID == -1)
     {
-        PRINT_ERROR("malloc returns NULL pointer");
-        abort();
+        PRINT_ERROR("image %s not found", ID_name);
+        return NAN;
     }
 
-    for(unsigned long ii = 0; ii < nelements; ii++)
+    if(img_percentile_snapshot(&data.image[ID], pd, &value) != RETURN_SUCCESS)
     {
-        array[ii] = data.image[ID].array.F[ii];
+        return NAN;
     }
 
-    quick_sort_float(array, nelements);
-
-    n = (uint64_t)(p * naxes[1] * naxes[0]);
-    if(n > 0)
+    nelements = data.image[ID].md[0].nelement;
+    if(p > 0.0)
     {
+        n = (uint64_t)(p * nelements);
         if(n > (nelements - 1))
         {
             n = (nelements - 1);
         }
     }
-    value = array[n];
-    free(array);
 
     printf("percentile %f = %f (%ld)\n", p, value, n);
 
-    return (value);
+    return ((float) value);
 }
 
 double img_percentile_double(const char *ID_name, double p)
 {
-    imageID  ID;
-    uint32_t naxes[2];
-    double   value = 0;
-    double  *array;
-    uint64_t nelements;
-    uint64_t n;
-
-    ID        = image_ID(ID_name);
-    naxes[0]  = data.image[ID].md[0].size[0];
-    naxes[1]  = data.image[ID].md[0].size[1];
-    nelements = naxes[0] * naxes[1];
+    imageID ID;
+    double  value;
 
-    array = (double *) malloc(nelements * sizeof(double));
-    if(array == NULL)
+    ID = image_ID(ID_name);
+    if(ID == -1)
     {
-        PRINT_ERROR("malloc returns NULL pointer");
-        abort();
+        PRINT_ERROR("image %s not found", ID_name);
+        return NAN;
     }
 
-    for(unsigned long ii = 0; ii < nelements; ii++)
+    if(img_percentile_snapshot(&data.image[ID], p, &value) != RETURN_SUCCESS)
     {
-        array[ii] = data.image[ID].array.F[ii];
+        return NAN;
     }
 
-    quick_sort_double(array, nelements);
-
-    n = (uint64_t)(p * naxes[1] * naxes[0]);
-    if(n > 0)
-    {
-        if(n > (nelements - 1))
-        {
-            n = (nelements - 1);
-        }
-    }
-    value = array[n];
-    free(array);
-
     return (value);
 }
 
@@ -99,14 +106,19 @@ double img_percentile(const char *ID_name, double p)
     uint8_t datatype;
     double  value = 0.0;
 
-    ID       = image_ID(ID_name);
+    ID = image_ID(ID_name);
+    if(ID == -1)
+    {
+        PRINT_ERROR("image %s not found", ID_name);
+        return NAN;
+    }
     datatype = data.image[ID].md[0].datatype;
 
     if(datatype == _DATATYPE_FLOAT)
     {
         value = (double) img_percentile_float(ID_name, (float) p);
     }
-    if(datatype == _DATATYPE_DOUBLE)
+    else
     {
         value = img_percentile_double(ID_name, p);
     }
@@ -0,0 +1,761 @@
+/**
+ * @file    printpix.c
+ * @brief   pixel values export to file, binary or text
+ *
+ * Binary mode writes raw pixel values in native datatype, row-major.
+ * Without x striding, rows are written straight from the image buffer with
+ * writev(), consecutive rows being merged, so that a full frame is a
+ * single write.
+ *
+ * Text mode writes one line "ii jj value" per pixel ("ii jj kk value" for
+ * 3D images), with a blank line after each row as expected by gnuplot.
+ * Values are formatted by a dedicated routine instead of printf, into
+ * large buffers. Blocks of rows are formatted in parallel by the worker
+ * pool, one block per thread at a time, and written in order.
+ *
+ * Both modes accept a region of interest and x/y striding. 3D images are
+ * exported for all slices.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "CommandLineInterface/CLIcore.h"
+
+#include "info_instr.h"
+#include "info_pool.h"
+#include "info_scratch.h"
+#include "printpix.h"
+
+// text mode, target bytes formatted per block of rows
+#define PRINTPIX_TEXTBLOCKSIZE (1 << 20)
+
+// longest text line : 3 coordinates, value, separators
+#define PRINTPIX_LINEMAX 96
+
+// coordinate label block, last byte holds label length
+#define PRINTPIX_LABELSIZE 16
+
+// default number of significant digits, text mode
+#define PRINTPIX_PRECISION 7
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+// ==========================================
+// Command line interface wrapper function(s)
+// ==========================================
+
+static errno_t image_export_cli()
+{
+    if(CLI_checkarg(1, CLIARG_IMG) + CLI_checkarg(2, CLIARG_STR_NOT_IMG) +
+            CLI_checkarg(3, CLIARG_STR_NOT_IMG) +
+            CLI_checkarg(4, CLIARG_INT64) + CLI_checkarg(5, CLIARG_INT64) +
+            CLI_checkarg(6, CLIARG_INT64) + CLI_checkarg(7, CLIARG_INT64) +
+            CLI_checkarg(8, CLIARG_INT64) + CLI_checkarg(9, CLIARG_INT64) ==
+            0)
+    {
+        image_export(data.cmdargtoken[1].val.string,
+                     data.cmdargtoken[2].val.string,
+                     data.cmdargtoken[3].val.string,
+                     data.cmdargtoken[4].val.numl,
+                     data.cmdargtoken[5].val.numl,
+                     data.cmdargtoken[6].val.numl,
+                     data.cmdargtoken[7].val.numl,
+                     data.cmdargtoken[8].val.numl,
+                     data.cmdargtoken[9].val.numl);
+        return CLICMD_SUCCESS;
+    }
+    else
+    {
+        return CLICMD_INVALID_ARG;
+    }
+}
+
+static errno_t printpix_cli()
+{
+    if(CLI_checkarg(1, CLIARG_IMG) + CLI_checkarg(2, CLIARG_STR_NOT_IMG) == 0)
+    {
+        printpix(data.cmdargtoken[1].val.string,
+                 data.cmdargtoken[2].val.string);
+        return CLICMD_SUCCESS;
+    }
+    else
+    {
+        return CLICMD_INVALID_ARG;
+    }
+}
+
+// ==========================================
+// Register CLI command(s)
+// ==========================================
+
+errno_t printpix_addCLIcmd()
+{
+    RegisterCLIcommand(
+        "imexport",
+        __FILE__,
+        image_export_cli,
+        "export pixel values of region to file",
+        "<image> <file, - for stdout> <txt/bin> <x0> <y0> <xsize> <ysize> "
+        "<xstep> <ystep>",
+        "imexport im1 im1.dat bin 0 0 0 0 1 1",
+        "errno_t image_export(const char *ID_name, const char *filename, "
+        "const char *modestr, uint32_t x0, uint32_t y0, uint32_t xsize, "
+        "uint32_t ysize, uint32_t xstep, uint32_t ystep)");
+
+    RegisterCLIcommand("printpix",
+                       __FILE__,
+                       printpix_cli,
+                       "print pixel values to text file",
+                       "<image> <file>",
+                       "printpix im1 im1.txt",
+                       "errno_t printpix(const char *ID_name, const char "
+                       "*filename)");
+
+    return RETURN_SUCCESS;
+}
+
+// powers of 10, index k + PRINTPIX_POW10OFFSET for 10^k
+#define PRINTPIX_POW10OFFSET 330
+static double printpix_pow10[2 * PRINTPIX_POW10OFFSET + 1];
+static int    printpix_pow10_init = 0;
+
+static const uint64_t printpix_pow10int[] =
+{
+    1ULL,
+    10ULL,
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL,
+    10000000000ULL,
+    100000000000ULL,
+    1000000000000ULL,
+    10000000000000ULL,
+    100000000000000ULL,
+    1000000000000000ULL
+};
+
+// write buffer, retrying on partial writes
+static errno_t printpix_write_all(int fd, const char *buf, size_t nbyte)
+{
+    while(nbyte > 0)
+    {
+        ssize_t nw = write(fd, buf, nbyte);
+        if(nw < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            return RETURN_FAILURE;
+        }
+        buf += nw;
+        nbyte -= nw;
+    }
+    return RETURN_SUCCESS;
+}
+
+static errno_t printpix_writev_all(int fd, struct iovec *iov, int iovcnt)
+{
+    while(iovcnt > 0)
+    {
+        ssize_t nw = writev(fd, iov, iovcnt);
+        if(nw < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            return RETURN_FAILURE;
+        }
+        while((iovcnt > 0) && ((size_t) nw >= iov->iov_len))
+        {
+            nw -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if(iovcnt > 0)
+        {
+            iov->iov_base = (char *) iov->iov_base + nw;
+            iov->iov_len -= nw;
+        }
+    }
+    return RETURN_SUCCESS;
+}
+
+static inline char *printpix_utoa(char *p, uint64_t v)
+{
+    char  tmp[20];
+    char *t = tmp + 20;
+
+    do
+    {
+        *--t = '0' + (v % 10);
+        v /= 10;
+    } while(v > 0);
+
+    size_t n = tmp + 20 - t;
+    memcpy(p, t, n);
+    return p + n;
+}
+
+static inline char *printpix_itoa(char *p, int64_t v)
+{
+    if(v < 0)
+    {
+        *p++ = '-';
+        return printpix_utoa(p, (uint64_t)(-(v + 1)) + 1);
+    }
+    return printpix_utoa(p, (uint64_t) v);
+}
+
+/**
+ * @brief Format floating point value, as printf %.<prec>g
+ *
+ * Last digit may differ from printf rounding in rare cases, as scaling is
+ * done in double precision. prec is 1 to 15.
+ * Requires printpix_pow10 table.
+ */
+static char *printpix_ftoa(char *p, double v, int prec)
+{
+    if(isnan(v))
+    {
+        memcpy(p, "nan", 3);
+        return p + 3;
+    }
+    if(signbit(v))
+    {
+        *p++ = '-';
+        v    = -v;
+    }
+    if(isinf(v))
+    {
+        memcpy(p, "inf", 3);
+        return p + 3;
+    }
+    if(v == 0.0)
+    {
+        *p++ = '0';
+        return p;
+    }
+
+    // decimal exponent, refined from binary exponent
+    int e2;
+    frexp(v, &e2);
+    int e = (int) floor((e2 - 1) * 0.30102999566398120);
+    if(v >= printpix_pow10[e + 1 + PRINTPIX_POW10OFFSET])
+    {
+        e++;
+    }
+    else if(v < printpix_pow10[e + PRINTPIX_POW10OFFSET])
+    {
+        e--;
+    }
+
+    // prec significant digits as integer, split scaling to avoid overflow
+    int    sc     = prec - 1 - e;
+    double scaled = v;
+    if(sc > 300)
+    {
+        scaled *= 1.0e300;
+        sc -= 300;
+    }
+    scaled *= printpix_pow10[sc + PRINTPIX_POW10OFFSET];
+    uint64_t mant = (uint64_t) rint(scaled);
+    if(mant >= printpix_pow10int[prec])
+    {
+        mant /= 10;
+        e++;
+    }
+
+    // digits, trailing zeros removed
+    char dig[16];
+    for(int i = prec - 1; i >= 0; i--)
+    {
+        dig[i] = '0' + (mant % 10);
+        mant /= 10;
+    }
+    int ndig = prec;
+    while((ndig > 1) && (dig[ndig - 1] == '0'))
+    {
+        ndig--;
+    }
+
+    if((e < -4) || (e >= prec))
+    {
+        *p++ = dig[0];
+        if(ndig > 1)
+        {
+            *p++ = '.';
+            memcpy(p, dig + 1, ndig - 1);
+            p += ndig - 1;
+        }
+        *p++ = 'e';
+        *p++ = (e < 0) ? '-' : '+';
+        int ea = (e < 0) ? -e : e;
+        if(ea < 10)
+        {
+            *p++ = '0';
+        }
+        p = printpix_utoa(p, ea);
+    }
+    else if(e >= 0)
+    {
+        for(int i = 0; i <= e; i++)
+        {
+            *p++ = (i < ndig) ? dig[i] : '0';
+        }
+        if(ndig > e + 1)
+        {
+            *p++ = '.';
+            memcpy(p, dig + e + 1, ndig - e - 1);
+            p += ndig - e - 1;
+        }
+    }
+    else
+    {
+        *p++ = '0';
+        *p++ = '.';
+        for(int i = 0; i < -e - 1; i++)
+        {
+            *p++ = '0';
+        }
+        memcpy(p, dig, ndig);
+        p += ndig;
+    }
+
+    return p;
+}
+
+// one row of text lines
+// coordinates are copied from preformatted labels, as fixed size blocks
+// that may extend past the label end, then overwritten
+#define PRINTPIX_TEXTROW(arrayptr, formatexpr)                                 \
+    do                                                                         \
+    {                                                                          \
+        for(uint32_t i = 0; i < nxout; i++)                                    \
+        {                                                                      \
+            const char *xlab = xlabel + (size_t) i * PRINTPIX_LABELSIZE;       \
+            memcpy(p, xlab, PRINTPIX_LABELSIZE);                               \
+            p += xlab[PRINTPIX_LABELSIZE - 1];                                 \
+            memcpy(p, ylabel, 2 * PRINTPIX_LABELSIZE);                         \
+            p += ylabellen;                                                    \
+            p    = formatexpr((arrayptr)[rowoffset + x0 + i * xstep]);         \
+            *p++ = '\n';                                                       \
+        }                                                                      \
+    } while(0)
+
+#define PRINTPIX_FMT_FLOAT(v) printpix_ftoa(p, (double) (v), precision)
+#define PRINTPIX_FMT_UINT(v)  printpix_utoa(p, (uint64_t) (v))
+#define PRINTPIX_FMT_INT(v)   printpix_itoa(p, (int64_t) (v))
+
+// text mode : blocks block0 to block0 + nbtask - 1, one per task
+typedef struct
+{
+    IMAGE      *image;
+    uint32_t    x0;
+    uint32_t    y0;
+    uint32_t    xstep;
+    uint32_t    ystep;
+    uint32_t    nxout;
+    uint32_t    nyout;
+    long        nrow;
+    int         precision;
+    const char *xlabel;
+    long        rowsperblock;
+    long        block0;
+    size_t      bufsize;
+    char       *buf;    // bufsize bytes per task
+    size_t     *buflen; // bytes formatted per task
+    atomic_int  ret;
+} PRINTPIX_TEXT_JOB;
+
+static void printpix_text_task(void *arg, int task, int nbtask)
+{
+    PRINTPIX_TEXT_JOB *job       = (PRINTPIX_TEXT_JOB *) arg;
+    IMAGE             *image     = job->image;
+    int                naxis     = image->md[0].naxis;
+    uint32_t           xsizeim   = image->md[0].size[0];
+    uint32_t           ysizeim   = (naxis < 2) ? 1 : image->md[0].size[1];
+    uint32_t           x0        = job->x0;
+    uint32_t           xstep     = job->xstep;
+    uint32_t           nxout     = job->nxout;
+    int                precision = job->precision;
+    const char        *xlabel    = job->xlabel;
+    long               b         = job->block0 + task;
+    char              *buf       = job->buf + task * job->bufsize;
+    char              *p         = buf;
+    long               rend      = (b + 1) * job->rowsperblock;
+
+    (void) nbtask;
+
+    if(rend > job->nrow)
+    {
+        rend = job->nrow;
+    }
+
+    for(long r = b * job->rowsperblock; r < rend; r++)
+    {
+        uint64_t kk        = r / job->nyout;
+        uint64_t jj        = job->y0 + (r % job->nyout) * job->ystep;
+        uint64_t rowoffset = (kk * ysizeim + jj) * xsizeim;
+
+        // row label "jj " or "jj kk ", zero padded : copied as a whole
+        char  ylabel[2 * PRINTPIX_LABELSIZE] = {0};
+        char *pend = printpix_utoa(ylabel, jj);
+        *pend++    = ' ';
+        if(naxis == 3)
+        {
+            pend    = printpix_utoa(pend, kk);
+            *pend++ = ' ';
+        }
+        int ylabellen = pend - ylabel;
+
+        switch(image->md[0].datatype)
+        {
+            case _DATATYPE_FLOAT:
+                PRINTPIX_TEXTROW(image->array.F, PRINTPIX_FMT_FLOAT);
+                break;
+            case _DATATYPE_DOUBLE:
+                PRINTPIX_TEXTROW(image->array.D, PRINTPIX_FMT_FLOAT);
+                break;
+            case _DATATYPE_UINT8:
+                PRINTPIX_TEXTROW(image->array.UI8, PRINTPIX_FMT_UINT);
+                break;
+            case _DATATYPE_INT8:
+                PRINTPIX_TEXTROW(image->array.SI8, PRINTPIX_FMT_INT);
+                break;
+            case _DATATYPE_UINT16:
+                PRINTPIX_TEXTROW(image->array.UI16, PRINTPIX_FMT_UINT);
+                break;
+            case _DATATYPE_INT16:
+                PRINTPIX_TEXTROW(image->array.SI16, PRINTPIX_FMT_INT);
+                break;
+            case _DATATYPE_UINT32:
+                PRINTPIX_TEXTROW(image->array.UI32, PRINTPIX_FMT_UINT);
+                break;
+            case _DATATYPE_INT32:
+                PRINTPIX_TEXTROW(image->array.SI32, PRINTPIX_FMT_INT);
+                break;
+            case _DATATYPE_UINT64:
+                PRINTPIX_TEXTROW(image->array.UI64, PRINTPIX_FMT_UINT);
+                break;
+            case _DATATYPE_INT64:
+                PRINTPIX_TEXTROW(image->array.SI64, PRINTPIX_FMT_INT);
+                break;
+            default:
+                atomic_store(&job->ret, RETURN_FAILURE);
+                break;
+        }
+        if(naxis < 3)
+        {
+            *p++ = '\n';
+        }
+    }
+
+    job->buflen[task] = p - buf;
+}
+
+/**
+ * @brief Export pixel values of region to file descriptor
+ *
+ * Region starts at (x0, y0), and has size xsize x ysize before striding.
+ * A size of 0 extends the region to the image edge.
+ * precision is the number of significant digits for floating point values
+ * in text mode, 0 for default.
+ */
+errno_t image_export_fd(IMAGE   *image,
+                        int      fd,
+                        int      mode,
+                        uint32_t x0,
+                        uint32_t y0,
+                        uint32_t xsize,
+                        uint32_t ysize,
+                        uint32_t xstep,
+                        uint32_t ystep,
+                        int      precision)
+{
+    INFO_INSTR_SCOPE("image_export_fd");
+
+    int      naxis    = image->md[0].naxis;
+    uint32_t xsizeim  = image->md[0].size[0];
+    uint32_t ysizeim  = (naxis < 2) ? 1 : image->md[0].size[1];
+    uint32_t nslice   = (naxis < 3) ? 1 : image->md[0].size[2];
+    uint8_t  datatype = image->md[0].datatype;
+    int      typesize = ImageStreamIO_typesize(datatype);
+    errno_t  ret      = RETURN_SUCCESS;
+
+    if((x0 >= xsizeim) || (y0 >= ysizeim))
+    {
+        PRINT_ERROR("region origin outside image %s", image->name);
+        return RETURN_FAILURE;
+    }
+    // 64-bit sums : x0 + xsize may not fit in uint32
+    if((xsize == 0) || ((uint64_t) x0 + xsize > xsizeim))
+    {
+        xsize = xsizeim - x0;
+    }
+    if((ysize == 0) || ((uint64_t) y0 + ysize > ysizeim))
+    {
+        ysize = ysizeim - y0;
+    }
+    if(xstep < 1)
+    {
+        xstep = 1;
+    }
+    if(ystep < 1)
+    {
+        ystep = 1;
+    }
+    if((precision < 1) || (precision > 15))
+    {
+        precision = PRINTPIX_PRECISION;
+    }
+
+    if(printpix_pow10_init == 0)
+    {
+        for(int k = -PRINTPIX_POW10OFFSET; k <= PRINTPIX_POW10OFFSET; k++)
+        {
+            printpix_pow10[k + PRINTPIX_POW10OFFSET] = pow(10.0, k);
+        }
+        printpix_pow10_init = 1;
+    }
+
+    uint32_t nxout = ((uint64_t) xsize + xstep - 1) / xstep;
+    uint32_t nyout = ((uint64_t) ysize + ystep - 1) / ystep;
+    long     nrow  = (long) nyout * nslice;
+
+    if(mode == PRINTPIX_MODE_BINARY)
+    {
+        char *base = (char *) image->array.raw;
+
+        if(xstep == 1)
+        {
+            // zero copy, consecutive rows merged into one segment
+            struct iovec iov[IOV_MAX];
+            int          iovcnt = 0;
+            size_t       rowlen = (size_t) nxout * typesize;
+
+            for(long r = 0; (r < nrow) && (ret == RETURN_SUCCESS); r++)
+            {
+                uint64_t kk  = r / nyout;
+                uint64_t jj  = y0 + (r % nyout) * ystep;
+                char    *ptr = base + ((kk * ysizeim + jj) * xsizeim + x0) *
+                               typesize;
+
+                if((iovcnt > 0) &&
+                        ((char *) iov[iovcnt - 1].iov_base +
+                         iov[iovcnt - 1].iov_len ==
+                         ptr))
+                {
+                    iov[iovcnt - 1].iov_len += rowlen;
+                    continue;
+                }
+                if(iovcnt == IOV_MAX)
+                {
+                    ret    = printpix_writev_all(fd, iov, iovcnt);
+                    iovcnt = 0;
+                }
+                iov[iovcnt].iov_base = ptr;
+                iov[iovcnt].iov_len  = rowlen;
+                iovcnt++;
+            }
+            if((ret == RETURN_SUCCESS) && (iovcnt > 0))
+            {
+                ret = printpix_writev_all(fd, iov, iovcnt);
+            }
+        }
+        else
+        {
+            // gather strided pixels, one row at a time
+            size_t scratchmark = info_scratch_mark();
+            char  *buf =
+                (char *) info_scratch_alloc((size_t) nxout * typesize);
+            for(long r = 0; (r < nrow) && (ret == RETURN_SUCCESS); r++)
+            {
+                uint64_t kk  = r / nyout;
+                uint64_t jj  = y0 + (r % nyout) * ystep;
+                char    *ptr = base + ((kk * ysizeim + jj) * xsizeim + x0) *
+                               typesize;
+                for(uint32_t i = 0; i < nxout; i++)
+                {
+                    memcpy(buf + (size_t) i * typesize,
+                           ptr + (size_t) i * xstep * typesize,
+                           typesize);
+                }
+                ret = printpix_write_all(fd, buf, (size_t) nxout * typesize);
+            }
+            info_scratch_release(scratchmark);
+        }
+    }
+    else
+    {
+        long rowsperblock =
+            PRINTPIX_TEXTBLOCKSIZE / ((long) nxout * PRINTPIX_LINEMAX + 1);
+        if(rowsperblock < 1)
+        {
+            rowsperblock = 1;
+        }
+        long   nblock  = (nrow + rowsperblock - 1) / rowsperblock;
+        size_t bufsize = rowsperblock * ((size_t) nxout * PRINTPIX_LINEMAX + 1);
+
+        // x coordinate labels "ii ", shared by all rows
+        size_t scratchmark = info_scratch_mark();
+        char  *xlabel =
+            (char *) info_scratch_alloc((size_t) nxout * PRINTPIX_LABELSIZE);
+        for(uint32_t i = 0; i < nxout; i++)
+        {
+            char *xlab = xlabel + (size_t) i * PRINTPIX_LABELSIZE;
+            char *pend = printpix_utoa(xlab, x0 + (uint64_t) i * xstep);
+            *pend++    = ' ';
+            xlab[PRINTPIX_LABELSIZE - 1] = (char)(pend - xlab);
+        }
+
+        PRINTPIX_TEXT_JOB job;
+        int               nbtask = (nblock > 1) ? info_pool_nbthread() : 1;
+
+        job.image        = image;
+        job.x0           = x0;
+        job.y0           = y0;
+        job.xstep        = xstep;
+        job.ystep        = ystep;
+        job.nxout        = nxout;
+        job.nyout        = nyout;
+        job.nrow         = nrow;
+        job.precision    = precision;
+        job.xlabel       = xlabel;
+        job.rowsperblock = rowsperblock;
+        job.bufsize      = bufsize;
+        job.buf          = (char *) info_scratch_alloc(bufsize * nbtask);
+        job.buflen       = (size_t *) info_scratch_alloc(sizeof(size_t) *
+                           nbtask);
+        atomic_init(&job.ret, RETURN_SUCCESS);
+
+        for(job.block0 = 0; (job.block0 < nblock) && (ret == RETURN_SUCCESS);
+                job.block0 += nbtask)
+        {
+            int nbtaskround = (nblock - job.block0 < nbtask)
+                              ? (int)(nblock - job.block0)
+                              : nbtask;
+
+            info_pool_run(nbtaskround, printpix_text_task, &job);
+            ret = atomic_load(&job.ret);
+
+            for(int task = 0; (task < nbtaskround) && (ret == RETURN_SUCCESS);
+                    task++)
+            {
+                ret = printpix_write_all(fd,
+                                         job.buf + task * bufsize,
+                                         job.buflen[task]);
+            }
+        }
+
+        info_scratch_release(scratchmark);
+    }
+
+    if(ret != RETURN_SUCCESS)
+    {
+        PRINT_ERROR("export of image %s failed", image->name);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Export pixel values of region to file
+ *
+ * modestr is "bin" for binary, anything else for text.
+ * filename "-" writes to stdout.
+ */
+errno_t image_export(const char *ID_name,
+                     const char *filename,
+                     const char *modestr,
+                     uint32_t    x0,
+                     uint32_t    y0,
+                     uint32_t    xsize,
+                     uint32_t    ysize,
+                     uint32_t    xstep,
+                     uint32_t    ystep)
+{
+    imageID ID   = image_ID(ID_name);
+    int     mode = PRINTPIX_MODE_TEXT;
+    int     fd   = STDOUT_FILENO;
+
+    if(ID == -1)
+    {
+        PRINT_ERROR("image %s not found", ID_name);
+        return RETURN_FAILURE;
+    }
+
+    if(strcmp(modestr, "bin") == 0)
+    {
+        mode = PRINTPIX_MODE_BINARY;
+    }
+
+    if(strcmp(filename, "-") != 0)
+    {
+        fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd == -1)
+        {
+            PRINT_ERROR("cannot open file \"%s\"", filename);
+            return RETURN_FAILURE;
+        }
+    }
+
+    errno_t ret = image_export_fd(&data.image[ID],
+                                  fd,
+                                  mode,
+                                  x0,
+                                  y0,
+                                  xsize,
+                                  ysize,
+                                  xstep,
+                                  ystep,
+                                  0);
+
+    if(fd != STDOUT_FILENO)
+    {
+        close(fd);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Print pixel values to text file
+ *
+ * Strides are read from variables _iistep and _jjstep if they exist.
+ */
+errno_t printpix(const char *ID_name, const char *filename)
+{
+    long       iistep = 1;
+    long       jjstep = 1;
+    variableID IDv;
+
+    IDv = variable_ID("_iistep");
+    if(IDv != -1)
+    {
+        iistep = (long)(0.1 + data.variable[IDv].value.f);
+        printf("iistep = %ld\n", iistep);
+    }
+    IDv = variable_ID("_jjstep");
+    if(IDv != -1)
+    {
+        jjstep = (long)(0.1 + data.variable[IDv].value.f);
+        printf("jjstep = %ld\n", jjstep);
+    }
+
+    return image_export(ID_name, filename, "txt", 0, 0, 0, 0, iistep, jjstep);
+}
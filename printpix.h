@@ -0,0 +1,36 @@
+/**
+ * @file    printpix.h
+ */
+
+#ifndef _INFO_PRINTPIX_H
+#define _INFO_PRINTPIX_H
+
+#define PRINTPIX_MODE_TEXT   0 // lines "ii jj [kk] value"
+#define PRINTPIX_MODE_BINARY 1 // raw pixel values, native datatype
+
+errno_t image_export_fd(IMAGE   *image,
+                        int      fd,
+                        int      mode,
+                        uint32_t x0,
+                        uint32_t y0,
+                        uint32_t xsize,
+                        uint32_t ysize,
+                        uint32_t xstep,
+                        uint32_t ystep,
+                        int      precision);
+
+errno_t image_export(const char *ID_name,
+                     const char *filename,
+                     const char *modestr,
+                     uint32_t    x0,
+                     uint32_t    y0,
+                     uint32_t    xsize,
+                     uint32_t    ysize,
+                     uint32_t    xstep,
+                     uint32_t    ystep);
+
+errno_t printpix(const char *ID_name, const char *filename);
+
+errno_t printpix_addCLIcmd();
+
+#endif
@@ -0,0 +1,194 @@
+/**
+ * @file    profile2im_stream.c
+ * @brief   2D model image from radial profile stream
+ *
+ * Builds a size x size image from the radial profile held in row .row of
+ * the input stream, each time the input stream is updated. The default row
+ * -1 selects the mean row of an improfstream output, otherwise row 0.
+ */
+
+#include <math.h>
+
+#include "CommandLineInterface/CLIcore.h"
+
+#include "COREMOD_memory/COREMOD_memory.h"
+
+#include "improfile.h"
+
+// Local variables pointers
+static char     *inprofname;
+static int64_t  *profrow;
+static char     *outstreamname;
+static uint32_t *imsize;
+static double   *xcenter;
+static double   *ycenter;
+static double   *radius;
+
+static CLICMDARGDEF farg[] =
+{
+    {
+        CLIARG_IMG,
+        ".inprofname",
+        "input profile stream",
+        "prof",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &inprofname,
+        NULL
+    },
+    {
+        CLIARG_INT64,
+        ".row",
+        "profile row, -1 for improfstream mean",
+        "-1",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &profrow,
+        NULL
+    },
+    {
+        CLIARG_STR,
+        ".outsname",
+        "output image stream",
+        "profim",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &outstreamname,
+        NULL
+    },
+    {
+        CLIARG_UINT32,
+        ".size",
+        "output image size [pix]",
+        "128",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &imsize,
+        NULL
+    },
+    {
+        CLIARG_FLOAT64,
+        ".xcenter",
+        "center x coordinate [pix]",
+        "64.0",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &xcenter,
+        NULL
+    },
+    {
+        CLIARG_FLOAT64,
+        ".ycenter",
+        "center y coordinate [pix]",
+        "64.0",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &ycenter,
+        NULL
+    },
+    {
+        CLIARG_FLOAT64,
+        ".radius",
+        "radius of last profile point [pix]",
+        "64.0",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &radius,
+        NULL
+    }
+};
+
+static CLICMDDATA CLIcmddata =
+{
+    "profile2imstream", "2D image from radial profile stream",
+    CLICMD_FIELDS_DEFAULTS
+};
+
+// detailed help
+static errno_t help_function()
+{
+    printf("Build 2D image from radial profile stream\n");
+    printf("Profile is row .row of input stream\n");
+    printf("Default -1 : mean row (1) of improfstream output, else row 0\n");
+    printf("Profile point i is at distance i * radius / nbpoints\n");
+
+    return RETURN_SUCCESS;
+}
+
+static errno_t compute_function()
+{
+    DEBUG_TRACE_FSTART();
+
+    imageID IDprof   = image_ID(inprofname);
+    long    nbpoints = data.image[IDprof].md[0].size[0];
+    long    nbrow    = (data.image[IDprof].md[0].naxis > 1)
+                       ? data.image[IDprof].md[0].size[1] : 1;
+
+    // profile row fixed at startup
+    long row = *profrow;
+    if(row < 0)
+    {
+        row = (nbrow == IMPROFSTREAM_NBROW) ? IMPROFSTREAM_ROWMEAN : 0;
+    }
+    if(row >= nbrow)
+    {
+        PRINT_ERROR("profile row %ld out of range, %s has %ld rows",
+                    row,
+                    inprofname,
+                    nbrow);
+        DEBUG_TRACE_FEXIT();
+        return RETURN_FAILURE;
+    }
+
+    // output size fixed at startup
+    long IMsize = *imsize;
+
+    imageID  IDout;
+    uint32_t sizeout[2];
+    sizeout[0] = IMsize;
+    sizeout[1] = IMsize;
+    create_image_ID(outstreamname,
+                    2,
+                    sizeout,
+                    _DATATYPE_FLOAT,
+                    1,
+                    0,
+                    0,
+                    &IDout);
+
+    double *profile_array = (double *) malloc(sizeof(double) * nbpoints);
+    if(profile_array == NULL)
+    {
+        PRINT_ERROR("malloc returns NULL pointer");
+        abort();
+    }
+
+    INSERT_STD_PROCINFO_COMPUTEFUNC_INIT
+
+    INSERT_STD_PROCINFO_COMPUTEFUNC_LOOPSTART
+    {
+        profile2im_readimage(&data.image[IDprof],
+                             row,
+                             profile_array,
+                             nbpoints);
+
+        data.image[IDout].md[0].write = 1;
+        profile2im_array(profile_array,
+                         nbpoints,
+                         IMsize,
+                         *xcenter,
+                         *ycenter,
+                         *radius,
+                         data.image[IDout].array.F);
+        processinfo_update_output_stream(processinfo, IDout);
+    }
+    INSERT_STD_PROCINFO_COMPUTEFUNC_END
+
+    free(profile_array);
+
+    DEBUG_TRACE_FEXIT();
+    return RETURN_SUCCESS;
+}
+
+INSERT_STD_FPSCLIfunctions
+
+// Register function in CLI
+errno_t CLIADDCMD_info__profile2im_stream()
+{
+    INSERT_STD_CLIREGISTERFUNC
+
+    return RETURN_SUCCESS;
+}
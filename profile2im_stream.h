@@ -0,0 +1,10 @@
+/**
+ * @file    profile2im_stream.h
+ */
+
+#ifndef _INFO_PROFILE2IM_STREAM_H
+#define _INFO_PROFILE2IM_STREAM_H
+
+errno_t CLIADDCMD_info__profile2im_stream();
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * @file    streamhealth.c
+ * @brief   stream health sample : rate, semaphores, circular buffer, stats
+ *
+ * A sample is a flat array of doubles : STREAMHEALTH_NBFIELD fields, then
+ * STREAMHEALTH_SEMFIELD values per semaphore. It is what the image monitor
+ * shows on its summary screen, in a form that can be written to a stream
+ * and read by supervisors without a terminal.
+ *
+ * Metadata fields are read from shared memory without locking : a sample
+ * taken while the writer updates the stream may mix values of two frames.
+ * Pixel statistics are computed on a consistent frame (imsnapshot.c).
+ */
+
+#include <math.h>
+#include <semaphore.h>
+
+#include "info_core.h"
+
+#include "imstats.h"
+#include "info_instr.h"
+#include "streamhealth.h"
+
+/**
+ * @brief Number of values in a health sample of image
+ */
+long streamhealth_size(IMAGE *image)
+{
+    return STREAMHEALTH_NBFIELD + STREAMHEALTH_SEMFIELD * image->md[0].sem;
+}
+
+static errno_t streamhealth_imstats(IMAGE *image, void *arg)
+{
+    return imstats_compute(image, (IMSTATS *) arg);
+}
+
+/**
+ * @brief Health sample of image into health[streamhealth_size(image)]
+ *
+ * Pixel statistics are only computed if stats is 1 (one read of the
+ * frame). Frame rate and intervals are measured from writer timestamps
+ * (streamrate.c), NaN on the first sample of state unless the stream has a
+ * circular buffer. state must be zero-initialized.
+ */
+errno_t streamhealth_sample(IMAGE              *image,
+                            STREAMHEALTH_STATE *state,
+                            int                 stats,
+                            double             *health)
+{
+    INFO_INSTR_SCOPE("streamhealth_sample");
+
+    IMAGE_METADATA *md = image->md;
+    struct timespec treal;
+    STREAMRATE      rate;
+    int             semval;
+    int             semmax   = 0;
+    int             nbwriter = 0;
+    int             nbreader = 0;
+
+    clock_gettime(CLOCK_REALTIME, &treal);
+    streamrate_measure(image, &state->rate, &rate);
+
+    health[STREAMHEALTH_TIME]  = treal.tv_sec + 1.0e-9 * treal.tv_nsec;
+    health[STREAMHEALTH_CNT0]  = (double) md[0].cnt0;
+    health[STREAMHEALTH_CNT1]  = (double) md[0].cnt1;
+    health[STREAMHEALTH_FREQU] = rate.frequ;
+    health[STREAMHEALTH_DTMIN] = rate.dtmin;
+    health[STREAMHEALTH_DTMAX] = rate.dtmax;
+
+    health[STREAMHEALTH_WRITE]  = md[0].write;
+    health[STREAMHEALTH_STATUS] = md[0].status;
+    health[STREAMHEALTH_NBSEM]  = md[0].sem;
+
+    double *semhealth = health + STREAMHEALTH_NBFIELD;
+    for(int s = 0; s < md[0].sem; s++)
+    {
+        sem_getvalue(image->semptr[s], &semval);
+        semmax = (semval > semmax) ? semval : semmax;
+        nbwriter += (image->semWritePID[s] > 0);
+        nbreader += (image->semReadPID[s] > 0);
+
+        semhealth[STREAMHEALTH_SEMFIELD * s]     = semval;
+        semhealth[STREAMHEALTH_SEMFIELD * s + 1] = image->semWritePID[s];
+        semhealth[STREAMHEALTH_SEMFIELD * s + 2] = image->semReadPID[s];
+    }
+    health[STREAMHEALTH_SEMMAX] = semmax;
+
+    semval = 0;
+    if(image->semlog != NULL)
+    {
+        sem_getvalue(image->semlog, &semval);
+    }
+    health[STREAMHEALTH_SEMLOG]   = semval;
+    health[STREAMHEALTH_CBINDEX]  = md[0].CBindex;
+    health[STREAMHEALTH_CBSIZE]   = md[0].CBsize;
+    health[STREAMHEALTH_CBCYCLE]  = (double) md[0].CBcycle;
+    health[STREAMHEALTH_NBWRITER] = nbwriter;
+    health[STREAMHEALTH_NBREADER] = nbreader;
+
+    health[STREAMHEALTH_MIN]   = NAN;
+    health[STREAMHEALTH_MAX]   = NAN;
+    health[STREAMHEALTH_MEAN]  = NAN;
+    health[STREAMHEALTH_RMS]   = NAN;
+    health[STREAMHEALTH_NBNAN] = NAN;
+    if(stats == 1)
+    {
+        IMSTATS imstats;
+
+        if(imsnapshot_run(&state->snap,
+                          image,
+                          streamhealth_imstats,
+                          &imstats) == RETURN_SUCCESS)
+        {
+            health[STREAMHEALTH_MIN]   = imstats.min;
+            health[STREAMHEALTH_MAX]   = imstats.max;
+            health[STREAMHEALTH_MEAN]  = imstats.mean;
+            health[STREAMHEALTH_RMS]   = imstats.rmsdev;
+            health[STREAMHEALTH_NBNAN] = (double) imstats.nbnan;
+        }
+    }
+    health[STREAMHEALTH_NBTORN] = (double) state->snap.nbtorn;
+
+    return RETURN_SUCCESS;
+}
+
+void streamhealth_free(STREAMHEALTH_STATE *state)
+{
+    imsnapshot_free(&state->snap);
+}
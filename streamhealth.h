@@ -0,0 +1,61 @@
+/**
+ * @file    streamhealth.h
+ * @brief   stream health sample : rate, semaphores, circular buffer, stats
+ */
+
+#ifndef _INFO_STREAMHEALTH_H
+#define _INFO_STREAMHEALTH_H
+
+#include <time.h>
+
+#include "imsnapshot.h"
+#include "streamrate.h"
+
+// fields of a health sample, in this order in the output stream
+enum
+{
+    STREAMHEALTH_TIME = 0, // sample time, CLOCK_REALTIME [s]
+    STREAMHEALTH_CNT0,
+    STREAMHEALTH_CNT1,
+    STREAMHEALTH_FREQU, // frame rate since previous sample [Hz]
+    STREAMHEALTH_DTMIN, // inter-frame interval since previous sample [s]
+    STREAMHEALTH_DTMAX,
+    STREAMHEALTH_WRITE,
+    STREAMHEALTH_STATUS,
+    STREAMHEALTH_NBSEM,
+    STREAMHEALTH_SEMMAX, // largest semaphore value : unread frames
+    STREAMHEALTH_SEMLOG,
+    STREAMHEALTH_CBINDEX,
+    STREAMHEALTH_CBSIZE,
+    STREAMHEALTH_CBCYCLE,
+    STREAMHEALTH_NBWRITER, // semaphores with a writer PID
+    STREAMHEALTH_NBREADER, // semaphores with a reader PID
+    STREAMHEALTH_MIN,      // pixel statistics, NaN if not computed
+    STREAMHEALTH_MAX,
+    STREAMHEALTH_MEAN,
+    STREAMHEALTH_RMS,
+    STREAMHEALTH_NBNAN,
+    STREAMHEALTH_NBTORN, // statistics on inconsistent frames, since start
+    STREAMHEALTH_NBFIELD
+};
+
+// followed by value, writer PID and reader PID of each semaphore
+#define STREAMHEALTH_SEMFIELD 3
+
+// state kept between samples of a stream, release with streamhealth_free()
+typedef struct
+{
+    STREAMRATE_STATE rate;
+    IMSNAPSHOT       snap;
+} STREAMHEALTH_STATE;
+
+long streamhealth_size(IMAGE *image);
+
+errno_t streamhealth_sample(IMAGE              *image,
+                            STREAMHEALTH_STATE *state,
+                            int                 stats,
+                            double             *health);
+
+void streamhealth_free(STREAMHEALTH_STATE *state);
+
+#endif
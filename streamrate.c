@@ -0,0 +1,186 @@
+/**
+ * @file    streamrate.c
+ * @brief   frame rate and inter-frame intervals from writer timestamps
+ *
+ * Rates are measured between write times of frames, not between reader
+ * samples : the result does not depend on when the monitor wakes up.
+ *
+ * With a circular buffer, the write time of each slot is read from the
+ * timestamp array, giving every inter-frame interval since the previous
+ * measurement (up to CBsize frames). Without one, only the write time of
+ * the last frame is known : the mean interval is measured, and individual
+ * intervals only when a single frame was written. If the writer sets no
+ * timestamp, the reader clock is used.
+ */
+
+#include <math.h>
+
+#include "info_core.h"
+
+#include "info_instr.h"
+#include "streamrate.h"
+
+static double streamrate_tdiff(struct timespec t0, struct timespec t1)
+{
+    return (t1.tv_sec - t0.tv_sec) + 1.0e-9 * (t1.tv_nsec - t0.tv_nsec);
+}
+
+static void streamrate_adddt(STREAMRATE *rate, double dt)
+{
+    rate->dtmin = (rate->nbdt == 0 || dt < rate->dtmin) ? dt : rate->dtmin;
+    rate->dtmax = (rate->nbdt == 0 || dt > rate->dtmax) ? dt : rate->dtmax;
+    rate->nbdt++;
+}
+
+// walk back circular buffer slots from newest frame
+static void streamrate_measure_cb(IMAGE            *image,
+                                  STREAMRATE_STATE *state,
+                                  STREAMRATE       *rate)
+{
+    uint32_t         CBsize = image->md[0].CBsize;
+    uint64_t        *cnt    = image->cntarray;
+    struct timespec *twrite = image->writetimearray;
+    uint64_t         cnt0   = image->md[0].cnt0;
+    uint32_t         knew   = 0;
+
+    // newest slot, independent of CBindex update order
+    for(uint32_t k = 1; k < CBsize; k++)
+    {
+        if((cnt[k] <= cnt0) && (cnt[k] > cnt[knew]))
+        {
+            knew = k;
+        }
+    }
+    uint64_t        cntnew = cnt[knew];
+    struct timespec tnew   = twrite[knew];
+
+    if(cntnew < state->cnt0)
+    {
+        // stream recreated
+        state->init = 0;
+    }
+
+    uint32_t k = knew;
+    for(uint32_t n = 1; n < CBsize; n++)
+    {
+        uint32_t kprev = (k == 0) ? CBsize - 1 : k - 1;
+
+        if((cnt[kprev] + 1 != cnt[k]) ||
+                ((state->init == 1) && (cnt[kprev] < state->cnt0)))
+        {
+            break;
+        }
+        streamrate_adddt(rate, streamrate_tdiff(twrite[kprev], twrite[k]));
+        k = kprev;
+    }
+    if((state->init == 1) && (cnt[k] == state->cnt0 + 1))
+    {
+        // interval from last frame of previous measurement
+        streamrate_adddt(rate, streamrate_tdiff(state->t, twrite[k]));
+    }
+
+    double span = NAN;
+    if(state->init == 1)
+    {
+        rate->nbframe = cntnew - state->cnt0;
+        span          = streamrate_tdiff(state->t, tnew);
+    }
+    else if(rate->nbdt > 0)
+    {
+        rate->nbframe = rate->nbdt;
+        span          = streamrate_tdiff(twrite[k], tnew);
+    }
+    rate->frequ  = (rate->nbframe == 0) ? 0.0 : rate->nbframe / span;
+    rate->dtmean = (rate->nbframe == 0) ? NAN : span / rate->nbframe;
+    if(isnan(span))
+    {
+        rate->frequ = NAN;
+    }
+
+    state->cnt0 = cntnew;
+    state->t    = tnew;
+    state->init = 1;
+}
+
+/**
+ * @brief Frame rate and intervals of image since previous measurement
+ *
+ * The first measurement of state, which must be zero-initialized, only
+ * returns rates if the circular buffer holds several frames.
+ */
+errno_t streamrate_measure(IMAGE            *image,
+                           STREAMRATE_STATE *state,
+                           STREAMRATE       *rate)
+{
+    INFO_INSTR_SCOPE("streamrate_measure");
+
+    IMAGE_METADATA *md = image->md;
+
+    rate->source  = STREAMRATE_SRC_NONE;
+    rate->nbframe = 0;
+    rate->nbdt    = 0;
+    rate->frequ   = NAN;
+    rate->dtmin   = NAN;
+    rate->dtmax   = NAN;
+    rate->dtmean  = NAN;
+
+    if((md[0].CBsize > 1) && (image->cntarray != NULL) &&
+            (image->writetimearray != NULL))
+    {
+        rate->source = STREAMRATE_SRC_CB;
+        streamrate_measure_cb(image, state, rate);
+        return RETURN_SUCCESS;
+    }
+
+    // frame counter and write time of the same frame
+    uint64_t        cnt0;
+    struct timespec tnew;
+    for(int i = 0; i < 4; i++)
+    {
+        cnt0 = md[0].cnt0;
+        tnew = md[0].writetime;
+        if(md[0].cnt0 == cnt0)
+        {
+            break;
+        }
+    }
+
+    int source = STREAMRATE_SRC_WRITETIME;
+    if(tnew.tv_sec == 0)
+    {
+        source = STREAMRATE_SRC_CLOCK;
+        clock_gettime(CLOCK_REALTIME, &tnew);
+    }
+
+    if((state->init == 1) && (cnt0 >= state->cnt0))
+    {
+        double span = streamrate_tdiff(state->t, tnew);
+
+        rate->source  = source;
+        rate->nbframe = cnt0 - state->cnt0;
+        if(rate->nbframe > 0)
+        {
+            rate->frequ  = rate->nbframe / span;
+            rate->dtmean = span / rate->nbframe;
+            if((rate->nbframe == 1) && (source == STREAMRATE_SRC_WRITETIME))
+            {
+                streamrate_adddt(rate, span);
+            }
+        }
+        else
+        {
+            rate->frequ = 0.0;
+        }
+    }
+
+    // writer timestamp only moves with cnt0
+    if((source == STREAMRATE_SRC_CLOCK) || (state->init == 0) ||
+            (cnt0 != state->cnt0))
+    {
+        state->cnt0 = cnt0;
+        state->t    = tnew;
+    }
+    state->init = 1;
+
+    return RETURN_SUCCESS;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file    streamrate.h
+ * @brief   frame rate and inter-frame intervals from writer timestamps
+ */
+
+#ifndef _INFO_STREAMRATE_H
+#define _INFO_STREAMRATE_H
+
+#include <time.h>
+
+// timestamps used by a measurement
+enum
+{
+    STREAMRATE_SRC_NONE = 0, // first measurement
+    STREAMRATE_SRC_CB,        // circular buffer timestamp array
+    STREAMRATE_SRC_WRITETIME, // writer timestamp of last frame
+    STREAMRATE_SRC_CLOCK      // reader clock, writer sets no timestamp
+};
+
+// state kept between measurements of a stream, zero-initialized
+typedef struct
+{
+    uint64_t        cnt0;  // last frame seen
+    struct timespec t;     // its write time, or reader time
+    int             init;
+} STREAMRATE_STATE;
+
+typedef struct
+{
+    int      source;
+    uint64_t nbframe; // frames written since previous measurement
+    long     nbdt;    // inter-frame intervals measured
+    double   frequ;   // [Hz]
+    double   dtmin;   // inter-frame interval [s], NaN if nbdt = 0
+    double   dtmax;
+    double   dtmean;
+} STREAMRATE;
+
+errno_t streamrate_measure(IMAGE            *image,
+                           STREAMRATE_STATE *state,
+                           STREAMRATE       *rate);
+
+#endif
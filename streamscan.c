@@ -0,0 +1,357 @@
+/**
+ * @file    streamscan.c
+ * @brief   metadata-only scan of all streams of a shared memory directory
+ *
+ * Each stream file is mapped read-only over its metadata only : scanning a
+ * directory of many large streams neither maps nor touches pixel data. The
+ * mapping is kept across scans, and replaced if the file is recreated.
+ *
+ * Frame rate and bandwidth are cnt0 increments between two scans. Semaphore
+ * backlog is read from the named semaphores of the stream when they exist,
+ * and is -1 otherwise. Staleness is the time since the writer timestamp, or
+ * since the last cnt0 change seen by the scan if the writer sets none.
+ */
+
+#include <fcntl.h>
+#include <glob.h>
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "info_core.h"
+
+#include "info_instr.h"
+#include "streamscan.h"
+
+// shared memory file name suffix of streams
+#define STREAMSCAN_SHMSUFFIX ".im.shm"
+
+static uint64_t streamscan_now(clockid_t clk)
+{
+    struct timespec t;
+
+    clock_gettime(clk, &t);
+    return (uint64_t) t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static void streamscan_unmap(STREAMSCAN_ENTRY *entry)
+{
+    for(int s = 0; s < entry->nbsem; s++)
+    {
+        sem_close(entry->semptr[s]);
+    }
+    entry->nbsem = 0;
+    if(entry->md != NULL)
+    {
+        munmap(entry->md, sizeof(IMAGE_METADATA));
+        entry->md = NULL;
+    }
+}
+
+// map metadata of stream file fname, zero on success
+static int streamscan_map(STREAMSCAN_ENTRY *entry,
+                          const char       *fname,
+                          struct stat      *st)
+{
+    if(st->st_size < (off_t) sizeof(IMAGE_METADATA))
+    {
+        return 1;
+    }
+
+    int fd = open(fname, O_RDONLY);
+    if(fd == -1)
+    {
+        return 1;
+    }
+    void *map =
+        mmap(NULL, sizeof(IMAGE_METADATA), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED)
+    {
+        return 1;
+    }
+
+    entry->md        = (IMAGE_METADATA *) map;
+    entry->dev       = st->st_dev;
+    entry->ino       = st->st_ino;
+    entry->framesize = entry->md->nelement *
+                       ImageStreamIO_typesize(entry->md->datatype);
+    entry->cnt0      = entry->md->cnt0;
+    entry->tsample   = streamscan_now(CLOCK_MONOTONIC);
+    entry->tcnt0     = entry->tsample;
+    entry->frequ     = NAN;
+    entry->bandwidth = NAN;
+    entry->backlog   = -1;
+    entry->stale     = NAN;
+
+    // named semaphores, opened without creating them
+    entry->nbsem = 0;
+    for(int s = 0; (s < entry->md->sem) && (s < IMAGE_NB_SEMAPHORE); s++)
+    {
+        char   sname[STRINGMAXLEN_IMAGE_NAME + 8];
+        sem_t *semptr;
+
+        snprintf(sname, sizeof(sname), "%s_sem%02d", entry->name, s);
+        semptr = sem_open(sname, 0);
+        if(semptr == SEM_FAILED)
+        {
+            break;
+        }
+        entry->semptr[entry->nbsem++] = semptr;
+    }
+
+    return 0;
+}
+
+static STREAMSCAN_ENTRY *streamscan_find(STREAMSCAN *scan, const char *name)
+{
+    for(long i = 0; i < scan->nbentry; i++)
+    {
+        if(strcmp(scan->entry[i].name, name) == 0)
+        {
+            return &scan->entry[i];
+        }
+    }
+    return NULL;
+}
+
+static STREAMSCAN_ENTRY *streamscan_add(STREAMSCAN *scan, const char *name)
+{
+    scan->entry = (STREAMSCAN_ENTRY *) realloc(
+                      scan->entry,
+                      sizeof(STREAMSCAN_ENTRY) * (scan->nbentry + 1));
+    if(scan->entry == NULL)
+    {
+        PRINT_ERROR("realloc returns NULL pointer");
+        abort();
+    }
+
+    STREAMSCAN_ENTRY *entry = &scan->entry[scan->nbentry++];
+    memset(entry, 0, sizeof(STREAMSCAN_ENTRY));
+    strncpy(entry->name, name, STRINGMAXLEN_IMAGE_NAME - 1);
+
+    return entry;
+}
+
+static void streamscan_sample(STREAMSCAN_ENTRY *entry)
+{
+    IMAGE_METADATA *md   = entry->md;
+    uint64_t        tnow = streamscan_now(CLOCK_MONOTONIC);
+    uint64_t        cnt0 = md->cnt0;
+    double          dt   = 1.0e-9 * (tnow - entry->tsample);
+    int             semval;
+
+    entry->frequ = NAN;
+    if((dt > 0.0) && (cnt0 >= entry->cnt0))
+    {
+        entry->frequ = (cnt0 - entry->cnt0) / dt;
+    }
+    entry->bandwidth = entry->frequ * entry->framesize;
+    if(cnt0 != entry->cnt0)
+    {
+        entry->tcnt0 = tnow;
+    }
+    entry->cnt0    = cnt0;
+    entry->tsample = tnow;
+
+    entry->backlog = (entry->nbsem > 0) ? 0 : -1;
+    for(int s = 0; s < entry->nbsem; s++)
+    {
+        sem_getvalue(entry->semptr[s], &semval);
+        entry->backlog = (semval > entry->backlog) ? semval : entry->backlog;
+    }
+
+    if(md->writetime.tv_sec > 0)
+    {
+        uint64_t twrite = (uint64_t) md->writetime.tv_sec * 1000000000 +
+                          md->writetime.tv_nsec;
+        uint64_t treal  = streamscan_now(CLOCK_REALTIME);
+
+        entry->stale = (treal > twrite) ? 1.0e-9 * (treal - twrite) : 0.0;
+    }
+    else
+    {
+        entry->stale = 1.0e-9 * (tnow - entry->tcnt0);
+    }
+}
+
+/**
+ * @brief Scan shmdir for streams matching pattern, sample each
+ *
+ * New streams are mapped, streams whose file was removed are dropped.
+ * Rates are NaN on the first scan of a stream. scan must be zero-initialized
+ * before the first call.
+ */
+errno_t streamscan_update(STREAMSCAN *scan,
+                          const char *shmdir,
+                          const char *pattern)
+{
+    INFO_INSTR_SCOPE("streamscan_update");
+
+    char   globpattern[PATH_MAX];
+    glob_t globbuf;
+
+    for(long i = 0; i < scan->nbentry; i++)
+    {
+        scan->entry[i].seen = 0;
+    }
+
+    snprintf(globpattern,
+             sizeof(globpattern),
+             "%s/%s%s",
+             shmdir,
+             pattern,
+             STREAMSCAN_SHMSUFFIX);
+    if(glob(globpattern, 0, NULL, &globbuf) == 0)
+    {
+        for(size_t k = 0; k < globbuf.gl_pathc; k++)
+        {
+            char        name[STRINGMAXLEN_IMAGE_NAME];
+            char       *fname = strrchr(globbuf.gl_pathv[k], '/');
+            struct stat st;
+
+            fname = (fname == NULL) ? globbuf.gl_pathv[k] : fname + 1;
+            snprintf(name,
+                     sizeof(name),
+                     "%.*s",
+                     (int)(strlen(fname) - strlen(STREAMSCAN_SHMSUFFIX)),
+                     fname);
+            if(stat(globbuf.gl_pathv[k], &st) != 0)
+            {
+                continue;
+            }
+
+            STREAMSCAN_ENTRY *entry = streamscan_find(scan, name);
+            if((entry != NULL) &&
+                    ((entry->dev != st.st_dev) || (entry->ino != st.st_ino)))
+            {
+                // stream recreated
+                streamscan_unmap(entry);
+            }
+            if(entry == NULL)
+            {
+                entry = streamscan_add(scan, name);
+            }
+
+            if(entry->md == NULL)
+            {
+                if(streamscan_map(entry, globbuf.gl_pathv[k], &st) == 0)
+                {
+                    entry->seen = 1;
+                }
+            }
+            else
+            {
+                streamscan_sample(entry);
+                entry->seen = 1;
+            }
+        }
+        globfree(&globbuf);
+    }
+
+    // drop streams not found
+    long nbentry = 0;
+    for(long i = 0; i < scan->nbentry; i++)
+    {
+        if(scan->entry[i].seen == 0)
+        {
+            streamscan_unmap(&scan->entry[i]);
+            continue;
+        }
+        if(nbentry != i)
+        {
+            scan->entry[nbentry] = scan->entry[i];
+        }
+        nbentry++;
+    }
+    scan->nbentry = nbentry;
+
+    return RETURN_SUCCESS;
+}
+
+// NaN values sort last
+static int streamscan_cmpdouble(double a, double b)
+{
+    if(isnan(a))
+    {
+        return isnan(b) ? 0 : 1;
+    }
+    if(isnan(b))
+    {
+        return -1;
+    }
+    return (a < b) - (a > b);
+}
+
+static int streamscan_cmp_name(const void *a, const void *b)
+{
+    return strcmp(((const STREAMSCAN_ENTRY *) a)->name,
+                  ((const STREAMSCAN_ENTRY *) b)->name);
+}
+
+static int streamscan_cmp_frequ(const void *a, const void *b)
+{
+    return streamscan_cmpdouble(((const STREAMSCAN_ENTRY *) a)->frequ,
+                                ((const STREAMSCAN_ENTRY *) b)->frequ);
+}
+
+static int streamscan_cmp_bandwidth(const void *a, const void *b)
+{
+    return streamscan_cmpdouble(((const STREAMSCAN_ENTRY *) a)->bandwidth,
+                                ((const STREAMSCAN_ENTRY *) b)->bandwidth);
+}
+
+static int streamscan_cmp_backlog(const void *a, const void *b)
+{
+    return ((const STREAMSCAN_ENTRY *) b)->backlog -
+           ((const STREAMSCAN_ENTRY *) a)->backlog;
+}
+
+static int streamscan_cmp_stale(const void *a, const void *b)
+{
+    return streamscan_cmpdouble(((const STREAMSCAN_ENTRY *) a)->stale,
+                                ((const STREAMSCAN_ENTRY *) b)->stale);
+}
+
+/**
+ * @brief Sort entries by name, or by decreasing value of sortkey
+ */
+void streamscan_sort(STREAMSCAN *scan, int sortkey)
+{
+    int (*cmp)(const void *, const void *);
+
+    switch(sortkey)
+    {
+    case STREAMSCAN_SORT_FREQU:
+        cmp = streamscan_cmp_frequ;
+        break;
+    case STREAMSCAN_SORT_BANDWIDTH:
+        cmp = streamscan_cmp_bandwidth;
+        break;
+    case STREAMSCAN_SORT_BACKLOG:
+        cmp = streamscan_cmp_backlog;
+        break;
+    case STREAMSCAN_SORT_STALE:
+        cmp = streamscan_cmp_stale;
+        break;
+    default:
+        cmp = streamscan_cmp_name;
+        break;
+    }
+    qsort(scan->entry, scan->nbentry, sizeof(STREAMSCAN_ENTRY), cmp);
+}
+
+void streamscan_free(STREAMSCAN *scan)
+{
+    for(long i = 0; i < scan->nbentry; i++)
+    {
+        streamscan_unmap(&scan->entry[i]);
+    }
+    free(scan->entry);
+    scan->entry   = NULL;
+    scan->nbentry = 0;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file    streamscan.h
+ * @brief   metadata-only scan of all streams of a shared memory directory
+ */
+
+#ifndef _INFO_STREAMSCAN_H
+#define _INFO_STREAMSCAN_H
+
+#include <semaphore.h>
+#include <sys/types.h>
+
+// sort keys, decreasing order except name
+enum
+{
+    STREAMSCAN_SORT_NAME = 0,
+    STREAMSCAN_SORT_FREQU,
+    STREAMSCAN_SORT_BANDWIDTH,
+    STREAMSCAN_SORT_BACKLOG,
+    STREAMSCAN_SORT_STALE
+};
+
+typedef struct
+{
+    char            name[STRINGMAXLEN_IMAGE_NAME];
+    dev_t           dev;
+    ino_t           ino;
+    IMAGE_METADATA *md; // read-only map of metadata, no pixel data
+    sem_t          *semptr[IMAGE_NB_SEMAPHORE];
+    int             nbsem; // semaphores opened
+
+    uint64_t cnt0;
+    uint64_t tsample; // CLOCK_MONOTONIC of previous sample [ns]
+    uint64_t tcnt0;   // CLOCK_MONOTONIC of last cnt0 change [ns]
+    uint64_t framesize; // [byte]
+    double   frequ;     // [Hz]
+    double   bandwidth; // [byte/s]
+    int      backlog;   // largest semaphore value, -1 if not available
+    double   stale;     // time since last write [s]
+    int      seen;      // found by last scan
+} STREAMSCAN_ENTRY;
+
+typedef struct
+{
+    long              nbentry;
+    STREAMSCAN_ENTRY *entry;
+} STREAMSCAN;
+
+errno_t streamscan_update(STREAMSCAN *scan,
+                          const char *shmdir,
+                          const char *pattern);
+
+void streamscan_sort(STREAMSCAN *scan, int sortkey);
+
+void streamscan_free(STREAMSCAN *scan);
+
+#endif
@@ -9,6 +9,8 @@
 
 #include "COREMOD_memory/COREMOD_memory.h"
 #include "COREMOD_tools/COREMOD_tools.h"
+#include "imstats.h"
+#include "info_instr.h"
 #include "timediff.h"
 
 // ==========================================
@@ -30,14 +32,12 @@ errno_t info_image_streamtiming_stats(
 
     static int     initflag = 0;
     static double *tdiffvarray;
-    static double *tdiffvarray_sorted;
 
 
     if(initflag == 0)
     {
         initflag    = 1;
         tdiffvarray = (double *) malloc(sizeof(double) * NBsamplesmax);
-        tdiffvarray_sorted = (double *) malloc(sizeof(double) * NBsamplesmax);
     }
 
     // collect timing data
@@ -83,7 +83,12 @@ errno_t info_image_streamtiming_stats(
     while(loopOK == 1)
     {
         //for (long framecnt = 0; framecnt < NBsamplesmax; framecnt++)
-        if(sem_timedwait(image->semptr[sem], &t_timeout))
+        int semret;
+        {
+            INFO_INSTR_SCOPE("streamtiming.semwait");
+            semret = sem_timedwait(image->semptr[sem], &t_timeout);
+        }
+        if(semret)
         {
             return RETURN_FAILURE;
         }
@@ -124,9 +129,7 @@ errno_t info_image_streamtiming_stats(
         }
     }
 
-    memcpy(tdiffvarray_sorted, tdiffvarray,
-           NBsamplesmax * sizeof(*tdiffvarray_sorted));
-    info_image_streamtiming_stats_disp(tdiffvarray_sorted,
+    info_image_streamtiming_stats_disp(tdiffvarray,
                                        framecntbuff,
                                        tdiffvmax,
                                        tdiffcntmax);
@@ -141,15 +144,19 @@ errno_t info_image_streamtiming_stats_disp(
     double  tdiffvmax,
     long    tdiffcntmax)
 {
-    float RMSval = 0.0;
-    float AVEval = 0.0;
+    INFO_INSTR_SCOPE("streamtiming.disp");
+
+    float   RMSval = 0.0;
+    float   AVEval = 0.0;
+    IMSTATS tdiffstats;
 
     static int percMedianIndex;
 
-    static int    initflag = 0;
-    static float *percarray;
-    static long  *percNarray;
-    static int    NBpercbin;
+    static int     initflag = 0;
+    static double *percarray;
+    static long   *percNarray;
+    static double *percval;
+    static int     NBpercbin;
 
     if(initflag == 0)
     {
@@ -159,8 +166,9 @@ errno_t info_image_streamtiming_stats_disp(
         NBpercbin  = 17;
         percMedianIndex = 8;
 
-        percarray  = (float *) malloc(sizeof(float) * NBpercbin);
+        percarray  = (double *) malloc(sizeof(double) * NBpercbin);
         percNarray = (long *) malloc(sizeof(long) * NBpercbin);
+        percval    = (double *) malloc(sizeof(double) * NBpercbin);
 
         percarray[0]  = 0.001;
         percarray[1]  = 0.01;
@@ -192,17 +200,20 @@ errno_t info_image_streamtiming_stats_disp(
 
 
     // process timing data
-    quick_sort_double(tdiffvarray, NBsamples);
-
-    long i;
-    for(i = 0; i < NBsamples; i++)
-    {
-        AVEval += tdiffvarray[i];
-        RMSval += tdiffvarray[i] * tdiffvarray[i];
-    }
-    RMSval = RMSval / NBsamples;
-    AVEval /= NBsamples;
-    RMSval = sqrt(RMSval - AVEval * AVEval);
+    percentile_array(tdiffvarray,
+                     _DATATYPE_DOUBLE,
+                     NBsamples,
+                     NBpercbin,
+                     percarray,
+                     percval);
+    imstats_array(tdiffvarray,
+                  _DATATYPE_DOUBLE,
+                  NBsamples,
+                  1,
+                  NULL,
+                  &tdiffstats);
+    AVEval = tdiffstats.mean;
+    RMSval = tdiffstats.rmsdev;
 
     printw("\n NBsamples = %ld \n\n", NBsamples);
 
@@ -222,23 +233,23 @@ errno_t info_image_streamtiming_stats_disp(
                 100.0 * (1.0 - percarray[percbin]),
                 percNarray[percbin],
                 NBsamples - percNarray[percbin],
-                1.0e6 * tdiffvarray[percNarray[percbin]]);
+                1.0e6 * percval[percbin]);
             attroff(A_BOLD);
         }
         else
         {
-            if(tdiffvarray[percNarray[percbin]] >
-                    1.2 * tdiffvarray[percNarray[percMedianIndex]])
+            if(percval[percbin] >
+                    1.2 * percval[percMedianIndex])
             {
                 attron(A_BOLD | COLOR_PAIR(6));
             }
-            if(tdiffvarray[percNarray[percbin]] >
-                    1.5 * tdiffvarray[percNarray[percMedianIndex]])
+            if(percval[percbin] >
+                    1.5 * percval[percMedianIndex])
             {
                 attron(A_BOLD | COLOR_PAIR(5));
             }
-            if(tdiffvarray[percNarray[percbin]] >
-                    1.99 * tdiffvarray[percNarray[percMedianIndex]])
+            if(percval[percbin] >
+                    1.99 * percval[percMedianIndex])
             {
                 attron(A_BOLD | COLOR_PAIR(4));
             }
@@ -252,9 +263,9 @@ errno_t info_image_streamtiming_stats_disp(
                 100.0 * (1.0 - percarray[percbin]),
                 percNarray[percbin],
                 NBsamples - percNarray[percbin],
-                1.0e6 * tdiffvarray[percNarray[percbin]],
-                1.0e6 * (tdiffvarray[percNarray[percbin]] -
-                         tdiffvarray[percNarray[percMedianIndex]]));
+                1.0e6 * percval[percbin],
+                1.0e6 * (percval[percbin] -
+                         percval[percMedianIndex]));
         }
     }
     attroff(A_BOLD | COLOR_PAIR(4));
@@ -0,0 +1,279 @@
+/**
+ * @file    streamtop.c
+ * @brief   top-like view of all streams of the shared memory directory
+ *
+ * Streams are ranked by frame rate, bandwidth, semaphore backlog or
+ * staleness. Only stream metadata is mapped (streamscan.c), so the view
+ * stays cheap on hosts with many large streams.
+ */
+
+#include <math.h>
+#include <ncurses.h>
+
+#include "CommandLineInterface/CLIcore.h"
+
+#include "info_instr.h"
+#include "streamscan.h"
+
+#include "TUItools.h"
+
+
+
+
+// screen size
+static uint16_t wrow, wcol;
+
+
+// Local variables pointers
+static char    *streampattern;
+static float   *updatefrequency;
+static char    *sortkeystr;
+
+static CLICMDARGDEF farg[] =
+{
+    {
+        CLIARG_STR,
+        ".pattern",
+        "stream name pattern, wildcards allowed",
+        "*",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &streampattern,
+        NULL
+    },
+    {
+        CLIARG_FLOAT32,
+        ".frequ",
+        "frequency [Hz]",
+        "1.0",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &updatefrequency,
+        NULL
+    },
+    {
+        CLIARG_STR,
+        ".sort",
+        "sort key : name, rate, bw, backlog, stale",
+        "rate",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &sortkeystr,
+        NULL
+    }
+};
+
+static CLICMDDATA CLIcmddata =
+{
+    "streamtop", "top-like view of all streams", CLICMD_FIELDS_DEFAULTS
+};
+
+
+
+
+// detailed help
+static errno_t help_function()
+{
+    printf("Streams of the shm directory matching .pattern, refreshed at "
+           ".frequ\n");
+    printf("Only stream metadata is mapped, pixel data is not accessed\n");
+    printf("Keys : n name, r rate, b bandwidth, s semaphore backlog, "
+           "t staleness\n");
+
+    return RETURN_SUCCESS;
+}
+
+
+
+static const char *sortkeyname[] = {"name", "rate", "bw", "backlog", "stale"};
+
+static int streamtop_sortkey(const char *str)
+{
+    for(int k = 0; k < 5; k++)
+    {
+        if(strcmp(str, sortkeyname[k]) == 0)
+        {
+            return k;
+        }
+    }
+    return STREAMSCAN_SORT_FREQU;
+}
+
+static void streamtop_print(STREAMSCAN *scan, int sortkey, int maxrow)
+{
+    double bwtotal = 0.0;
+
+    for(long i = 0; i < scan->nbentry; i++)
+    {
+        if(!isnan(scan->entry[i].bandwidth))
+        {
+            bwtotal += scan->entry[i].bandwidth;
+        }
+    }
+
+    TUI_printfw("%ld streams   total %.3f MB/s   sorted by %s\n",
+                scan->nbentry,
+                1.0e-6 * bwtotal,
+                sortkeyname[sortkey]);
+    TUI_printfw("%-32s %-6s %10s %12s %10s %10s %7s %10s %2s",
+                "stream",
+                "type",
+                "frame[kB]",
+                "cnt0",
+                "rate[Hz]",
+                "MB/s",
+                "backlog",
+                "stale[s]",
+                "w");
+    TUI_newline();
+
+    for(long i = 0; (i < scan->nbentry) && (i < maxrow); i++)
+    {
+        STREAMSCAN_ENTRY *entry = &scan->entry[i];
+        char              backlogstr[16];
+        int               alert = (entry->backlog > 0);
+
+        if(entry->backlog < 0)
+        {
+            snprintf(backlogstr, sizeof(backlogstr), "-");
+        }
+        else
+        {
+            snprintf(backlogstr, sizeof(backlogstr), "%d", entry->backlog);
+        }
+
+        if(alert)
+        {
+            attron(A_BOLD);
+        }
+        TUI_printfw("%-32.32s %-6.6s %10.1f %12lu %10.2f %10.3f %7s %10.3f %2d",
+                    entry->name,
+                    ImageStreamIO_typename(entry->md->datatype),
+                    1.0e-3 * entry->framesize,
+                    entry->cnt0,
+                    entry->frequ,
+                    1.0e-6 * entry->bandwidth,
+                    backlogstr,
+                    entry->stale,
+                    entry->md->write);
+        if(alert)
+        {
+            attroff(A_BOLD);
+        }
+        TUI_newline();
+    }
+    if(scan->nbentry > maxrow)
+    {
+        TUI_printfw("... %ld more\n", scan->nbentry - maxrow);
+    }
+}
+
+
+
+static errno_t compute_function()
+{
+    DEBUG_TRACE_FSTART();
+
+
+    INSERT_TUI_SETUP
+
+    // define screens
+    static int NBTUIscreen = 2;
+
+    TUIscreenarray[0].index = 1;
+    TUIscreenarray[0].keych = 'h';
+    strcpy(TUIscreenarray[0].name, "[h] Help");
+
+    TUIscreenarray[1].index = 2;
+    TUIscreenarray[1].keych = KEY_F(2);
+    strcpy(TUIscreenarray[1].name, "[F2] streams");
+
+    INSERT_STD_PROCINFO_COMPUTEFUNC_INIT
+
+    // loop period from .frequ
+    double tperiod = 1.0 / *updatefrequency;
+    processinfo->triggermode          = PROCESSINFO_TRIGGERMODE_DELAY;
+    processinfo->triggerdelay.tv_sec  = (time_t) tperiod;
+    processinfo->triggerdelay.tv_nsec =
+        (long)((tperiod - (time_t) tperiod) * 1.0e9);
+
+    int        TUIscreen = 2;
+    int        sortkey   = streamtop_sortkey(sortkeystr);
+    STREAMSCAN scan      = {0};
+
+    INSERT_STD_PROCINFO_COMPUTEFUNC_LOOPSTART
+    {
+        INSTERT_TUI_KEYCONTROLS
+
+        switch(TUIinputkch)
+        {
+        case 'n':
+            sortkey = STREAMSCAN_SORT_NAME;
+            break;
+        case 'r':
+            sortkey = STREAMSCAN_SORT_FREQU;
+            break;
+        case 'b':
+            sortkey = STREAMSCAN_SORT_BANDWIDTH;
+            break;
+        case 's':
+            sortkey = STREAMSCAN_SORT_BACKLOG;
+            break;
+        case 't':
+            sortkey = STREAMSCAN_SORT_STALE;
+            break;
+        }
+
+        // streams are sampled even when the display is paused
+        streamscan_update(&scan, data.shmdir, streampattern);
+
+        if(TUIpause == 0)
+        {
+            erase();
+
+            // Check for screen size change
+            TUI_get_terminal_size(&wrow, &wcol);
+
+            INSERT_TUI_SCREEN_MENU
+            TUI_newline();
+
+            if(TUIscreen == 1)
+            {
+                TUI_printfw("h / F2 : change screen\n");
+                TUI_printfw("n / r / b / s / t : sort by name, rate, "
+                            "bandwidth, backlog, staleness\n");
+                TUI_printfw("x : exit\n");
+            }
+
+            if(TUIscreen == 2)
+            {
+                streamscan_sort(&scan, sortkey);
+                streamtop_print(&scan, sortkey, wrow - 6);
+            }
+
+            refresh();
+        }
+    }
+    INSERT_STD_PROCINFO_COMPUTEFUNC_END
+
+    streamscan_free(&scan);
+
+    endwin();
+
+    DEBUG_TRACE_FEXIT();
+    return RETURN_SUCCESS;
+}
+
+
+
+
+INSERT_STD_FPSCLIfunctions
+
+
+
+
+// Register function in CLI
+errno_t
+CLIADDCMD_info__streamtop()
+{
+    INSERT_STD_CLIREGISTERFUNC
+
+    return RETURN_SUCCESS;
+}
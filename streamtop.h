@@ -0,0 +1,10 @@
+/**
+ * @file    streamtop.h
+ */
+
+#ifndef _INFO_STREAMTOP_H
+#define _INFO_STREAMTOP_H
+
+errno_t CLIADDCMD_info__streamtop();
+
+#endif
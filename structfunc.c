@@ -0,0 +1,647 @@
+/**
+ * @file    structfunc.c
+ * @brief   spatial structure function, computed by FFT
+ *
+ * D(dx,dy) = < [f(x+dx,y+dy) - f(x,y)]^2 >, averaged over all pixel pairs
+ * within the mask.
+ *
+ * With mask w, g = w f and g2 = w f^2, the sum over pairs is :
+ *     sum w(x)w(x+r) [f(x) - f(x+r)]^2
+ *         = corr(g2,w)(r) + corr(w,g2)(r) - 2 corr(g,g)(r)
+ * and the number of pairs is corr(w,w)(r). Correlations are computed with
+ * FFTs of arrays zero-padded to twice the input size, so the cost is
+ * O(N log N) instead of O(N^2) for a direct sum over pairs.
+ * Without mask, this is D(r) = 2 [C(0) - C(r)] with edge-corrected
+ * correlations.
+ *
+ * The masked mean is subtracted before the FFTs to limit round-off.
+ *
+ * Output 2D image has size 2 xsize x 2 ysize, lag (0,0) is at pixel
+ * (xsize, ysize). Lags without any pixel pair are set to 0.
+ * Radial average is weighted by number of pairs, with bins of width 1 pix
+ * centered on integer lag distances.
+ *
+ * Mask spectrum and FFTW plans are computed once per geometry and cached.
+ */
+
+#include <math.h>
+
+#include "CommandLineInterface/CLIcore.h"
+
+#include "COREMOD_memory/COREMOD_memory.h"
+
+#include "info_instr.h"
+#include "info_pool.h"
+#include "info_scratch.h"
+#include "structfunc.h"
+
+// number of geometries kept in cache
+#define STRUCTFUNC_PLAN_CACHESIZE 2
+
+// minimum number of FFT array elements per thread
+#define STRUCTFUNC_NBPIX_THREAD 65536
+
+static STRUCTFUNC_PLAN sfplancache[STRUCTFUNC_PLAN_CACHESIZE];
+static int             sfplancache_next = 0;
+
+// Local variables pointers
+static char *instreamname;
+static char *outstreamname;
+static char *maskname;
+
+static CLICMDARGDEF farg[] =
+{
+    {
+        CLIARG_IMG,
+        ".insname",
+        "input stream",
+        "im1",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &instreamname,
+        NULL
+    },
+    {
+        CLIARG_STR,
+        ".outsname",
+        "output 2D structure function",
+        "im1sf",
+        CLIARG_VISIBLE_DEFAULT,
+        (void **) &outstreamname,
+        NULL
+    },
+    {
+        CLIARG_STR,
+        ".maskname",
+        "mask image, pixels > 0.5 included",
+        "none",
+        CLIARG_HIDDEN_DEFAULT,
+        (void **) &maskname,
+        NULL
+    }
+};
+
+static CLICMDDATA CLIcmddata =
+{
+    "imstructfunc", "structure function of image stream", CLICMD_FIELDS_DEFAULTS
+};
+
+// detailed help
+static errno_t help_function()
+{
+    printf("Spatial structure function of each new frame, computed by FFT\n");
+    printf("Output : <outsname> 2D, lag (0,0) at pixel (xsize, ysize)\n");
+    printf("         <outsname>rad radial average, 1 pix bins\n");
+
+    return RETURN_SUCCESS;
+}
+
+static void structfunc_plan_free(STRUCTFUNC_PLAN *sfplan)
+{
+    if(sfplan->g != NULL)
+    {
+        fftw_destroy_plan(sfplan->planfwd);
+        fftw_destroy_plan(sfplan->planbwd);
+    }
+    free(sfplan->wmask);
+    fftw_free(sfplan->g);
+    fftw_free(sfplan->g2);
+    fftw_free(sfplan->corr);
+    fftw_free(sfplan->W);
+    fftw_free(sfplan->G);
+    fftw_free(sfplan->G2);
+    fftw_free(sfplan->npair);
+    free(sfplan->lagbin);
+
+    sfplan->wmask  = NULL;
+    sfplan->g      = NULL;
+    sfplan->g2     = NULL;
+    sfplan->corr   = NULL;
+    sfplan->W      = NULL;
+    sfplan->G      = NULL;
+    sfplan->G2     = NULL;
+    sfplan->npair  = NULL;
+    sfplan->lagbin = NULL;
+    sfplan->xsize  = 0;
+    sfplan->ysize  = 0;
+}
+
+// mask spectrum and pair counts, recomputed when mask changes
+static void structfunc_plan_setmask(STRUCTFUNC_PLAN *sfplan, IMAGE *maskimage)
+{
+    uint32_t xsize  = sfplan->xsize;
+    uint32_t ysize  = sfplan->ysize;
+    uint32_t fxsize = sfplan->fxsize;
+    uint64_t fsize  = (uint64_t) fxsize * sfplan->fysize;
+    uint64_t csize  = (uint64_t) sfplan->fysize * (fxsize / 2 + 1);
+
+    sfplan->maskimage = maskimage;
+    sfplan->maskcnt0  = (maskimage == NULL) ? 0 : maskimage->md[0].cnt0;
+
+    sfplan->wsum = 0.0;
+    memset(sfplan->g, 0, sizeof(double) * fsize);
+    for(uint32_t jj = 0; jj < ysize; jj++)
+        for(uint32_t ii = 0; ii < xsize; ii++)
+        {
+            uint64_t pix = (uint64_t) jj * xsize + ii;
+            double   w   = 1.0;
+            if(maskimage != NULL)
+            {
+                w = (maskimage->array.F[pix] > 0.5) ? 1.0 : 0.0;
+            }
+            sfplan->wmask[pix]                     = w;
+            sfplan->g[(uint64_t) jj * fxsize + ii] = w;
+            sfplan->wsum += w;
+        }
+
+    fftw_execute_dft_r2c(sfplan->planfwd, sfplan->g, sfplan->W);
+
+    // pair count = corr(w,w) = IFFT |W|^2
+    for(uint64_t k = 0; k < csize; k++)
+    {
+        sfplan->G[k][0] = sfplan->W[k][0] * sfplan->W[k][0] +
+                          sfplan->W[k][1] * sfplan->W[k][1];
+        sfplan->G[k][1] = 0.0;
+    }
+    fftw_execute_dft_c2r(sfplan->planbwd, sfplan->G, sfplan->npair);
+
+    // padding stays zero, only the valid region is written per frame
+    memset(sfplan->g, 0, sizeof(double) * fsize);
+    memset(sfplan->g2, 0, sizeof(double) * fsize);
+}
+
+static void structfunc_plan_build(STRUCTFUNC_PLAN *sfplan,
+                                  uint32_t         xsize,
+                                  uint32_t         ysize,
+                                  IMAGE           *maskimage)
+{
+    structfunc_plan_free(sfplan);
+
+    sfplan->xsize  = xsize;
+    sfplan->ysize  = ysize;
+    sfplan->fxsize = 2 * xsize;
+    sfplan->fysize = 2 * ysize;
+
+    uint32_t fxsize = sfplan->fxsize;
+    uint32_t fysize = sfplan->fysize;
+    uint64_t fsize  = (uint64_t) fxsize * fysize;
+    uint64_t csize  = (uint64_t) fysize * (fxsize / 2 + 1);
+
+    sfplan->wmask  = (double *) malloc(sizeof(double) * xsize * ysize);
+    sfplan->g      = (double *) fftw_malloc(sizeof(double) * fsize);
+    sfplan->g2     = (double *) fftw_malloc(sizeof(double) * fsize);
+    sfplan->corr   = (double *) fftw_malloc(sizeof(double) * fsize);
+    sfplan->W      = (fftw_complex *) fftw_malloc(sizeof(fftw_complex) * csize);
+    sfplan->G      = (fftw_complex *) fftw_malloc(sizeof(fftw_complex) * csize);
+    sfplan->G2     = (fftw_complex *) fftw_malloc(sizeof(fftw_complex) * csize);
+    sfplan->npair  = (double *) fftw_malloc(sizeof(double) * fsize);
+    sfplan->lagbin = (int32_t *) malloc(sizeof(int32_t) * fsize);
+    if((sfplan->wmask == NULL) || (sfplan->g == NULL) ||
+            (sfplan->g2 == NULL) || (sfplan->corr == NULL) ||
+            (sfplan->W == NULL) || (sfplan->G == NULL) ||
+            (sfplan->G2 == NULL) || (sfplan->npair == NULL) ||
+            (sfplan->lagbin == NULL))
+    {
+        PRINT_ERROR("malloc returns NULL pointer");
+        abort();
+    }
+
+    // planning overwrites arrays, so it is done before they are filled
+    // all other arrays have same alignment, as allocated by fftw_malloc
+    sfplan->planfwd = fftw_plan_dft_r2c_2d(fysize,
+                                           fxsize,
+                                           sfplan->g,
+                                           sfplan->G,
+                                           FFTW_MEASURE);
+    sfplan->planbwd = fftw_plan_dft_c2r_2d(fysize,
+                                           fxsize,
+                                           sfplan->G,
+                                           sfplan->corr,
+                                           FFTW_MEASURE);
+
+    // radial bin of each lag, in FFT order
+    double rmax   = sqrt((double)(xsize - 1) * (xsize - 1) +
+                         (double)(ysize - 1) * (ysize - 1));
+    sfplan->nrbin = (uint32_t)(rmax + 0.5) + 1;
+    for(uint32_t jj = 0; jj < fysize; jj++)
+    {
+        long dy = (jj < ysize) ? (long) jj : (long) jj - fysize;
+        for(uint32_t ii = 0; ii < fxsize; ii++)
+        {
+            long dx = (ii < xsize) ? (long) ii : (long) ii - fxsize;
+
+            sfplan->lagbin[(uint64_t) jj * fxsize + ii] =
+                (int32_t)(sqrt((double)(dx * dx + dy * dy)) + 0.5);
+        }
+    }
+
+    structfunc_plan_setmask(sfplan, maskimage);
+}
+
+/**
+ * @brief Get structure function workspace for geometry, building it if needed
+ *
+ * maskimage is a float image of same size as the input image, pixels > 0.5
+ * are included. Use NULL for no mask. Returns NULL if the mask type or size
+ * does not match.
+ * FFTW plans are kept when only the mask changes.
+ */
+STRUCTFUNC_PLAN *structfunc_plan_get(uint32_t xsize,
+                                     uint32_t ysize,
+                                     IMAGE   *maskimage)
+{
+    STRUCTFUNC_PLAN *sfplan;
+
+    if((maskimage != NULL) &&
+            ((maskimage->md[0].datatype != _DATATYPE_FLOAT) ||
+             (maskimage->md[0].nelement != (uint64_t) xsize * ysize)))
+    {
+        PRINT_ERROR("mask %s : float image of %ux%u pixels required",
+                    maskimage->name,
+                    xsize,
+                    ysize);
+        return NULL;
+    }
+
+    for(int c = 0; c < STRUCTFUNC_PLAN_CACHESIZE; c++)
+    {
+        sfplan = &sfplancache[c];
+        if((sfplan->g != NULL) && (sfplan->xsize == xsize) &&
+                (sfplan->ysize == ysize))
+        {
+            if((sfplan->maskimage != maskimage) ||
+                    ((maskimage != NULL) &&
+                     (sfplan->maskcnt0 != maskimage->md[0].cnt0)))
+            {
+                structfunc_plan_setmask(sfplan, maskimage);
+            }
+            return sfplan;
+        }
+    }
+
+    sfplan           = &sfplancache[sfplancache_next];
+    sfplancache_next = (sfplancache_next + 1) % STRUCTFUNC_PLAN_CACHESIZE;
+
+    structfunc_plan_build(sfplan, xsize, ysize, maskimage);
+
+    return sfplan;
+}
+
+#define STRUCTFUNC_LOAD(arrayptr)                                              \
+    do                                                                         \
+    {                                                                          \
+        for(uint32_t jj = 0; jj < ysize; jj++)                                 \
+            for(uint32_t ii = 0; ii < xsize; ii++)                             \
+            {                                                                  \
+                uint64_t pix = (uint64_t) jj * xsize + ii;                     \
+                double   v = wmask[pix] * (double) (arrayptr)[pix];            \
+                g[(uint64_t) jj * fxsize + ii] = v;                            \
+                sumwf += v;                                                    \
+            }                                                                  \
+    } while(0)
+
+typedef struct
+{
+    STRUCTFUNC_PLAN *sfplan;
+    double           mean;
+    float           *sfarray;
+} STRUCTFUNC_JOB;
+
+// subtract masked mean, w^2 = w so g2 = g^2
+static void structfunc_center_task(void *arg, int task, int nbtask)
+{
+    STRUCTFUNC_JOB  *job    = (STRUCTFUNC_JOB *) arg;
+    STRUCTFUNC_PLAN *sfplan = job->sfplan;
+    uint32_t         xsize  = sfplan->xsize;
+    uint64_t         jjstart;
+    uint64_t         jjend;
+
+    info_pool_range(sfplan->ysize, task, nbtask, &jjstart, &jjend);
+    for(uint32_t jj = jjstart; jj < jjend; jj++)
+        for(uint32_t ii = 0; ii < xsize; ii++)
+        {
+            uint64_t fpix = (uint64_t) jj * sfplan->fxsize + ii;
+            double   v    = sfplan->g[fpix] -
+                            sfplan->wmask[(uint64_t) jj * xsize + ii] * job->mean;
+            sfplan->g[fpix]  = v;
+            sfplan->g2[fpix] = v * v;
+        }
+}
+
+// 2 Re(conj(G2) W) - 2 |G|^2, real
+static void structfunc_spectrum_task(void *arg, int task, int nbtask)
+{
+    STRUCTFUNC_JOB  *job    = (STRUCTFUNC_JOB *) arg;
+    STRUCTFUNC_PLAN *sfplan = job->sfplan;
+    fftw_complex    *W      = sfplan->W;
+    fftw_complex    *G      = sfplan->G;
+    fftw_complex    *G2     = sfplan->G2;
+    uint64_t         kstart;
+    uint64_t         kend;
+
+    info_pool_range((uint64_t) sfplan->fysize * (sfplan->fxsize / 2 + 1),
+                    task,
+                    nbtask,
+                    &kstart,
+                    &kend);
+    for(uint64_t k = kstart; k < kend; k++)
+    {
+        double s = 2.0 * (G2[k][0] * W[k][0] + G2[k][1] * W[k][1]) -
+                   2.0 * (G[k][0] * G[k][0] + G[k][1] * G[k][1]);
+        G[k][0] = s;
+        G[k][1] = 0.0;
+    }
+}
+
+// both corr and npair carry the same fsize normalization factor
+static void structfunc_output_task(void *arg, int task, int nbtask)
+{
+    STRUCTFUNC_JOB  *job      = (STRUCTFUNC_JOB *) arg;
+    STRUCTFUNC_PLAN *sfplan   = job->sfplan;
+    uint32_t         fxsize   = sfplan->fxsize;
+    uint32_t         fysize   = sfplan->fysize;
+    double          *corr     = sfplan->corr;
+    double          *npair    = sfplan->npair;
+    double           npairmin = 0.5 * (double) fxsize * fysize;
+    uint64_t         jjstart;
+    uint64_t         jjend;
+
+    info_pool_range(fysize, task, nbtask, &jjstart, &jjend);
+    for(uint32_t jj = jjstart; jj < jjend; jj++)
+    {
+        // FFT order to lag (0,0) at (xsize, ysize)
+        uint32_t jjout = (jj + sfplan->ysize) % fysize;
+        for(uint32_t ii = 0; ii < fxsize; ii++)
+        {
+            uint64_t k     = (uint64_t) jj * fxsize + ii;
+            uint32_t iiout = (ii + sfplan->xsize) % fxsize;
+            float    v     = 0.0;
+            if(npair[k] > npairmin)
+            {
+                v = (float)(corr[k] / npair[k]);
+            }
+            job->sfarray[(uint64_t) jjout * fxsize + iiout] = v;
+        }
+    }
+}
+
+/**
+ * @brief Compute structure function of image
+ *
+ * sfarray (2 xsize x 2 ysize) and sfradarray (nrbin) may be NULL if not
+ * needed.
+ */
+errno_t structfunc_compute(STRUCTFUNC_PLAN *sfplan,
+                           IMAGE           *image,
+                           float           *sfarray,
+                           float           *sfradarray)
+{
+    INFO_INSTR_SCOPE("structfunc_compute");
+
+    uint32_t xsize  = sfplan->xsize;
+    uint32_t ysize  = sfplan->ysize;
+    uint32_t fxsize = sfplan->fxsize;
+    uint32_t fysize = sfplan->fysize;
+    uint64_t fsize  = (uint64_t) fxsize * fysize;
+    double  *wmask  = sfplan->wmask;
+    double  *g      = sfplan->g;
+    double  *g2     = sfplan->g2;
+    double   sumwf  = 0.0;
+
+    if(image->md[0].nelement < (uint64_t) xsize * ysize)
+    {
+        PRINT_ERROR("image %s smaller than structure function geometry",
+                    image->name);
+        return RETURN_FAILURE;
+    }
+
+    switch(image->md[0].datatype)
+    {
+        case _DATATYPE_FLOAT:
+            STRUCTFUNC_LOAD(image->array.F);
+            break;
+        case _DATATYPE_DOUBLE:
+            STRUCTFUNC_LOAD(image->array.D);
+            break;
+        case _DATATYPE_UINT8:
+            STRUCTFUNC_LOAD(image->array.UI8);
+            break;
+        case _DATATYPE_INT8:
+            STRUCTFUNC_LOAD(image->array.SI8);
+            break;
+        case _DATATYPE_UINT16:
+            STRUCTFUNC_LOAD(image->array.UI16);
+            break;
+        case _DATATYPE_INT16:
+            STRUCTFUNC_LOAD(image->array.SI16);
+            break;
+        case _DATATYPE_UINT32:
+            STRUCTFUNC_LOAD(image->array.UI32);
+            break;
+        case _DATATYPE_INT32:
+            STRUCTFUNC_LOAD(image->array.SI32);
+            break;
+        case _DATATYPE_UINT64:
+            STRUCTFUNC_LOAD(image->array.UI64);
+            break;
+        case _DATATYPE_INT64:
+            STRUCTFUNC_LOAD(image->array.SI64);
+            break;
+        default:
+            PRINT_ERROR("datatype not supported");
+            return RETURN_FAILURE;
+    }
+
+    STRUCTFUNC_JOB job;
+    int            nbtask = info_pool_nbtask(fsize, STRUCTFUNC_NBPIX_THREAD);
+
+    job.sfplan  = sfplan;
+    job.mean    = (sfplan->wsum > 0.0) ? sumwf / sfplan->wsum : 0.0;
+    job.sfarray = sfarray;
+
+    info_pool_run(nbtask, structfunc_center_task, &job);
+
+    fftw_execute_dft_r2c(sfplan->planfwd, g, sfplan->G);
+    fftw_execute_dft_r2c(sfplan->planfwd, g2, sfplan->G2);
+
+    info_pool_run(nbtask, structfunc_spectrum_task, &job);
+
+    fftw_execute_dft_c2r(sfplan->planbwd, sfplan->G, sfplan->corr);
+
+    double *corr     = sfplan->corr;
+    double *npair    = sfplan->npair;
+    double  npairmin = 0.5 * (double) fsize;
+
+    if(sfarray != NULL)
+    {
+        info_pool_run(nbtask, structfunc_output_task, &job);
+    }
+
+    if(sfradarray != NULL)
+    {
+        uint32_t nrbin       = sfplan->nrbin;
+        size_t   scratchmark = info_scratch_mark();
+        double  *radnum =
+            (double *) info_scratch_calloc(2 * nrbin, sizeof(double));
+        double *radnpair = radnum + nrbin;
+
+        for(uint64_t k = 0; k < fsize; k++)
+        {
+            if(npair[k] > npairmin)
+            {
+                radnum[sfplan->lagbin[k]] += corr[k];
+                radnpair[sfplan->lagbin[k]] += npair[k];
+            }
+        }
+        for(uint32_t r = 0; r < nrbin; r++)
+        {
+            sfradarray[r] =
+                (radnpair[r] > 0.0) ? (float)(radnum[r] / radnpair[r]) : 0.0;
+        }
+        info_scratch_release(scratchmark);
+    }
+
+    return RETURN_SUCCESS;
+}
+
+/**
+ * @brief Structure function of image
+ *
+ * Creates 2D image ID_out, and its radial average <ID_out>rad.
+ * IDmask_name may be NULL or a non-existing image for no mask.
+ */
+imageID full_structure_function(const char *ID_name,
+                                const char *IDmask_name,
+                                const char *ID_out)
+{
+    DEBUG_TRACE_FSTART();
+
+    imageID ID = image_ID(ID_name);
+    if(ID == -1)
+    {
+        PRINT_ERROR("image %s not found", ID_name);
+        DEBUG_TRACE_FEXIT();
+        return -1;
+    }
+
+    IMAGE *maskimage = NULL;
+    if(IDmask_name != NULL)
+    {
+        imageID IDmask = image_ID(IDmask_name);
+        if(IDmask != -1)
+        {
+            maskimage = &data.image[IDmask];
+        }
+    }
+
+    uint32_t ysize = (data.image[ID].md[0].naxis < 2)
+                     ? 1 : data.image[ID].md[0].size[1];
+    STRUCTFUNC_PLAN *sfplan =
+        structfunc_plan_get(data.image[ID].md[0].size[0], ysize, maskimage);
+    if(sfplan == NULL)
+    {
+        DEBUG_TRACE_FEXIT();
+        return -1;
+    }
+
+    imageID IDout;
+    FUNC_CHECK_RETURN(create_2Dimage_ID(ID_out,
+                                        sfplan->fxsize,
+                                        sfplan->fysize,
+                                        &IDout));
+
+    char    radname[STRINGMAXLEN_IMGNAME];
+    imageID IDrad;
+    WRITE_IMAGENAME(radname, "%srad", ID_out);
+    FUNC_CHECK_RETURN(create_2Dimage_ID(radname, sfplan->nrbin, 1, &IDrad));
+
+    FUNC_CHECK_RETURN(structfunc_compute(sfplan,
+                                         &data.image[ID],
+                                         data.image[IDout].array.F,
+                                         data.image[IDrad].array.F));
+
+    DEBUG_TRACE_FEXIT();
+    return IDout;
+}
+
+static errno_t compute_function()
+{
+    DEBUG_TRACE_FSTART();
+
+    imageID ID = image_ID(instreamname);
+
+    IMAGE  *maskimage = NULL;
+    imageID IDmask    = image_ID(maskname);
+    if(IDmask != -1)
+    {
+        // mask is read per pixel : float image of stream size required
+        if((data.image[IDmask].md[0].datatype == _DATATYPE_FLOAT) &&
+                (data.image[IDmask].md[0].nelement ==
+                 data.image[ID].md[0].nelement))
+        {
+            maskimage = &data.image[IDmask];
+        }
+        else
+        {
+            PRINT_WARNING("mask %s : float image of stream size required, "
+                          "ignored",
+                          maskname);
+        }
+    }
+
+    uint32_t xsize = data.image[ID].md[0].size[0];
+    uint32_t ysize = (data.image[ID].md[0].naxis < 2)
+                     ? 1 : data.image[ID].md[0].size[1];
+
+    // plans are built before the loop, FFTW_MEASURE may take a while
+    STRUCTFUNC_PLAN *sfplan = structfunc_plan_get(xsize, ysize, maskimage);
+
+    imageID  IDout;
+    uint32_t sizeout[2];
+    sizeout[0] = sfplan->fxsize;
+    sizeout[1] = sfplan->fysize;
+    create_image_ID(outstreamname,
+                    2,
+                    sizeout,
+                    _DATATYPE_FLOAT,
+                    1,
+                    0,
+                    0,
+                    &IDout);
+
+    imageID IDrad;
+    char    radname[STRINGMAXLEN_IMGNAME];
+    WRITE_IMAGENAME(radname, "%srad", outstreamname);
+    sizeout[0] = sfplan->nrbin;
+    sizeout[1] = 1;
+    create_image_ID(radname, 2, sizeout, _DATATYPE_FLOAT, 1, 0, 0, &IDrad);
+
+    INSERT_STD_PROCINFO_COMPUTEFUNC_INIT
+
+    INSERT_STD_PROCINFO_COMPUTEFUNC_LOOPSTART
+    {
+        sfplan = structfunc_plan_get(xsize, ysize, maskimage);
+
+        data.image[IDout].md[0].write = 1;
+        data.image[IDrad].md[0].write = 1;
+        structfunc_compute(sfplan,
+                           &data.image[ID],
+                           data.image[IDout].array.F,
+                           data.image[IDrad].array.F);
+        processinfo_update_output_stream(processinfo, IDout);
+        processinfo_update_output_stream(processinfo, IDrad);
+    }
+    INSERT_STD_PROCINFO_COMPUTEFUNC_END
+
+    DEBUG_TRACE_FEXIT();
+    return RETURN_SUCCESS;
+}
+
+INSERT_STD_FPSCLIfunctions
+
+// Register function in CLI
+errno_t CLIADDCMD_info__structfunc()
+{
+    INSERT_STD_CLIREGISTERFUNC
+
+    return RETURN_SUCCESS;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file    structfunc.h
+ */
+
+#ifndef _INFO_STRUCTFUNC_H
+#define _INFO_STRUCTFUNC_H
+
+#include <fftw3.h>
+
+// FFT structure function workspace
+// Arrays are zero-padded to twice the input size so that correlations do
+// not wrap around
+typedef struct
+{
+    uint32_t xsize;
+    uint32_t ysize;
+    uint32_t fxsize; // padded size
+    uint32_t fysize;
+
+    IMAGE   *maskimage; // NULL if no mask
+    uint64_t maskcnt0;
+
+    double       *wmask;  // [xsize * ysize] mask, 0 or 1
+    double        wsum;   // number of valid pixels
+    double       *g;      // [fxsize * fysize] mask * image
+    double       *g2;     // [fxsize * fysize] mask * image^2
+    double       *corr;   // [fxsize * fysize] inverse FFT output
+    fftw_complex *W;      // mask spectrum
+    fftw_complex *G;      // spectrum of g
+    fftw_complex *G2;     // spectrum of g2
+    double       *npair;  // [fxsize * fysize] pixel pairs per lag, times
+                          // fxsize * fysize (FFTW normalization)
+    fftw_plan     planfwd;
+    fftw_plan     planbwd;
+
+    // radial average
+    uint32_t  nrbin;
+    int32_t  *lagbin; // [fxsize * fysize] radial bin of lag, -1 if none
+} STRUCTFUNC_PLAN;
+
+STRUCTFUNC_PLAN *structfunc_plan_get(uint32_t xsize,
+                                     uint32_t ysize,
+                                     IMAGE   *maskimage);
+
+errno_t structfunc_compute(STRUCTFUNC_PLAN *sfplan,
+                           IMAGE           *image,
+                           float           *sfarray,
+                           float           *sfradarray);
+
+imageID full_structure_function(const char *ID_name,
+                                const char *IDmask_name,
+                                const char *ID_out);
+
+errno_t CLIADDCMD_info__structfunc();
+
+#endif
@@ -0,0 +1,71 @@
+/**
+ * @file    threadpool.c
+ * @brief   worker thread pool configuration
+ *
+ * The pool is created when the module is loaded, from environment
+ * variables INFO_NBTHREAD and INFO_CPUSET (see info_pool.c). This command
+ * replaces it at runtime, for example to move workers away from cores
+ * assigned to real-time loops.
+ */
+
+#include "CommandLineInterface/CLIcore.h"
+
+#include "info_pool.h"
+#include "threadpool.h"
+
+// ==========================================
+// Command line interface wrapper function(s)
+// ==========================================
+
+static errno_t info_threadpool_set_cli()
+{
+    if(CLI_checkarg(1, CLIARG_INT64) + CLI_checkarg(2, CLIARG_STR_NOT_IMG) ==
+            0)
+    {
+        info_threadpool_set(data.cmdargtoken[1].val.numl,
+                            data.cmdargtoken[2].val.string);
+        return CLICMD_SUCCESS;
+    }
+    else
+    {
+        return CLICMD_INVALID_ARG;
+    }
+}
+
+// ==========================================
+// Register CLI command(s)
+// ==========================================
+
+errno_t threadpool_addCLIcmd()
+{
+    RegisterCLIcommand(
+        "threadpool",
+        __FILE__,
+        info_threadpool_set_cli,
+        "set number of threads and CPU list of info worker pool",
+        "<nbthread, 0 for all CPUs> <CPU list, \"all\" for default>",
+        "threadpool 4 2-5",
+        "errno_t info_threadpool_set(long nbthread, const char *cpulist)");
+
+    return RETURN_SUCCESS;
+}
+
+/**
+ * @brief Replace worker pool
+ *
+ * nbthread counts the calling thread, 1 to disable worker threads.
+ * cpulist "all" restores default placement.
+ */
+errno_t info_threadpool_set(long nbthread, const char *cpulist)
+{
+    if(strcmp(cpulist, "all") == 0)
+    {
+        cpulist = "";
+    }
+
+    FUNC_CHECK_RETURN(info_pool_init((int) nbthread, cpulist));
+
+    printf("info worker pool : %d thread(s)\n", info_pool_nbthread());
+
+    return RETURN_SUCCESS;
+}
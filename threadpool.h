@@ -0,0 +1,12 @@
+/**
+ * @file    threadpool.h
+ */
+
+#ifndef _INFO_THREADPOOL_H
+#define _INFO_THREADPOOL_H
+
+errno_t info_threadpool_set(long nbthread, const char *cpulist);
+
+errno_t threadpool_addCLIcmd();
+
+#endif